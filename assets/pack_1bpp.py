@@ -0,0 +1,37 @@
+import os
+import struct
+import sys
+
+# Packs the glyph sheet of an 8 bit Codehead bitmap font (.bff) into one bit per pixel, rows top
+# to bottom and the most significant bit first, for embedding in the library.
+
+if __name__ == '__main__':
+    if len(sys.argv) < 3:
+        print('USAGE: {} <font.bff> <output.1bpp>'.format(sys.argv[0]))
+        sys.exit(1)
+
+    with open(sys.argv[1], 'rb') as file:
+        data = file.read()
+
+    if data[0:2] != b'\xbf\xf2':
+        print('{} is not a bitmap font file'.format(sys.argv[1]))
+        sys.exit(1)
+
+    width, height, cell_width, cell_height = struct.unpack('<IIII', data[2:18])
+    bits_per_pixel = data[18]
+    if bits_per_pixel != 8:
+        print('Only 8 bit fonts are supported, not {}'.format(bits_per_pixel))
+        sys.exit(1)
+
+    # Header, first character and a width for each of the 256 characters.
+    pixels = data[20 + 256:]
+
+    packed = bytearray((width * height + 7) // 8)
+    for index in range(width * height):
+        if pixels[index] >= 0x80:
+            packed[index // 8] |= 0x80 >> (index % 8)
+
+    with open(sys.argv[2], 'wb') as file:
+        file.write(packed)
+
+    print('{}x{} pixels packed into {} bytes'.format(width, height, len(packed)))
@@ -0,0 +1,19 @@
+set(_EMBED_FILE_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/EmbedFile.cmake)
+
+# Embed the binary file `asset` in the library as `const U8 <symbol>[]` and
+# `const MemSize <symbol>Size` in the `ca` namespace.  The source defining them is generated at
+# build time, whenever the asset changes, and appended to the list named by `out_sources`.
+function(embed_asset out_sources symbol asset)
+    set(input ${CMAKE_CURRENT_SOURCE_DIR}/${asset})
+    set(output ${CMAKE_CURRENT_BINARY_DIR}/embedded/${symbol}.cpp)
+
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND ${CMAKE_COMMAND} -DINPUT=${input} -DOUTPUT=${output} -DSYMBOL=${symbol}
+                -P ${_EMBED_FILE_SCRIPT}
+        DEPENDS ${input} ${_EMBED_FILE_SCRIPT}
+        COMMENT "Embedding ${asset}"
+        VERBATIM)
+
+    set(${out_sources} ${${out_sources}} ${output} PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,30 @@
+# Writes a source file defining the bytes of INPUT as SYMBOL, see embed_asset().
+
+file(READ ${INPUT} hex HEX)
+file(SIZE ${INPUT} size)
+
+# 16 bytes to a line.
+string(LENGTH "${hex}" length)
+set(lines "")
+set(offset 0)
+while (offset LESS length)
+    string(SUBSTRING "${hex}" ${offset} 32 chunk)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " chunk "${chunk}")
+    string(STRIP "${chunk}" chunk)
+    string(APPEND lines "    ${chunk}\n")
+    math(EXPR offset "${offset} + 32")
+endwhile ()
+
+file(WRITE ${OUTPUT}
+    "// Generated from ${INPUT}, do not edit.\n"
+    "\n"
+    "#include \"canvas/static_data/all.h\"\n"
+    "\n"
+    "namespace ca {\n"
+    "\n"
+    "const U8 ${SYMBOL}[] = {\n"
+    "${lines}"
+    "};\n"
+    "const MemSize ${SYMBOL}Size = ${size};\n"
+    "\n"
+    "}  // namespace ca\n")
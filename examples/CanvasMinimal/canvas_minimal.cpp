@@ -154,8 +154,14 @@ private:
       return false;
     }
 
-    texture_id_ = renderer->create_texture(ca::TextureFormat::Alpha, fl::Size{256, 128},
-                                           ca::monoFont, ca::monoFontSize);
+    nu::DynamicArray<U8> pixels;
+    pixels.resize(static_cast<MemSize>(ca::kMonoFontWidth) * ca::kMonoFontHeight);
+    ca::expandMonochrome(ca::monoFontBits, ca::kMonoFontWidth, ca::kMonoFontHeight,
+                         pixels.data());
+
+    texture_id_ = renderer->create_texture(ca::TextureFormat::Alpha,
+                                           fl::Size{ca::kMonoFontWidth, ca::kMonoFontHeight},
+                                           pixels.data(), pixels.size());
 
     return isValid(texture_id_);
   }
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "canvas/renderer/frame_allocator.h"
 #include "canvas/renderer/types.h"
 #include "canvas/renderer/uniform_buffer.h"
+#include "canvas/text/text_layout.h"
 #include "floats/mat4.h"
 #include "floats/pos.h"
 #include "nucleus/macros.h"
@@ -19,15 +21,47 @@ public:
 
   bool initialize();
 
+  // Take layouts from `cache`, which must outlive the font, so unchanged text is not laid out
+  // again every frame.
+  void setLayoutCache(TextLayoutCache* cache) {
+    m_layoutCache = cache;
+  }
+
+  // Adds the text's glyph quads to this frame's.  Nothing is drawn until `render`, which has to
+  // happen by the end of the next renderer frame, since the quads live in its frame allocator.
   void drawText(const fl::Mat4& transform, const fl::Pos& position, nu::StringView text);
 
+  // Upload all the text for this frame and draw it, with one draw for each run of text with the
+  // same transform.
+  void render();
+
 private:
+  struct Vertex {
+    F32 x;
+    F32 y;
+    F32 u;
+    F32 v;
+  };
+
+  struct Batch {
+    fl::Mat4 transform;
+    U32 firstVertex;
+    U32 vertexCount;
+  };
+
   Renderer* m_renderer;
 
+  LayoutFont m_layoutFont;
+  TextLayoutCache* m_layoutCache = nullptr;
+  TextLayout m_scratchLayout;
+
   VertexBufferId m_vertexBufferId;
   TextureId m_textureId;
   ProgramId m_programId;
   UniformId m_transformUniformId;
+
+  FrameArray<Vertex> m_vertices;
+  FrameArray<Batch> m_batches;
 };
 
 }  // namespace ca
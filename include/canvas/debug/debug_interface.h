@@ -4,6 +4,10 @@
 #include <nucleus/profiling.h>
 
 #include "canvas/debug/debug_font.h"
+#include "canvas/debug/frame_graph.h"
+#include "canvas/debug/frame_stats.h"
+#include "canvas/debug/profile_printer.h"
+#include "canvas/text/text_layout.h"
 #include "nucleus/macros.h"
 
 namespace ca {
@@ -20,15 +24,40 @@ public:
 
   auto resize(fl::Size size) -> void;
 
-  auto render(F64 fps) -> void;
+  auto isProfilerVisible() const -> bool {
+    return m_profilerVisible;
+  }
 
-private:
-  auto drawProfileBlock(nu::detail::ProfileMetrics::Block* block, const fl::Pos& position,
-                        const fl::Mat4& transform, I32 indent = 0) -> I32;
+  auto setProfilerVisible(bool visible) -> void {
+    m_profilerVisible = visible;
+  }
+
+  // Add the profile block tree of a finished frame to the profiler's history.  Does nothing while
+  // the profiler is hidden.
+  auto recordProfile(nu::detail::ProfileMetrics::Block* root,
+                     const nu::DynamicArray<GpuScopeTiming>& gpuTimings) -> void;
+
+  // Draws the FPS of the last frame and, if the profiler is visible, the frame time graph and
+  // percentiles and the profile block tree.  All the text is drawn in a single draw.
+  auto render(const FrameStats& frameStats) -> void;
 
+  // Shared with anything else that draws text, so the debug labels and app labels use one budget.
+  auto layoutCache() -> TextLayoutCache& {
+    return m_layoutCache;
+  }
+
+private:
   // Renderer* m_renderer;
   fl::Size m_size;
+  TextLayoutCache m_layoutCache;
   DebugFont m_debugFont;
+  FrameGraph m_frameGraph;
+  ProfilePrinter m_profilePrinter{&m_debugFont};
+  bool m_profilerVisible = false;
+
+  // Percentiles only change in the text every so often, so they can be read.
+  U32 m_framesSincePercentiles = 0;
+  nu::StaticString<128> m_percentiles;
 };
 
 }  // namespace ca
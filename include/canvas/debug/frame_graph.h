@@ -0,0 +1,48 @@
+#pragma once
+
+#include "canvas/renderer/frame_allocator.h"
+#include "canvas/renderer/types.h"
+#include "floats/mat4.h"
+#include "floats/pos.h"
+#include "floats/size.h"
+#include "nucleus/macros.h"
+
+namespace ca {
+
+class FrameStats;
+class Renderer;
+
+// Bar graph of the frame times in a `FrameStats` history, one bar per frame, colored by how close
+// the frame came to the hitch threshold.  Drawn with a single draw.
+class FrameGraph {
+public:
+  NU_DELETE_COPY_AND_MOVE(FrameGraph);
+
+  explicit FrameGraph(Renderer* renderer);
+
+  bool initialize();
+
+  // Draw the graph with its bottom left corner at `position`.  The top of the graph is twice the
+  // hitch threshold.
+  void render(const fl::Mat4& transform, const fl::Pos& position, const fl::Size& size,
+              const FrameStats& stats);
+
+private:
+  struct Vertex {
+    F32 x;
+    F32 y;
+    U32 color;
+  };
+
+  void addRect(F32 left, F32 top, F32 right, F32 bottom, U32 color);
+
+  Renderer* m_renderer;
+
+  VertexBufferId m_vertexBufferId;
+  ProgramId m_programId;
+  UniformId m_transformUniformId;
+
+  FrameArray<Vertex> m_vertices;
+};
+
+}  // namespace ca
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdio>
+
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+#include "nucleus/profiling.h"
+#include "nucleus/text/static_string.h"
+
+namespace ca {
+
+struct FrameTiming {
+  // Time spent preparing and submitting the frame.
+  F64 cpuMilliseconds;
+  // Time the GPU spent on the frame, or less than 0 if it was not measured.
+  F64 gpuMilliseconds;
+  // Time since the previous frame was presented.
+  F64 presentIntervalMilliseconds;
+  // Part of the present interval spent deliberately waiting to pace frames, which doesn't count
+  // towards hitches.
+  F64 idleMilliseconds = 0.0;
+};
+
+struct FramePercentiles {
+  F64 p50 = 0.0;
+  F64 p95 = 0.0;
+  F64 p99 = 0.0;
+  F64 max = 0.0;
+};
+
+struct FrameStatsSummary {
+  U32 frameCount = 0;
+  FramePercentiles cpu;
+  FramePercentiles gpu;
+  FramePercentiles presentInterval;
+  U64 hitchCount = 0;
+};
+
+// A frame that took longer than the hitch threshold, with the profile block tree it had.
+struct Hitch {
+  struct Block {
+    nu::StaticString<64> name;
+    U32 depth;
+    F64 milliseconds;
+  };
+
+  U64 frame;
+  FrameTiming timing;
+  nu::DynamicArray<Block> blocks;
+};
+
+// Ring buffer of the timings of the most recent frames, with percentiles over all of them, so the
+// slow frames that averages hide stand out.  Frames slower than the hitch threshold also keep a
+// copy of their profile block tree.
+class FrameStats {
+public:
+  NU_DELETE_COPY_AND_MOVE(FrameStats);
+
+  static constexpr U32 kHistorySize = 512;
+  static constexpr U32 kMaxHitches = 16;
+
+  explicit FrameStats(F64 hitchThresholdMilliseconds = 50.0);
+
+  auto hitchThreshold() const -> F64 {
+    return m_hitchThreshold;
+  }
+
+  auto setHitchThreshold(F64 milliseconds) -> void {
+    m_hitchThreshold = milliseconds;
+  }
+
+  // Add a frame and the profile blocks it recorded, which may be null.  Returns true if the frame
+  // was a hitch.
+  auto addFrame(const FrameTiming& timing, nu::detail::ProfileMetrics::Block* root) -> bool;
+
+  // Number of frames in the history.
+  auto frameCount() const -> U32 {
+    return m_count;
+  }
+
+  // Frames in the history, from the oldest at 0 to the most recent at `frameCount() - 1`.
+  auto frame(U32 index) const -> const FrameTiming& {
+    return m_frames[(m_next + kHistorySize - m_count + index) % kHistorySize];
+  }
+
+  auto summary() const -> FrameStatsSummary;
+
+  // The most recent hitches, oldest first.
+  auto hitches() const -> const nu::DynamicArray<Hitch>& {
+    return m_hitches;
+  }
+
+  // Write the summary, the hitches and every frame in the history as text.
+  auto writeReport(FILE* file) const -> void;
+  auto writeReport(const char* path) const -> bool;
+
+private:
+  auto snapshotBlocks(nu::detail::ProfileMetrics::Block* block, U32 depth, Hitch* hitch) -> void;
+
+  F64 m_hitchThreshold;
+
+  FrameTiming m_frames[kHistorySize];
+  U32 m_next = 0;
+  U32 m_count = 0;
+  U64 m_frameNumber = 0;
+
+  nu::DynamicArray<Hitch> m_hitches;
+  U64 m_hitchCount = 0;
+};
+
+}  // namespace ca
@@ -1,30 +1,76 @@
 #pragma once
 
+#include "canvas/renderer/gpu_profiler.h"
 #include "floats/mat4.h"
 #include "floats/pos.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
 #include "nucleus/profiling.h"
+#include "nucleus/text/static_string.h"
 
 namespace ca {
 
-#if 0
-
-class Renderer;
 class DebugFont;
 
+// Keeps the timings of the profile block tree over the last frames and prints it as an indented
+// table of the average, minimum and maximum CPU time of every block, with its GPU time if the
+// block was also measured on the GPU.  The text only changes a few times a second, so its layout
+// is mostly reused.
 class ProfilePrinter {
 public:
-  ProfilePrinter(Renderer* renderer, DebugFont* debugFont, const Mat4& transform);
+  NU_DELETE_COPY_AND_MOVE(ProfilePrinter);
+
+  // Timings are averaged over this many frames.
+  static constexpr U32 kHistoryFrames = 60;
+
+  explicit ProfilePrinter(DebugFont* debugFont);
 
-  auto draw(nu::detail::ProfileMetrics::Block* root, const Pos& position) -> void;
+  // Add the timings of a finished frame.
+  auto record(nu::detail::ProfileMetrics::Block* root,
+              const nu::DynamicArray<GpuScopeTiming>& gpuTimings) -> void;
+
+  // Add the table to the debug font's text for this frame.
+  auto draw(const fl::Mat4& transform, const fl::Pos& position) -> void;
+
+  // The table that is drawn: a header, then a line for each block of the last frame.
+  auto lines() const -> const nu::DynamicArray<nu::StaticString<128>>& {
+    return m_lines;
+  }
 
 private:
-  Renderer* m_renderer;
+  struct History {
+    F64 samples[kHistoryFrames];
+    U32 count = 0;
+    U32 next = 0;
+
+    auto add(F64 sample) -> void;
+    auto average() const -> F64;
+    auto minimum() const -> F64;
+    auto maximum() const -> F64;
+  };
+
+  struct Node {
+    U64 key;
+    nu::StaticString<64> name;
+    U32 depth;
+    U64 lastFrame;
+    History cpu;
+    History gpu;
+  };
+
+  auto recordBlock(nu::detail::ProfileMetrics::Block* block, U64 parentKey, U32 depth,
+                   const nu::DynamicArray<GpuScopeTiming>& gpuTimings) -> void;
+  auto findNode(U64 key) -> U32;
+  auto updateLines() -> void;
+
   DebugFont* m_debugFont;
-  Mat4 m_transform;
 
-  Pos m_cursor;
-};
+  U64 m_frame = 0;
+  nu::DynamicArray<Node> m_nodes;
+  // Indices into `m_nodes` in the order of the tree of the last frame.
+  nu::DynamicArray<U32> m_order;
 
-#endif  // 0
+  nu::DynamicArray<nu::StaticString<128>> m_lines;
+};
 
 }  // namespace ca
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "nucleus/containers/dynamic_array.h"
 #include "nucleus/macros.h"
 #include "nucleus/message_loop/message_pump.h"
@@ -8,6 +10,10 @@ namespace ca {
 
 class Window;
 
+// Runs the window's frames, paced by the window's `FramePacing`: continuously, capped to a frame
+// rate, or only when something changed.  Frames slow down while the window is in the background
+// and stop while it is iconified.  With threaded rendering, a paint only records the frame, so the
+// next frame's events and tick run while the render thread draws it.
 class MessagePumpUI : public nu::MessagePump {
   NU_DELETE_COPY_AND_MOVE(MessagePumpUI);
 
@@ -20,7 +26,18 @@ public:
   void run(nu::MessagePump::Delegate* delegate) override;
 
 private:
+  // Wait for the next frame, processing events.  Returns false if the window is closing.
+  bool wait_for_frame();
+
+  // Microseconds between frames at the current pacing, or 0 for no limit.
+  F64 frame_interval() const;
+
   Window* window_;
+
+  // Set from any thread when a task is posted, so a waiting pump runs it.
+  std::atomic<bool> task_pending_{false};
+
+  F64 last_paint_time_ = 0.0;
 };
 
 }  // namespace ca
@@ -1,46 +1,77 @@
 #pragma once
 
+#include "canvas/renderer/render_state.h"
+#include "canvas/renderer/texture_slots.h"
 #include "canvas/renderer/types.h"
 #include "canvas/utils/color.h"
+#include "floats/pos.h"
+#include "floats/size.h"
 
 namespace ca {
 
+// Everything a frame packet can ask the renderer to do.  Commands only hold their type and an
+// index into the packet's array of data for that type.
 enum class CommandType : U32 {
-  ClearBuffers,
+  BeginFrame,
+  EndFrame,
+  Clear,
   Draw,
+  DrawIndexed,
+  DrawInstanced,
+  VertexBufferData,
+  StreamVertexBufferData,
+  IndexBufferData,
+  TextureSubData,
+  BeginGpuScope,
+  EndGpuScope,
 };
 
-struct ClearBuffersData {
-  Color color;
+struct Command {
+  CommandType type;
+  U32 index;
 };
 
-struct DrawData {
-  ProgramId programId;
-  VertexBufferId vertexBufferId;
-  IndexBufferId indexBufferId;
-  TextureId textureId;
-  DrawType drawType;
-  U32 numIndices;
-
-#if 0
-  struct UniformEntry {
-      UniformId uniformId;
-      nu::DynamicArray<F32> values;
-  };
-
-  nu::DynamicArray<UniformEntry> uniforms;
-#endif  // 0
+// A range of the packet's data bytes.
+struct DataRange {
+  MemSize offset;
+  MemSize size;
 };
 
-struct Command {
-  CommandType type;
+struct BeginFrameCommand {
+  fl::Pos damage_position;
+  fl::Size damage_size;
+};
+
+// Uniforms are copied out of the `UniformBuffer` they were set in, so the buffer can be reused
+// as soon as the draw was recorded.
+struct RecordedUniform {
+  UniformId uniform_id;
+  ComponentType type;
+  U32 count;
+  U8 data[sizeof(F32) * 16];
+};
 
-  union {
-    ClearBuffersData clearBuffersData;
-    DrawData drawData;
-  };
+// Serves all three kinds of draw; fields that don't apply to a kind are ignored.
+struct DrawCommand {
+  DrawType draw_type;
+  U32 first;
+  U32 count;
+  U32 instance_count;
+  ProgramId program_id;
+  VertexBufferId vertex_buffer_id;
+  IndexBufferId index_buffer_id;
+  TextureSlots textures;
+  RenderState state;
+  U32 first_uniform;
+  U32 uniform_count;
+};
 
-  explicit Command(CommandType type) : type{type} {}
+// New contents for a buffer, or for a rectangle of a texture, copied into the packet.
+struct UploadCommand {
+  MemSize resource_id;
+  fl::Pos position;
+  fl::Size size;
+  DataRange data;
 };
 
 }  // namespace ca
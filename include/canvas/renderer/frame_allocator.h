@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "nucleus/logging.h"
+#include "nucleus/macros.h"
+#include "nucleus/types.h"
+
+namespace ca {
+
+constexpr MemSize kDefaultFrameAllocatorCapacity = 4 * 1024 * 1024;
+
+// Linear allocator for data that only lives for a frame.  Allocations are a pointer bump and are
+// never freed individually; `reset` releases everything at once.  There are two arenas, used in
+// alternate frames, so memory handed out during a frame stays valid until the end of the next
+// one.
+//
+// When an arena runs out, allocations fall back to the heap for the rest of the frame and the
+// arena grows to the high water mark the next time it is used.
+class FrameAllocator {
+public:
+  NU_DELETE_COPY_AND_MOVE(FrameAllocator);
+
+  explicit FrameAllocator(MemSize capacity = kDefaultFrameAllocatorCapacity);
+  ~FrameAllocator();
+
+  // Start a new frame: switch to the other arena and release everything allocated from it.
+  void reset();
+
+  // Number of times `reset` was called.  Memory allocated in frame `n` is valid up to frame
+  // `n + 1`.
+  NU_NO_DISCARD U64 frame() const {
+    return frame_;
+  }
+
+  void* allocate(MemSize size, MemSize alignment = alignof(std::max_align_t));
+
+  template <typename T>
+  T* allocate_array(MemSize count) {
+    return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+  }
+
+  // Bytes allocated in the current frame, including heap fallbacks.
+  NU_NO_DISCARD MemSize used() const {
+    return arenas_[current_].used + arenas_[current_].overflow_bytes;
+  }
+
+  NU_NO_DISCARD MemSize capacity() const {
+    return arenas_[current_].capacity;
+  }
+
+  // The most bytes used by any single frame so far.
+  NU_NO_DISCARD MemSize high_water_mark() const {
+    return high_water_mark_;
+  }
+
+  // Number of frames that did not fit in their arena.
+  NU_NO_DISCARD MemSize overflow_frames() const {
+    return overflow_frames_;
+  }
+
+private:
+  struct Overflow {
+    Overflow* next;
+  };
+
+  struct Arena {
+    U8* data = nullptr;
+    MemSize capacity = 0;
+    MemSize used = 0;
+    Overflow* overflow = nullptr;
+    MemSize overflow_bytes = 0;
+  };
+
+  void release(Arena* arena);
+
+  Arena arenas_[2];
+  MemSize current_ = 0;
+  U64 frame_ = 0;
+  MemSize high_water_mark_ = 0;
+  MemSize overflow_frames_ = 0;
+};
+
+// Growable array that allocates from a `FrameAllocator`.  Growing leaves the old block in the
+// arena, so it's best suited to data that is built up and consumed within a frame.
+//
+// The storage only lives until the allocator was reset twice.  After that the array reads as
+// empty, and the next change drops the old storage instead of touching memory that the allocator
+// handed out again.  Elements that are dropped without a `clear` are logged.
+template <typename T>
+class FrameArray {
+public:
+  NU_DELETE_COPY(FrameArray);
+
+  FrameArray() = default;
+
+  explicit FrameArray(FrameAllocator* allocator) : allocator_{allocator} {}
+
+  FrameArray(FrameArray&& other) noexcept
+    : allocator_{other.allocator_},
+      data_{other.data_},
+      size_{other.size_},
+      capacity_{other.capacity_},
+      frame_{other.frame_} {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+  }
+
+  FrameArray& operator=(FrameArray&& other) noexcept {
+    if (this != &other) {
+      clear();
+      allocator_ = other.allocator_;
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      frame_ = other.frame_;
+      other.data_ = nullptr;
+      other.size_ = 0;
+      other.capacity_ = 0;
+    }
+    return *this;
+  }
+
+  ~FrameArray() {
+    // Trivial elements need no destructor, so the allocator may already be gone.
+    if (!std::is_trivially_destructible<T>::value) {
+      clear();
+    }
+  }
+
+  NU_NO_DISCARD bool empty() const {
+    return size() == 0;
+  }
+
+  NU_NO_DISCARD MemSize size() const {
+    return is_stale() ? 0 : size_;
+  }
+
+  T* data() {
+    return is_stale() ? nullptr : data_;
+  }
+
+  const T* data() const {
+    return is_stale() ? nullptr : data_;
+  }
+
+  T* begin() {
+    return data();
+  }
+
+  T* end() {
+    return data() + size();
+  }
+
+  const T* begin() const {
+    return data();
+  }
+
+  const T* end() const {
+    return data() + size();
+  }
+
+  T& operator[](MemSize index) {
+    DCHECK(!is_stale()) << "FrameArray storage used after its frame";
+    return data_[index];
+  }
+
+  const T& operator[](MemSize index) const {
+    DCHECK(!is_stale()) << "FrameArray storage used after its frame";
+    return data_[index];
+  }
+
+  // Drop all elements.  Storage is not reused, since only resetting the allocator reclaims it.
+  void clear() {
+    if (!std::is_trivially_destructible<T>::value && !is_stale()) {
+      for (MemSize i = 0; i < size_; ++i) {
+        data_[i].~T();
+      }
+    }
+    data_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
+  }
+
+  void reserve(MemSize capacity) {
+    drop_if_stale();
+    if (capacity <= capacity_) {
+      return;
+    }
+
+    DCHECK(allocator_) << "FrameArray used without an allocator";
+    T* data = allocator_->allocate_array<T>(capacity);
+    for (MemSize i = 0; i < size_; ++i) {
+      new (data + i) T(std::move(data_[i]));
+      data_[i].~T();
+    }
+    data_ = data;
+    capacity_ = capacity;
+    frame_ = allocator_->frame();
+  }
+
+  // Drop the elements from `size` onwards.
+  void shrink(MemSize size) {
+    drop_if_stale();
+    for (MemSize i = size; i < size_; ++i) {
+      data_[i].~T();
+    }
+    size_ = size < size_ ? size : size_;
+  }
+
+  void pushBack(const T& value) {
+    emplaceBack(value);
+  }
+
+  template <typename... Args>
+  T& emplaceBack(Args&&... args) {
+    drop_if_stale();
+    if (size_ == capacity_) {
+      reserve(capacity_ ? capacity_ * 2 : 16);
+    }
+    return *new (data_ + size_++) T{std::forward<Args>(args)...};
+  }
+
+private:
+  // True if the allocator was reset twice since the storage was allocated, so it may have been
+  // handed out again.
+  NU_NO_DISCARD bool is_stale() const {
+    return data_ && allocator_->frame() - frame_ >= 2;
+  }
+
+  // Forget stale storage without running destructors, which would write to reused memory.
+  void drop_if_stale() {
+    if (is_stale()) {
+      LOG(Warning) << "Dropping " << size_ << " elements of a FrameArray that outlived its frame.";
+      data_ = nullptr;
+      size_ = 0;
+      capacity_ = 0;
+    }
+  }
+
+  FrameAllocator* allocator_ = nullptr;
+  T* data_ = nullptr;
+  MemSize size_ = 0;
+  MemSize capacity_ = 0;
+  // The allocator's frame when `data_` was allocated.
+  U64 frame_ = 0;
+};
+
+}  // namespace ca
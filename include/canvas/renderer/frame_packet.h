@@ -0,0 +1,112 @@
+#pragma once
+
+#include "canvas/renderer/command.h"
+#include "canvas/renderer/gpu_profiler.h"
+#include "canvas/renderer/uniform_buffer.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+#include "nucleus/text/string_view.h"
+
+namespace ca {
+
+// Everything the renderer was asked to do in a frame, recorded so it can be executed later on
+// another thread.  All data is copied in, so nothing the frame was recorded from has to stay
+// alive.  Packets are reused from frame to frame and keep their storage when they are reset.
+class FramePacket {
+public:
+  NU_DELETE_COPY_AND_MOVE(FramePacket);
+
+  FramePacket() = default;
+
+  // Drop all commands and data, keeping the storage for the next frame.
+  void reset();
+
+  NU_NO_DISCARD bool empty() const {
+    return commands_.empty();
+  }
+
+  // Whether GPU profile scopes are measured when the packet is executed.
+  NU_NO_DISCARD bool gpu_profiling() const {
+    return gpu_profiling_;
+  }
+
+  void set_gpu_profiling(bool enabled) {
+    gpu_profiling_ = enabled;
+  }
+
+  // GPU timings the executing thread read back after the packet was executed, which are from a
+  // frame a few frames earlier.  They are kept until the packet is executed again.
+  NU_NO_DISCARD const nu::DynamicArray<GpuScopeTiming>& gpu_timings() const {
+    return gpu_timings_;
+  }
+
+  void set_gpu_timings(const nu::DynamicArray<GpuScopeTiming>& timings);
+
+  void record_begin_frame(const fl::Pos& damage_position, const fl::Size& damage_size);
+  void record_end_frame();
+  void record_clear(const Color& color);
+  // `type` is one of the draw command types.
+  void record_draw(CommandType type, const DrawCommand& draw, const UniformBuffer& uniforms);
+  // `type` is one of the buffer or texture data command types.
+  void record_upload(CommandType type, MemSize resource_id, const fl::Pos& position,
+                     const fl::Size& size, const void* data, MemSize data_size);
+  void record_begin_gpu_scope(nu::StringView name);
+  void record_end_gpu_scope();
+
+  NU_NO_DISCARD const nu::DynamicArray<Command>& commands() const {
+    return commands_;
+  }
+
+  NU_NO_DISCARD const BeginFrameCommand& begin_frame(U32 index) const {
+    return begin_frames_[index];
+  }
+
+  NU_NO_DISCARD const Color& clear_color(U32 index) const {
+    return clear_colors_[index];
+  }
+
+  NU_NO_DISCARD const DrawCommand& draw(U32 index) const {
+    return draws_[index];
+  }
+
+  NU_NO_DISCARD const RecordedUniform& uniform(U32 index) const {
+    return uniforms_[index];
+  }
+
+  NU_NO_DISCARD const UploadCommand& upload(U32 index) const {
+    return uploads_[index];
+  }
+
+  NU_NO_DISCARD nu::StringView gpu_scope_name(U32 index) const {
+    const DataRange& range = gpu_scope_names_[index];
+    return nu::StringView{reinterpret_cast<const char*>(data(range)), range.size};
+  }
+
+  NU_NO_DISCARD const U8* data(const DataRange& range) const {
+    return range.size ? data_.data() + range.offset : nullptr;
+  }
+
+  // Bytes of buffer and texture data copied into the packet.
+  NU_NO_DISCARD MemSize data_size() const {
+    return data_.size();
+  }
+
+private:
+  void add_command(CommandType type, MemSize index);
+  DataRange add_data(const void* data, MemSize size);
+
+  bool gpu_profiling_ = false;
+
+  nu::DynamicArray<Command> commands_;
+  nu::DynamicArray<BeginFrameCommand> begin_frames_;
+  nu::DynamicArray<Color> clear_colors_;
+  nu::DynamicArray<DrawCommand> draws_;
+  nu::DynamicArray<RecordedUniform> uniforms_;
+  nu::DynamicArray<UploadCommand> uploads_;
+  nu::DynamicArray<DataRange> gpu_scope_names_;
+  nu::DynamicArray<U8> data_;
+
+  nu::DynamicArray<GpuScopeTiming> gpu_timings_;
+};
+
+}  // namespace ca
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "canvas/utils/hash.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+#include "nucleus/text/string_view.h"
+#include "nucleus/types.h"
+
+namespace ca {
+
+class Renderer;
+
+// Identifies a profile scope by its name and the names of the scopes it is nested in, so CPU and
+// GPU timings of the same scope can be matched up.
+inline U64 profile_scope_key(U64 parent_key, nu::StringView name) {
+  return hash_bytes(name.data(), name.length(), parent_key);
+}
+
+struct GpuScopeTiming {
+  U64 key;
+  U32 depth;
+  F64 milliseconds;
+};
+
+// Measures how long the GPU spends on nested scopes with timestamp queries.  Results are read a
+// few frames later, once they are available, so measuring never waits for the GPU.  Scopes cost
+// nothing while the profiler is disabled.
+class GpuProfiler {
+public:
+  NU_DELETE_COPY_AND_MOVE(GpuProfiler);
+
+  // Frames that may be in flight before their results are read.
+  static constexpr U32 kFrameLatency = 4;
+
+  // Queries are not deleted when the profiler is destroyed, since the context may already be gone.
+  // The renderer deletes them with `delete_queries` before the context is destroyed.
+  GpuProfiler() = default;
+
+  NU_NO_DISCARD bool is_enabled() const {
+    return enabled_;
+  }
+
+  void set_enabled(bool enabled);
+
+  void begin_frame();
+  void end_frame();
+
+  void begin_scope(nu::StringView name);
+  void end_scope();
+
+  // Delete every query, dropping results that were not read yet.  Called where the context is
+  // current.
+  void delete_queries();
+
+  // Timings of the most recent frame that has finished on the GPU, in the order the scopes began.
+  NU_NO_DISCARD const nu::DynamicArray<GpuScopeTiming>& timings() const {
+    return timings_;
+  }
+
+  // Frames whose results were still not available after `kFrameLatency` frames and were dropped.
+  NU_NO_DISCARD U64 dropped_frames() const {
+    return dropped_frames_;
+  }
+
+private:
+  struct Scope {
+    U64 key;
+    U32 depth;
+    U32 begin_query;
+    U32 end_query;
+  };
+
+  struct Frame {
+    nu::DynamicArray<Scope> scopes;
+    // The query issued last.  Queries complete in order, so once it is available, all are.
+    U32 last_query = 0;
+  };
+
+  U32 acquire_query();
+  void resolve(Frame* frame);
+  void release(Frame* frame);
+
+  bool enabled_ = false;
+  bool in_frame_ = false;
+
+  Frame frames_[kFrameLatency];
+  U32 current_frame_ = 0;
+
+  // Indices into the current frame's scopes of the scopes that have not ended yet.
+  nu::DynamicArray<U32> open_scopes_;
+
+  // Every query that was created, and those not used by a frame.
+  nu::DynamicArray<U32> queries_;
+  nu::DynamicArray<U32> free_queries_;
+
+  nu::DynamicArray<GpuScopeTiming> timings_;
+  U64 dropped_frames_ = 0;
+};
+
+// Times the GPU work issued for the rest of the enclosing block.  Goes through the renderer, so
+// scopes are recorded along with the rest of a frame that is executed later.
+class GpuProfileScope {
+public:
+  NU_DELETE_COPY_AND_MOVE(GpuProfileScope);
+
+  GpuProfileScope(Renderer* renderer, nu::StringView name);
+  ~GpuProfileScope();
+
+private:
+  Renderer* renderer_;
+};
+
+}  // namespace ca
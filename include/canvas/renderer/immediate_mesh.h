@@ -2,9 +2,9 @@
 
 #include <floats/mat4.h>
 #include <floats/vec3.h>
-#include <nucleus/containers/dynamic_array.h>
 #include <nucleus/macros.h>
 
+#include "canvas/renderer/frame_allocator.h"
 #include "canvas/renderer/types.h"
 #include "canvas/utils/color.h"
 
@@ -24,20 +24,20 @@ public:
 
 private:
   friend class ImmediateRenderer;
-  friend class nu::DynamicArray<ImmediateMesh>;
+  friend class FrameArray<ImmediateMesh>;
 
   struct Vertex {
     fl::Vec3 position;
     Color color;
   };
 
-  explicit ImmediateMesh(ImmediateRenderer* immediate_renderer, DrawType draw_type,
-                         const fl::Mat4& transform = fl::Mat4::identity);
+  ImmediateMesh(ImmediateRenderer* immediate_renderer, FrameAllocator* allocator,
+                DrawType draw_type, const fl::Mat4& transform = fl::Mat4::identity);
 
   ImmediateRenderer* immediate_renderer_;
   DrawType draw_type_;
   fl::Mat4 transform_;
-  nu::DynamicArray<Vertex> vertices_;
+  FrameArray<Vertex> vertices_;
 };
 
 }  // namespace ca
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "canvas/renderer/types.h"
+#include "canvas/renderer/vertex_definition.h"
+#include "canvas/utils/lru_table.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+
+namespace ca {
+
+class Renderer;
+
+struct ImmediateMeshCacheStatistics {
+  U64 hits = 0;
+  U64 misses = 0;
+  U64 evictions = 0;
+  MemSize entry_count = 0;
+  MemSize bytes = 0;
+
+  NU_NO_DISCARD F32 hit_rate() const {
+    U64 lookups = hits + misses;
+    return lookups ? static_cast<F32>(hits) / static_cast<F32>(lookups) : 0.0f;
+  }
+};
+
+// Keeps GPU copies of recently drawn immediate meshes, keyed by a hash of their content, so that
+// meshes that are the same every frame are only uploaded once.  A mesh is only admitted once it
+// was looked up in two consecutive frames, so meshes that change every frame are not uploaded on
+// their own and don't push others out.  The least recently used entries are evicted to stay
+// within the byte budget, and their vertex buffers are reused for new entries.  Entries used in
+// the current frame are never evicted, so the budget can be exceeded for a frame.
+class ImmediateMeshCache {
+public:
+  NU_DELETE_COPY(ImmediateMeshCache);
+  NU_DEFAULT_MOVE(ImmediateMeshCache);
+
+  ImmediateMeshCache(Renderer* renderer, const VertexDefinition& vertex_definition,
+                     MemSize budget);
+  ~ImmediateMeshCache();
+
+  NU_NO_DISCARD MemSize budget() const {
+    return budget_;
+  }
+
+  void set_budget(MemSize bytes);
+
+  NU_NO_DISCARD const ImmediateMeshCacheStatistics& statistics() const {
+    return statistics_;
+  }
+
+  void begin_frame();
+
+  // Returns a vertex buffer with `data`, uploading it only if no entry has the same `key` and
+  // content.  Returns an invalid id if `key` was not looked up in the previous frame, in which case
+  // the mesh has to be drawn some other way.
+  VertexBufferId find_or_upload(U64 key, const void* data, MemSize size);
+
+private:
+  struct Entry {
+    VertexBufferId vertex_buffer_id;
+    MemSize bytes;
+    // A copy of the content, so meshes with the same key are told apart.
+    nu::DynamicArray<U8> data;
+  };
+
+  void evict_to_budget();
+
+  Renderer* renderer_;
+  VertexDefinition vertex_definition_;
+  MemSize budget_;
+  U64 frame_ = 0;
+
+  LruTable table_;
+  // Indexed like the entries of `table_`.
+  nu::DynamicArray<Entry> entries_;
+
+  // Keys that missed in this frame and, sorted, in the previous one.
+  nu::DynamicArray<U64> candidates_;
+  nu::DynamicArray<U64> previous_candidates_;
+
+  ImmediateMeshCacheStatistics statistics_;
+};
+
+}  // namespace ca
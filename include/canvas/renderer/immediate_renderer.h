@@ -1,11 +1,12 @@
 #pragma once
 
+#include "canvas/renderer/frame_allocator.h"
 #include "canvas/renderer/immediate_mesh.h"
+#include "canvas/renderer/immediate_mesh_cache.h"
 #include "canvas/renderer/types.h"
 #include "canvas/utils/color.h"
 #include "floats/mat4.h"
 #include "floats/vec3.h"
-#include "nucleus/containers/dynamic_array.h"
 #include "nucleus/macros.h"
 
 namespace ca {
@@ -13,22 +14,85 @@ namespace ca {
 class Renderer;
 
 class ImmediateRenderer {
-  NU_DELETE_COPY(ImmediateRenderer);
+  NU_DELETE_COPY_AND_MOVE(ImmediateRenderer);
 
 public:
   explicit ImmediateRenderer(Renderer* renderer);
   ~ImmediateRenderer();
 
-  NU_DEFAULT_MOVE(ImmediateRenderer);
-
+  // Meshes live in the renderer's frame allocator, so they have to be rendered by the end of the
+  // renderer frame after the one they were created in.  Later they are dropped.
   NU_NO_DISCARD ImmediateMesh& create_mesh(DrawType draw_type,
                                            const fl::Mat4& transform = fl::Mat4::identity);
 
+  // Groups of meshes (same draw type and transform) with at most this many vertices are
+  // transformed on the CPU and merged into one draw per draw type, instead of a draw each.  0
+  // disables CPU transforms.
+  void set_pre_transform_limit(U32 vertex_count) {
+    pre_transform_limit_ = vertex_count;
+  }
+
+  // Meshes with at least this many vertices are kept on the GPU across frames, keyed by their
+  // content, so an unchanged mesh costs a draw without an upload.  A mesh is only cached from the
+  // second frame in a row it is drawn in.  0 disables caching.
+  void set_cache_min_vertices(U32 vertex_count) {
+    cache_min_vertices_ = vertex_count;
+  }
+
+  // Use to set the cache budget and read its hit rate.
+  NU_NO_DISCARD ImmediateMeshCache& cache() {
+    return cache_;
+  }
+
+  // Draw all meshes created since the last call.  Meshes are appended to a streaming vertex buffer
+  // and merged into a single draw for each draw type and transform, or for each draw type when
+  // they are small enough to be transformed on the CPU.  Meshes that differ in draw type or
+  // transform are not guaranteed to be drawn in the order they were created.
   void submit_to_renderer();
 
 private:
+  struct Batch {
+    DrawType draw_type;
+    U32 transform_index;
+    U32 vertex_offset;
+    U32 vertex_count;
+  };
+
+  struct CachedDraw {
+    DrawType draw_type;
+    U32 mesh_index;
+    VertexBufferId vertex_buffer_id;
+    U32 vertex_count;
+  };
+
+  // A vertex already in clip space.
+  struct ClipVertex {
+    F32 position[4];
+    Color color;
+  };
+
+  bool should_cache(const ImmediateMesh& mesh) const;
+  void build_batches();
+  void append_pre_transformed(DrawType draw_type, MemSize group_begin, MemSize group_end);
+
   Renderer* renderer_;
-  nu::DynamicArray<ImmediateMesh> meshes_;
+  FrameArray<ImmediateMesh> meshes_;
+
+  VertexBufferId vertex_buffer_id_;
+  UniformId transform_uniform_id_;
+  FrameArray<ImmediateMesh::Vertex> vertices_;
+  FrameArray<U32> mesh_order_;
+  FrameArray<U64> mesh_keys_;
+  FrameArray<Batch> batches_;
+
+  U32 pre_transform_limit_;
+  VertexBufferId clip_vertex_buffer_id_;
+  FrameArray<ClipVertex> clip_vertices_;
+  FrameArray<Batch> clip_batches_;
+
+  U32 cache_min_vertices_;
+  ImmediateMeshCache cache_;
+  FrameArray<CachedDraw> cached_draws_;
 };
 
 }  // namespace ca
@@ -1,9 +1,11 @@
 #pragma once
 
+#include "canvas/renderer/frame_allocator.h"
 #include "canvas/renderer/types.h"
 #include "canvas/utils/color.h"
 #include "floats/mat4.h"
 #include "floats/plane.h"
+#include "floats/vec2.h"
 #include "floats/vec3.h"
 #include "nucleus/containers/dynamic_array.h"
 #include "nucleus/macros.h"
@@ -12,21 +14,54 @@ namespace ca {
 
 class Renderer;
 
+DECLARE_RESOURCE_ID(LineLayer)
+
 class LineRenderer {
 public:
   NU_DELETE_COPY_AND_MOVE(LineRenderer);
 
   LineRenderer();
+  ~LineRenderer();
 
   bool initialize(Renderer* renderer);
   void beginFrame();
 
   void renderLine(const fl::Vec3& p1, const fl::Vec3& p2, const Color& color);
+
+  // A line `width` pixels wide with anti-aliased edges, expanded to a quad on the GPU.
+  void renderWideLine(const fl::Vec3& p1, const fl::Vec3& p2, const Color& color, F32 width);
+
+  // A grid of `numBlocks` blocks in each direction from the plane's origin.  The lines are
+  // computed per pixel on a single quad, so the cost doesn't depend on the number of blocks.
   void renderGrid(const fl::Plane& plane, const fl::Vec3& worldUp, const Color& color,
                   I32 numBlocks, F32 blockSize);
 
+  // What is left of a grid line's alpha at `coord`, in blocks from the center of a grid that is
+  // `blocks` blocks across each way.  The grid shader fades its lines the same way.
+  static F32 gridEdgeFade(const fl::Vec2& coord, F32 blocks);
+
+  // Layers keep their lines across frames and only upload them again after they changed, so
+  // static content costs nothing per frame.  Everything passed to `renderLine`, `renderWideLine`
+  // and `renderGrid` is transient and cleared by `beginFrame`.  It lives in the renderer's frame
+  // allocator, so it is dropped if it is not rendered by the end of the next renderer frame.
+  // Slots of deleted layers are reused, but their ids stay invalid.  A layer deleted while a
+  // frame is recorded keeps its buffers until `beginFrame` is called in a later frame.
+  LineLayerId createLayer();
+  void deleteLayer(LineLayerId id);
+  void clearLayer(LineLayerId id);
+  void addLine(LineLayerId id, const fl::Vec3& p1, const fl::Vec3& p2, const Color& color);
+  void addWideLine(LineLayerId id, const fl::Vec3& p1, const fl::Vec3& p2, const Color& color,
+                   F32 width);
+  // Applied before the transform passed to `render`.
+  void setLayerTransform(LineLayerId id, const fl::Mat4& transform);
+  void setLayerVisible(LineLayerId id, bool visible);
+
   void render(const fl::Mat4& transform);
 
+  NU_NO_DISCARD MemSize lineCount() const {
+    return m_lines.size() + m_wideLines.size();
+  }
+
 private:
   struct Line {
     fl::Vec3 p1;
@@ -35,15 +70,73 @@ private:
     Color color2;
   };
 
+  // One instance per line.
+  struct WideLine {
+    fl::Vec3 p1;
+    fl::Vec3 p2;
+    U32 color;
+    F32 width;
+  };
+
+  // One instance per grid.
+  struct Grid {
+    fl::Vec3 center;
+    fl::Vec3 right;
+    fl::Vec3 forward;
+    U32 color;
+    F32 extent;
+    F32 blockSize;
+  };
+
+  struct Layer {
+    nu::DynamicArray<Line> lines;
+    nu::DynamicArray<WideLine> wideLines;
+    VertexBufferId vertexBufferId;
+    VertexBufferId wideVertexBufferId;
+    fl::Mat4 transform;
+    // Bumped when the layer is deleted, so ids of earlier layers in the slot don't match.
+    U32 generation = 0;
+    bool alive;
+    bool visible;
+    bool dirty;
+  };
+
+  struct PendingDelete {
+    VertexBufferId vertexBufferId;
+    VertexBufferId wideVertexBufferId;
+    // The renderer frame the layer was deleted in.
+    U64 frame;
+  };
+
+  Layer* layer(LineLayerId id);
+  void deletePendingLayers();
+  void uploadLayer(Layer* layer);
+  void renderLayers(const fl::Mat4& transform);
+
+  bool initializeWideLines();
+  bool initializeGrids();
+  void renderWideLines(const fl::Mat4& transform);
+  void renderGrids(const fl::Mat4& transform);
+
   Renderer* m_renderer = nullptr;
 
   VertexBufferId m_vertexBufferId;
-  IndexBufferId m_indexBufferId;
   ProgramId m_programId;
   UniformId m_transformUniformId;
 
-  nu::DynamicArray<Line> m_lines;
-  nu::DynamicArray<U16> m_lineIndices;
+  FrameArray<Line> m_lines;
+
+  VertexBufferId m_wideVertexBufferId;
+  ProgramId m_wideProgramId;
+  UniformId m_viewportSizeUniformId;
+  FrameArray<WideLine> m_wideLines;
+
+  VertexBufferId m_gridVertexBufferId;
+  ProgramId m_gridProgramId;
+  FrameArray<Grid> m_grids;
+
+  nu::DynamicArray<Layer> m_layers;
+  nu::DynamicArray<PendingDelete> m_pendingDeletes;
 };
 
 }  // namespace ca
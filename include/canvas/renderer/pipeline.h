@@ -21,6 +21,11 @@ public:
             IndexBufferId index_buffer_id, const TextureSlots& textures = {},
             const UniformBuffer& uniforms = {});
 
+  // Draw `index_count` indices starting at `index_offset` in the index buffer.
+  void draw_range(DrawType draw_type, U32 index_offset, U32 index_count,
+                  VertexBufferId vertex_buffer_id, IndexBufferId index_buffer_id,
+                  const TextureSlots& textures = {}, const UniformBuffer& uniforms = {});
+
 private:
   friend class PipelineBuilder;
 
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "canvas/renderer/frame_packet.h"
+#include "nucleus/function.h"
+#include "nucleus/macros.h"
+
+namespace ca {
+
+// Executes frame packets on a thread of its own, so recording the next frame overlaps with
+// rendering the previous ones.  Packets come from a fixed pool: once `latency` submitted frames
+// are waiting or being executed, `acquire_packet` blocks until the oldest one is done, which
+// bounds how far the recording thread can get ahead.
+class RenderThread {
+public:
+  NU_DELETE_COPY_AND_MOVE(RenderThread);
+
+  using Task = nu::Function<void()>;
+  using ExecuteFunction = nu::Function<void(FramePacket* packet)>;
+
+  static constexpr U32 kMaxLatency = 3;
+
+  // `execute` runs every submitted packet.  `on_start` and `on_stop` run on the thread before the
+  // first and after the last packet, to make a context current and release it.
+  RenderThread(ExecuteFunction execute, Task on_start, Task on_stop);
+  ~RenderThread();
+
+  NU_NO_DISCARD U32 latency() const {
+    return latency_;
+  }
+
+  // Frames that may be submitted and not executed yet, from 1 to `kMaxLatency`.  Only takes
+  // effect when the thread is started.
+  void set_latency(U32 latency);
+
+  NU_NO_DISCARD bool is_running() const {
+    return thread_.joinable();
+  }
+
+  // True when called on the render thread.
+  NU_NO_DISCARD bool is_current() const {
+    return std::this_thread::get_id() == thread_.get_id();
+  }
+
+  void start();
+  // Execute everything that was submitted and stop the thread.
+  void stop();
+
+  // A reset packet to record a frame into, waiting for one to be free if necessary.  Its GPU
+  // timings are those read back the last time it was executed.
+  FramePacket* acquire_packet();
+
+  // Queue a packet from `acquire_packet` to be executed.
+  void submit(FramePacket* packet);
+
+  // Run `task` on the render thread, after the packets submitted before it, and wait for it to
+  // finish.  Runs it right away if called on the render thread or if the thread isn't running.
+  void run(Task task);
+
+private:
+  static constexpr U32 kPacketCount = kMaxLatency + 1;
+
+  void thread_main();
+
+  ExecuteFunction execute_;
+  Task on_start_;
+  Task on_stop_;
+
+  U32 latency_ = 1;
+
+  std::thread thread_;
+
+  // Guards everything below.
+  std::mutex lock_;
+  // Signalled when a packet was submitted, a task was posted or the thread should stop.
+  std::condition_variable work_available_;
+  // Signalled when a packet was executed or a task has run.
+  std::condition_variable work_done_;
+
+  FramePacket packets_[kPacketCount];
+  FramePacket* free_packets_[kPacketCount] = {};
+  U32 free_count_ = 0;
+  // Submitted packets in order, as a ring.
+  FramePacket* submitted_[kPacketCount] = {};
+  U32 first_submitted_ = 0;
+  U32 submitted_count_ = 0;
+
+  Task* task_ = nullptr;
+  bool stopping_ = false;
+};
+
+}  // namespace ca
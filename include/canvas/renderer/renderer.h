@@ -1,6 +1,10 @@
 #pragma once
 
+#include <mutex>
+
 #include "canvas/renderer/command.h"
+#include "canvas/renderer/frame_allocator.h"
+#include "canvas/renderer/gpu_profiler.h"
 #include "canvas/renderer/pipeline_builder.h"
 #include "canvas/renderer/render_state.h"
 #include "canvas/renderer/texture_slots.h"
@@ -8,11 +12,16 @@
 #include "canvas/renderer/uniform_buffer.h"
 #include "canvas/renderer/vertex_definition.h"
 #include "canvas/utils/shader_source.h"
+#include "floats/pos.h"
 #include "floats/size.h"
 #include "nucleus/containers/dynamic_array.h"
+#include "nucleus/function.h"
 
 namespace ca {
 
+class FramePacket;
+class RenderThread;
+
 class Renderer {
 public:
   NU_DELETE_COPY_AND_MOVE(Renderer);
@@ -27,7 +36,9 @@ public:
 
   VertexBufferId create_vertex_buffer(const VertexDefinition& bufferDefinition, const void* data,
                                       MemSize dataSize);
-  void vertex_buffer_data(VertexBufferId id, void* data, MemSize dataSize);
+  void vertex_buffer_data(VertexBufferId id, const void* data, MemSize dataSize);
+  // Replace the contents of a buffer that is rewritten every frame.
+  void stream_vertex_buffer_data(VertexBufferId id, const void* data, MemSize data_size);
   void delete_vertex_buffer(VertexBufferId id);
 
   IndexBufferId create_index_buffer(ComponentType componentType, const void* data,
@@ -37,7 +48,15 @@ public:
 
   TextureId create_texture(TextureFormat format, const fl::Size& size, const void* data,
                            MemSize dataSize, bool smooth = false);
+  // Replace a rectangle of the texture with tightly packed pixels in the texture's format.
+  void texture_sub_data(TextureId id, const fl::Pos& position, const fl::Size& size,
+                        const void* data);
+  void delete_texture(TextureId id);
+
+  // Longer uniform names are cut off, so they have to differ in the first this many characters.
+  static constexpr MemSize kMaxUniformNameLength = 127;
 
+  // Returns the same id every time it is called with the same name.
   UniformId create_uniform(const nu::StringView& name);
 
   NU_NO_DISCARD PipelineBuilder create_pipeline_builder() const;
@@ -49,11 +68,58 @@ public:
   // Resize the rendering area. Usually called when the window is resized.
   void resize(const fl::Size& size);
 
+  // Keep every frame in an offscreen buffer that is copied to the window at the end of the frame,
+  // so a frame only has to draw the part of the window that changed.
+  void set_retain_frames(bool retain);
+
+  NU_NO_DISCARD bool retain_frames() const {
+    return retain_frames_;
+  }
+
+  // Delete the GL objects the renderer keeps for itself: the retained frame buffer and the GPU
+  // profiler's queries.  Call before the context is destroyed.
+  void release_resources();
+
   NU_NO_DISCARD RenderState& state() {
     return render_state_;
   }
 
+  // Allocator for transient data, reset by `begin_frame`.
+  NU_NO_DISCARD FrameAllocator* frame_allocator() {
+    return &frame_allocator_;
+  }
+
+  // GPU timings of profile scopes, collected while it is enabled.
+  NU_NO_DISCARD GpuProfiler* gpu_profiler() {
+    return &gpu_profiler_;
+  }
+
+  // Record everything that would reach the GPU into `packet` instead, from `begin_frame` to
+  // `end_frame`, so it can be executed later, possibly on another thread.  Data is copied into the
+  // packet.
+  void begin_recording(FramePacket* packet);
+  void end_recording();
+
+  NU_NO_DISCARD bool is_recording() const {
+    return recording_ != nullptr;
+  }
+
+  // Execute a recorded packet.  Called where the context is current.
+  void execute(const FramePacket& packet);
+
+  // While set, the context is current on `render_thread` and everything else that reaches the GPU,
+  // like creating resources, is run there while the caller waits.
+  void set_render_thread(RenderThread* render_thread);
+
+  // Time the GPU work issued until the matching `end_gpu_scope`.  Prefer `GpuProfileScope`.
+  void begin_gpu_scope(nu::StringView name);
+  void end_gpu_scope();
+
   void begin_frame();
+  // Begin a frame that only changes a rectangle of the rendering area, from the top left.  If
+  // frames are retained, all rendering in the frame is clipped to it; otherwise the whole area is
+  // drawn as usual.
+  void begin_frame(const fl::Pos& damage_position, const fl::Size& damage_size);
   void end_frame();
 
   void clear(const Color& color);
@@ -62,17 +128,34 @@ public:
             VertexBufferId vertex_buffer_id, const TextureSlots& textures = {},
             const UniformBuffer& uniforms = {});
 
+  // Draw `vertex_count` vertices for each of `instance_count` instances.  Per-instance data comes
+  // from a vertex buffer created with a divisor; the vertex shader can use `gl_VertexID` for the
+  // rest.
+  void draw_instanced(DrawType draw_type, U32 vertex_count, U32 instance_count,
+                      ProgramId program_id, VertexBufferId vertex_buffer_id,
+                      const TextureSlots& textures = {}, const UniformBuffer& uniforms = {});
+
   void draw(DrawType draw_type, U32 index_count, ProgramId program_id,
             VertexBufferId vertex_buffer_id, IndexBufferId index_buffer_id,
             const TextureSlots& textures = {}, const UniformBuffer& uniforms = {});
 
+  // Draw `index_count` indices starting at `index_offset` in the index buffer.
+  void draw_range(DrawType draw_type, U32 index_offset, U32 index_count, ProgramId program_id,
+                  VertexBufferId vertex_buffer_id, IndexBufferId index_buffer_id,
+                  const TextureSlots& textures = {}, const UniformBuffer& uniforms = {});
+
 private:
   struct ProgramData {
     U32 id = 0;
+    // Location of every uniform in this program, indexed by uniform id and filled in on first use.
+    nu::DynamicArray<I32> uniform_locations;
   };
 
   struct VertexBufferData {
+    // The vertex array object.
     U32 id = 0;
+    U32 buffer_id = 0;
+    MemSize capacity = 0;
   };
 
   struct IndexBufferData {
@@ -83,14 +166,43 @@ private:
   struct TextureData {
     U32 id = 0;
     fl::Size size;
+    TextureFormat format = TextureFormat::Unknown;
   };
 
   struct UniformData {
-    nu::StaticString<128> name;
+    nu::StaticString<kMaxUniformNameLength + 1> name;
+    U64 hash;
   };
 
-  void pre_draw(ProgramId program_id, const TextureSlots& textures, const UniformBuffer& uniforms);
-  void post_draw();
+  I32 uniform_location(ProgramData* program_data, UniformId uniform_id);
+
+  // True if the context is current on another thread, which GL calls have to be run on.
+  NU_NO_DISCARD bool needs_render_thread() const;
+  void run_on_render_thread(nu::Function<void()> task);
+
+  void execute_begin_frame(const fl::Pos& damage_position, const fl::Size& damage_size);
+  void execute_end_frame();
+  void execute_clear(const Color& color);
+  // Draw now, or record the draw if recording.
+  void submit_draw(CommandType type, const DrawCommand& draw, const UniformBuffer& uniforms);
+  void execute_draw(CommandType type, const DrawCommand& draw);
+  void execute_vertex_buffer_data(VertexBufferId id, const void* data, MemSize data_size);
+  void execute_stream_vertex_buffer_data(VertexBufferId id, const void* data, MemSize data_size);
+  void execute_index_buffer_data(IndexBufferId id, const void* data, MemSize data_size);
+  void execute_texture_sub_data(TextureId id, const fl::Pos& position, const fl::Size& size,
+                                const void* data);
+
+  // Returns false if the retained frame buffer was (re)created, so it has no contents yet.
+  bool update_retained_frame_buffer();
+  void delete_retained_frame_buffer();
+  void grow_uniform_table();
+
+  // Returns the program's data, or null if there is no program to draw with.
+  ProgramData* pre_draw(ProgramId program_id, const TextureSlots& textures,
+                        const RenderState& state);
+  void apply_uniform(ProgramData* program_data, UniformId uniform_id, ComponentType type,
+                     U32 count, const void* values);
+  void post_draw(const RenderState& state);
 
   fl::Size size_;
 
@@ -98,9 +210,26 @@ private:
   nu::DynamicArray<VertexBufferData> vertex_buffers_;
   nu::DynamicArray<IndexBufferData> index_buffers_;
   nu::DynamicArray<TextureData> textures_;
+  // Uniforms are created while recording and read while executing, so they are guarded by
+  // `uniforms_lock_`.
+  std::mutex uniforms_lock_;
   nu::DynamicArray<UniformData> uniforms_;
+  // Open addressing table of indices into `uniforms_`, sized to a power of two.
+  nu::DynamicArray<U32> uniform_table_;
 
   RenderState render_state_;
+  FrameAllocator frame_allocator_;
+  GpuProfiler gpu_profiler_;
+
+  FramePacket* recording_ = nullptr;
+  RenderThread* render_thread_ = nullptr;
+
+  // The offscreen frame buffer frames are retained in.
+  bool retain_frames_ = false;
+  U32 frame_buffer_ = 0;
+  U32 color_render_buffer_ = 0;
+  U32 depth_render_buffer_ = 0;
+  fl::Size frame_buffer_size_;
 };
 
 }  // namespace ca
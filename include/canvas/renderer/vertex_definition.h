@@ -11,7 +11,7 @@ namespace ca {
 
 class VertexAttribute {
 public:
-  VertexAttribute(ComponentType type, ComponentCount count);
+  VertexAttribute(ComponentType type, ComponentCount count, bool normalized = false);
 
   auto getType() const -> ComponentType {
     return m_type;
@@ -25,10 +25,16 @@ public:
     return m_sizeInBytes;
   }
 
+  // Integer components are mapped to [0, 1] (or [-1, 1] when signed) in the shader.
+  auto isNormalized() const -> bool {
+    return m_normalized;
+  }
+
 private:
   ComponentType m_type;
   ComponentCount m_count;
   U32 m_sizeInBytes;
+  bool m_normalized;
 };
 
 class VertexDefinition {
@@ -57,14 +63,26 @@ public:
     return m_attributes.end();
   }
 
-  auto addAttribute(ComponentType type, ComponentCount componentCount) -> void {
-    auto result = m_attributes.emplaceBack(type, componentCount);
+  auto addAttribute(ComponentType type, ComponentCount componentCount, bool normalized = false)
+      -> void {
+    auto result = m_attributes.emplaceBack(type, componentCount, normalized);
     m_stride += result.element().getSizeInBytes();
   }
 
+  // Number of instances drawn before the attributes advance to the next element.  0 (the
+  // default) advances per vertex, 1 makes every element the data for one instance.
+  auto getDivisor() const -> U32 {
+    return m_divisor;
+  }
+
+  auto setDivisor(U32 divisor) -> void {
+    m_divisor = divisor;
+  }
+
 private:
   AttributeList m_attributes;
   U32 m_stride = 0;
+  U32 m_divisor = 0;
 };
 
 }  // namespace ca
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "canvas/scene/culling.h"
+#include "canvas/scene/ray.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/function.h"
+#include "nucleus/macros.h"
+
+namespace ca {
+
+using BvhHandle = U32;
+constexpr BvhHandle kInvalidBvhHandle = ~0u;
+
+struct BvhRayHit {
+  BvhHandle handle = kInvalidBvhHandle;
+  U32 user_data = 0;
+  F32 distance = 0.0f;
+};
+
+// Called for every object whose box is hit closer than the current best hit.  Return false to
+// reject the object, or true after writing the exact distance to `distance`, which holds the
+// distance to the box on entry.
+using BvhRayFilter = nu::Function<bool(U32 user_data, const Ray& ray, F32* distance)>;
+
+// Bounding volume hierarchy over axis aligned boxes, built with binned SAH.  Every object carries
+// a `user_data` value, usually an index into the caller's renderables, which is what queries
+// return.
+//
+// Changes are batched: `insert`, `update` and `remove` only record what changed and `refit`
+// brings the tree up to date.  Moving or removing objects only refits the nodes above them;
+// inserting objects, or changing more objects than the tree holds since the last build, rebuilds
+// the tree.  Queries see the tree as of the last `refit`.  Handles of removed objects are reused
+// after the next rebuild.
+class Bvh {
+public:
+  NU_DELETE_COPY(Bvh);
+  NU_DEFAULT_MOVE(Bvh);
+
+  Bvh();
+
+  NU_NO_DISCARD MemSize size() const {
+    return object_count_;
+  }
+
+  BvhHandle insert(const Aabb& bounds, U32 user_data);
+  void update(BvhHandle handle, const Aabb& bounds);
+  void remove(BvhHandle handle);
+
+  NU_NO_DISCARD const Aabb& bounds(BvhHandle handle) const;
+  NU_NO_DISCARD U32 user_data(BvhHandle handle) const;
+
+  void refit();
+  void rebuild();
+
+  // Append the `user_data` of every object that intersects the frustum or the box.
+  void query_frustum(const Frustum& frustum, nu::DynamicArray<U32>* result) const;
+  void query_box(const Aabb& aabb, nu::DynamicArray<U32>* result) const;
+
+  // Find the closest object hit by the ray within `max_distance`.  Without a filter the distance
+  // is where the ray enters the object's box.
+  bool ray_cast(const Ray& ray, F32 max_distance, BvhRayHit* hit,
+                const BvhRayFilter& filter = {}) const;
+
+private:
+  struct Node {
+    Aabb bounds;
+    U32 parent;
+    // Index of the left child; the right child follows it.  0 for leaves, since the root is never
+    // a child.
+    U32 left;
+    // Range of `node_objects_` covered by this node, for leaves and interior nodes alike.
+    U32 first;
+    U32 count;
+  };
+
+  struct Object {
+    Aabb bounds;
+    U32 user_data;
+    U32 leaf;
+    bool alive;
+  };
+
+  void build_node(U32 node_index, U32 depth);
+  void refit_leaf(U32 node_index);
+  void append_objects(const Node& node, nu::DynamicArray<U32>* result) const;
+
+  nu::DynamicArray<Node> nodes_;
+  nu::DynamicArray<U32> node_objects_;
+  nu::DynamicArray<Object> objects_;
+  nu::DynamicArray<fl::Vec3> centroids_;
+  nu::DynamicArray<BvhHandle> free_handles_;
+  nu::DynamicArray<BvhHandle> removed_handles_;
+  nu::DynamicArray<U32> dirty_leaves_;
+  MemSize object_count_ = 0;
+  MemSize updates_since_build_ = 0;
+  bool needs_rebuild_ = false;
+};
+
+}  // namespace ca
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "floats/mat4.h"
+#include "floats/plane.h"
+#include "floats/vec3.h"
+#include "nucleus/types.h"
+
+namespace ca {
+
+struct Aabb {
+  fl::Vec3 min;
+  fl::Vec3 max;
+};
+
+struct BoundingSphere {
+  fl::Vec3 center;
+  F32 radius;
+};
+
+// The six planes of a view volume with their normals pointing inwards.  A point `p` is on the
+// inside of a plane when `dot(plane.normal, p) >= plane.distance`.
+struct Frustum {
+  enum : U32 {
+    Left,
+    Right,
+    Bottom,
+    Top,
+    Near,
+    Far,
+    PlaneCount,
+  };
+
+  fl::Plane planes[PlaneCount];
+};
+
+// Bounding spheres stored as separate arrays, so that several objects can be tested at once.
+struct SphereBoundsArrays {
+  const F32* center_x;
+  const F32* center_y;
+  const F32* center_z;
+  const F32* radius;
+};
+
+// Axis aligned boxes stored as separate arrays, so that several objects can be tested at once.
+struct AabbBoundsArrays {
+  const F32* min_x;
+  const F32* min_y;
+  const F32* min_z;
+  const F32* max_x;
+  const F32* max_y;
+  const F32* max_z;
+};
+
+// Extract the planes of the volume a view projection matrix maps to clip space.  Pass a
+// model-view-projection matrix to get the planes in model space instead.
+Frustum extract_frustum(const fl::Mat4& view_projection);
+
+bool is_visible(const Frustum& frustum, const BoundingSphere& sphere);
+bool is_visible(const Frustum& frustum, const Aabb& aabb);
+
+// Test the objects in `[first, first + count)` and write the indices of the ones that intersect
+// the frustum to `visible`, which must have room for `count` entries.  Returns the number of
+// visible objects.  Bounds are only read, so disjoint ranges can be culled on separate threads,
+// each into its own output.
+U32 cull_spheres(const Frustum& frustum, const SphereBoundsArrays& bounds, U32 first, U32 count,
+                 U32* visible);
+U32 cull_aabbs(const Frustum& frustum, const AabbBoundsArrays& bounds, U32 first, U32 count,
+               U32* visible);
+
+}  // namespace ca
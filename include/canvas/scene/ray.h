@@ -0,0 +1,25 @@
+#pragma once
+
+#include "canvas/scene/culling.h"
+#include "floats/mat4.h"
+#include "floats/pos.h"
+#include "floats/size.h"
+#include "floats/vec3.h"
+
+namespace ca {
+
+struct Ray {
+  fl::Vec3 origin;
+  fl::Vec3 direction;
+};
+
+// Distance along the ray to where it enters `aabb`, or 0 if the origin is inside the box.  Returns
+// false if the ray misses the box or only hits it further than `max_distance` away.
+bool intersect_ray_aabb(const Ray& ray, const Aabb& aabb, F32 max_distance, F32* distance);
+
+// The ray through a window position, e.g. from a `MouseEvent`, for a camera with the given view
+// projection matrix.  The origin is on the near plane and the direction is normalized.
+Ray screen_ray(const fl::Pos& position, const fl::Size& viewport,
+               const fl::Mat4& view_projection);
+
+}  // namespace ca
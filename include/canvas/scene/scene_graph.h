@@ -0,0 +1,83 @@
+#pragma once
+
+#include "floats/mat4.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+
+namespace ca {
+
+using SceneNodeId = U32;
+constexpr SceneNodeId kInvalidSceneNode = ~0u;
+
+// Hierarchy of transforms.  Node data is stored as separate arrays in depth first order, so every
+// subtree is a contiguous range that follows its root.  `update` only recomputes the world
+// transforms of subtrees whose local transforms changed, so the cost follows the number of nodes
+// that moved, not the size of the graph.
+//
+// Creating, destroying or reparenting nodes re-sorts the arrays on the next `update`.  Node ids
+// stay stable across that; positions in `world_transforms()` do not.
+class SceneGraph {
+public:
+  NU_DELETE_COPY(SceneGraph);
+  NU_DEFAULT_MOVE(SceneGraph);
+
+  SceneGraph();
+
+  NU_NO_DISCARD MemSize size() const {
+    return order_.size();
+  }
+
+  SceneNodeId create_node(SceneNodeId parent = kInvalidSceneNode,
+                          const fl::Mat4& local_transform = fl::Mat4::identity);
+  // Destroys the node and everything below it.
+  void destroy_node(SceneNodeId node);
+
+  void set_parent(SceneNodeId node, SceneNodeId parent);
+  NU_NO_DISCARD SceneNodeId parent(SceneNodeId node) const;
+
+  void set_local_transform(SceneNodeId node, const fl::Mat4& local_transform);
+  NU_NO_DISCARD const fl::Mat4& local_transform(SceneNodeId node) const;
+
+  // Valid after `update`.
+  NU_NO_DISCARD const fl::Mat4& world_transform(SceneNodeId node) const;
+
+  void update();
+
+  // World transforms of all nodes in depth first order, for uploading in bulk.  Use `position` to
+  // find a node in it.
+  NU_NO_DISCARD const fl::Mat4* world_transforms() const {
+    return world_.data();
+  }
+  NU_NO_DISCARD U32 position(SceneNodeId node) const;
+
+  // Gather the world transforms of `count` nodes into `destination`, e.g. an instance buffer.
+  void copy_world_transforms(const SceneNodeId* nodes, MemSize count,
+                             fl::Mat4* destination) const;
+
+private:
+  struct NodeInfo {
+    SceneNodeId parent;
+    U32 position;
+    bool alive;
+  };
+
+  void sort_nodes();
+  void update_range(U32 first, U32 end);
+
+  // Indexed by node id.
+  nu::DynamicArray<NodeInfo> nodes_;
+  nu::DynamicArray<SceneNodeId> free_nodes_;
+
+  // Indexed by position in depth first order.
+  nu::DynamicArray<SceneNodeId> order_;
+  nu::DynamicArray<U32> parent_positions_;
+  nu::DynamicArray<U32> subtree_sizes_;
+  nu::DynamicArray<fl::Mat4> local_;
+  nu::DynamicArray<fl::Mat4> world_;
+  nu::DynamicArray<U8> dirty_;
+
+  nu::DynamicArray<U32> dirty_positions_;
+  bool needs_sort_ = false;
+};
+
+}  // namespace ca
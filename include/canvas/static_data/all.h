@@ -4,7 +4,17 @@
 
 namespace ca {
 
-extern const U8 monoFont[];
-extern const MemSize monoFontSize;
+// The debug font's glyph sheet: 32 x 8 glyphs of 8 x 16 pixels, starting at the space.  Embedded
+// at build time from `assets/Fixedsys.1bpp` at one bit per pixel; expand it with
+// `expandMonochrome` before using it as a texture.
+constexpr I32 kMonoFontWidth = 256;
+constexpr I32 kMonoFontHeight = 128;
+
+extern const U8 monoFontBits[];
+extern const MemSize monoFontBitsSize;
+
+// Expand an image stored at one bit per pixel, rows top to bottom and the most significant bit
+// first, to one byte per pixel of 0 or 255.  `pixels` must hold `width * height` bytes.
+void expandMonochrome(const U8* bits, I32 width, I32 height, U8* pixels);
 
 }  // namespace ca
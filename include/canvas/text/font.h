@@ -0,0 +1,97 @@
+#pragma once
+
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+#include "nucleus/types.h"
+
+namespace ca {
+
+// Vertical metrics in font units, with y pointing up from the baseline.
+struct FontMetrics {
+  F32 units_per_em = 0.0f;
+  F32 ascender = 0.0f;
+  F32 descender = 0.0f;
+  F32 line_gap = 0.0f;
+
+  // Bounds of all glyphs in the font.
+  F32 x_min = 0.0f;
+  F32 y_min = 0.0f;
+  F32 x_max = 0.0f;
+  F32 y_max = 0.0f;
+};
+
+// A straight piece of a glyph outline in font units.  Curves are flattened into these.
+struct OutlineSegment {
+  F32 x0;
+  F32 y0;
+  F32 x1;
+  F32 y1;
+};
+
+// Reads glyph outlines and metrics from TrueType (glyf based) font data.
+class Font {
+public:
+  NU_DELETE_COPY(Font);
+  NU_DEFAULT_MOVE(Font);
+
+  Font() = default;
+
+  // Copies `data` and validates the tables that are needed.  Returns false if the data is not a
+  // usable TrueType font.
+  bool load(const void* data, MemSize size);
+  bool load_from_file(const char* path);
+
+  NU_NO_DISCARD bool is_loaded() const {
+    return glyph_count_ > 0;
+  }
+
+  NU_NO_DISCARD const nu::DynamicArray<U8>& data() const {
+    return data_;
+  }
+
+  NU_NO_DISCARD const FontMetrics& metrics() const {
+    return metrics_;
+  }
+
+  NU_NO_DISCARD U32 glyph_count() const {
+    return glyph_count_;
+  }
+
+  // Returns 0, the missing glyph, for code points that are not in the font.
+  NU_NO_DISCARD U32 glyph_index(U32 codepoint) const;
+
+  NU_NO_DISCARD F32 advance(U32 glyph) const;
+
+  // Appends the outline of `glyph` to `segments`, flattening curves to `curve_steps` lines each.
+  // Returns false if the glyph data is malformed.
+  bool glyph_outline(U32 glyph, nu::DynamicArray<OutlineSegment>* segments,
+                     U32 curve_steps = 8) const;
+
+private:
+  bool glyph_range(U32 glyph, MemSize* begin, MemSize* end) const;
+  bool simple_outline(MemSize begin, MemSize end, I32 contour_count,
+                      nu::DynamicArray<OutlineSegment>* segments, U32 curve_steps) const;
+  bool composite_outline(MemSize begin, MemSize end, nu::DynamicArray<OutlineSegment>* segments,
+                         U32 curve_steps, U32 depth) const;
+  bool outline(U32 glyph, nu::DynamicArray<OutlineSegment>* segments, U32 curve_steps,
+               U32 depth) const;
+
+  U16 read_u16(MemSize offset) const;
+  U32 read_u32(MemSize offset) const;
+
+  nu::DynamicArray<U8> data_;
+  FontMetrics metrics_;
+  U32 glyph_count_ = 0;
+  U32 hmetric_count_ = 0;
+  bool long_loca_ = false;
+
+  // Table offsets into `data_`.  `cmap_` is the character map subtable in use.
+  MemSize cmap_ = 0;
+  U16 cmap_format_ = 0;
+  MemSize glyf_ = 0;
+  MemSize glyf_size_ = 0;
+  MemSize loca_ = 0;
+  MemSize hmtx_ = 0;
+};
+
+}  // namespace ca
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "canvas/renderer/types.h"
+#include "canvas/text/sdf_atlas.h"
+#include "canvas/utils/lru_table.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+
+namespace ca {
+
+class Font;
+class Renderer;
+
+struct GlyphCacheSettings {
+  F32 glyph_size = 32.0f;
+  F32 spread = 4.0f;
+
+  // Pages are square single channel textures, allocated as they are needed.
+  I32 page_size = 1024;
+
+  // Bytes of texture memory the pages may use.  Once all of it is used, the least recently used
+  // glyphs are replaced.
+  MemSize texture_budget = 4 * 1024 * 1024;
+};
+
+struct GlyphCacheStatistics {
+  U64 hits = 0;
+  U64 misses = 0;
+  U64 evictions = 0;
+  // Lookups that failed because every slot was already used in the current frame.
+  U64 overflows = 0;
+  MemSize page_count = 0;
+  MemSize glyph_count = 0;
+
+  NU_NO_DISCARD F32 hit_rate() const {
+    U64 lookups = hits + misses;
+    return lookups ? static_cast<F32>(hits) / static_cast<F32>(lookups) : 0.0f;
+  }
+};
+
+struct CachedGlyph {
+  SdfGlyph glyph;
+  TextureId texture;
+};
+
+// Signed distance field glyphs rasterized on first use into fixed size cells of texture pages.
+// New glyphs are uploaded with a sub image update of their cell only.  When the texture budget is
+// used up, the least recently used glyph gives up its cell; glyphs used in the current frame are
+// never replaced.
+class GlyphCache {
+public:
+  NU_DELETE_COPY_AND_MOVE(GlyphCache);
+
+  // The font must outlive the cache.
+  GlyphCache(Renderer* renderer, const Font* font, const GlyphCacheSettings& settings = {});
+  ~GlyphCache();
+
+  void begin_frame();
+
+  // Returns null if the glyph could not be placed in this frame.  The result is valid until the
+  // next call.
+  const CachedGlyph* glyph(U32 codepoint);
+
+  // Fill in the size and placement of a glyph without placing it in a page, for when `glyph`
+  // returns null.  Returns false if the glyph has no outline, in which case only the advance is
+  // set.
+  bool measure(U32 codepoint, SdfGlyph* glyph);
+
+  NU_NO_DISCARD F32 glyph_size() const {
+    return settings_.glyph_size;
+  }
+
+  NU_NO_DISCARD I32 page_size() const {
+    return settings_.page_size;
+  }
+
+  // Vertical metrics in ems.
+  NU_NO_DISCARD F32 ascender() const {
+    return ascender_;
+  }
+
+  NU_NO_DISCARD F32 line_height() const {
+    return line_height_;
+  }
+
+  NU_NO_DISCARD const GlyphCacheStatistics& statistics() const {
+    return statistics_;
+  }
+
+private:
+  // Returns `LruTable::kInvalidEntry` if every slot is used in this frame.
+  U32 acquire_slot();
+  bool add_page();
+  void rasterize(CachedGlyph* slot, U32 codepoint);
+
+  Renderer* renderer_;
+  const Font* font_;
+  GlyphCacheSettings settings_;
+  F32 ascender_ = 0.0f;
+  F32 line_height_ = 0.0f;
+
+  // Every glyph gets a cell big enough for the largest glyph in the font.
+  I32 cell_width_ = 0;
+  I32 cell_height_ = 0;
+  I32 cells_per_row_ = 0;
+  U32 cells_per_page_ = 0;
+  MemSize max_pages_ = 0;
+
+  nu::DynamicArray<TextureId> pages_;
+  // Glyphs keyed by code point.  Slots are the cells of the pages, in order.
+  LruTable table_;
+  nu::DynamicArray<CachedGlyph> slots_;
+  U64 frame_ = 0;
+
+  nu::DynamicArray<OutlineSegment> segments_;
+  nu::DynamicArray<U8> cell_pixels_;
+
+  GlyphCacheStatistics statistics_;
+};
+
+}  // namespace ca
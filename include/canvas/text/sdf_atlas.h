@@ -0,0 +1,123 @@
+#pragma once
+
+#include "canvas/text/font.h"
+#include "floats/size.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+
+namespace ca {
+
+struct SdfAtlasSettings {
+  // Pixels per em that glyphs are rasterized at.  Text scales well above and below this, since the
+  // atlas stores distances rather than coverage.
+  F32 glyph_size = 32.0f;
+
+  // Distance in atlas pixels that maps to the full range of a texel.  Also the padding around
+  // each glyph.
+  F32 spread = 4.0f;
+
+  U32 first_codepoint = 32;
+  U32 last_codepoint = 126;
+
+  U32 atlas_width = 256;
+};
+
+// Where a glyph is in the atlas and how to place it.  Placement values are in ems relative to the
+// pen position on the baseline, with y pointing up.
+struct SdfGlyph {
+  U32 codepoint;
+  U16 x;
+  U16 y;
+  U16 width;
+  U16 height;
+  F32 left;
+  F32 top;
+  F32 advance;
+};
+
+// Fill a `width` x `height` bitmap (rows `stride` bytes apart, top row first) with the signed
+// distance to the outline made up of `segments`.  Pixel (0, 0) is at `origin_x, origin_y` in
+// outline units and `scale` is pixels per unit.  Texels are 128 on the outline, larger inside
+// (by non-zero winding) and saturate `spread` pixels away from it.
+void generate_sdf(const OutlineSegment* segments, MemSize segment_count, F32 origin_x,
+                  F32 origin_y, F32 scale, F32 spread, U8* pixels, I32 width, I32 height,
+                  I32 stride);
+
+// Fill in the bitmap size and placement of `glyph` (but not its position in an atlas) for the
+// font's glyph `glyph_index` and put its outline in `segments`.  Returns false if the glyph has no
+// outline, like a space, in which case only the advance is set.
+bool measure_sdf_glyph(const Font& font, U32 glyph_index, F32 glyph_size, F32 spread,
+                       SdfGlyph* glyph, nu::DynamicArray<OutlineSegment>* segments);
+
+// Rasterize a glyph measured by `measure_sdf_glyph` into `pixels`.
+void rasterize_sdf_glyph(const Font& font, const SdfGlyph& glyph,
+                         const nu::DynamicArray<OutlineSegment>& segments, F32 glyph_size,
+                         F32 spread, U8* pixels, I32 stride);
+
+// Single channel signed distance field atlas of a range of glyphs from a font.
+class SdfAtlas {
+public:
+  NU_DELETE_COPY(SdfAtlas);
+  NU_DEFAULT_MOVE(SdfAtlas);
+
+  SdfAtlas() = default;
+
+  bool build(const Font& font, const SdfAtlasSettings& settings);
+
+  // Read the atlas from `cache_path` if it was built from the same font and settings, otherwise
+  // build it and write it there, so the glyphs are only rasterized once.
+  bool load_or_build(const Font& font, const SdfAtlasSettings& settings, const char* cache_path);
+
+  bool save(const char* path) const;
+  bool load(const char* path);
+
+  // Identifies the font data and settings that the atlas was built from.
+  NU_NO_DISCARD U64 source_hash() const {
+    return source_hash_;
+  }
+
+  NU_NO_DISCARD const fl::Size& size() const {
+    return size_;
+  }
+
+  NU_NO_DISCARD const nu::DynamicArray<U8>& pixels() const {
+    return pixels_;
+  }
+
+  NU_NO_DISCARD F32 glyph_size() const {
+    return glyph_size_;
+  }
+
+  NU_NO_DISCARD F32 spread() const {
+    return spread_;
+  }
+
+  // Vertical metrics in ems.
+  NU_NO_DISCARD F32 ascender() const {
+    return ascender_;
+  }
+
+  NU_NO_DISCARD F32 line_height() const {
+    return line_height_;
+  }
+
+  // Returns null if the code point is not in the atlas.
+  NU_NO_DISCARD const SdfGlyph* glyph(U32 codepoint) const;
+
+private:
+  static U64 hash_source(const Font& font, const SdfAtlasSettings& settings);
+
+  U64 source_hash_ = 0;
+  fl::Size size_;
+  F32 glyph_size_ = 0.0f;
+  F32 spread_ = 0.0f;
+  F32 ascender_ = 0.0f;
+  F32 line_height_ = 0.0f;
+  U32 first_codepoint_ = 0;
+
+  // Indexed by code point minus `first_codepoint_`.
+  nu::DynamicArray<SdfGlyph> glyphs_;
+  nu::DynamicArray<U8> pixels_;
+};
+
+}  // namespace ca
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "canvas/utils/lru_table.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/function.h"
+#include "nucleus/macros.h"
+#include "nucleus/text/string_view.h"
+#include "nucleus/types.h"
+
+namespace ca {
+
+// How to place a glyph relative to the pen on the baseline, in ems with y pointing up.
+struct GlyphPlacement {
+  F32 advance = 0.0f;
+  F32 left = 0.0f;
+  F32 top = 0.0f;
+  F32 width = 0.0f;
+  F32 height = 0.0f;
+  // False for glyphs that only advance the pen, like space.
+  bool visible = false;
+};
+
+// Returns false for code points the font can't place at all; they are skipped.
+using GlyphPlacementFunction = nu::Function<bool(U32 codepoint, GlyphPlacement* placement)>;
+
+struct LayoutFont {
+  // Identifies the font in layout cache keys.
+  U64 key = 0;
+  F32 ascender = 0.0f;
+  F32 line_height = 0.0f;
+  GlyphPlacementFunction placement;
+};
+
+// A glyph quad relative to the top left of the text, with y pointing down.
+struct LayoutGlyph {
+  U32 codepoint;
+  F32 left;
+  F32 top;
+  F32 right;
+  F32 bottom;
+};
+
+struct TextLayout {
+  nu::DynamicArray<LayoutGlyph> glyphs;
+  F32 width = 0.0f;
+  F32 height = 0.0f;
+};
+
+// Lay `text` out at `size` units per em.  Lines break at newlines and, if `wrap_width` is more
+// than 0, at the last space before a line gets wider than `wrap_width`.
+void layout_text(const LayoutFont& font, nu::StringView text, F32 size, F32 wrap_width,
+                 TextLayout* layout);
+
+struct TextLayoutCacheStatistics {
+  U64 hits = 0;
+  U64 misses = 0;
+  U64 evictions = 0;
+  MemSize entry_count = 0;
+  MemSize bytes = 0;
+
+  NU_NO_DISCARD F32 hit_rate() const {
+    U64 lookups = hits + misses;
+    return lookups ? static_cast<F32>(hits) / static_cast<F32>(lookups) : 0.0f;
+  }
+};
+
+// Keeps the layouts of recently drawn strings, keyed by the text, font, size and wrap width, so
+// text that doesn't change is only laid out once.  The least recently used layouts are dropped to
+// stay within the byte budget, except those used in the current frame.  One cache can be shared
+// by everything that draws text.
+class TextLayoutCache {
+public:
+  NU_DELETE_COPY(TextLayoutCache);
+  NU_DEFAULT_MOVE(TextLayoutCache);
+
+  explicit TextLayoutCache(MemSize budget = 1024 * 1024);
+
+  NU_NO_DISCARD MemSize budget() const {
+    return budget_;
+  }
+
+  void set_budget(MemSize bytes);
+
+  NU_NO_DISCARD const TextLayoutCacheStatistics& statistics() const {
+    return statistics_;
+  }
+
+  void begin_frame();
+
+  // The result is valid until the next call.
+  const TextLayout& layout(const LayoutFont& font, nu::StringView text, F32 size,
+                           F32 wrap_width = 0.0f);
+
+private:
+  struct Entry {
+    TextLayout layout;
+    MemSize bytes;
+    // What the layout was made from, so lookups with the same key are told apart.
+    U64 font_key;
+    F32 size;
+    F32 wrap_width;
+    nu::DynamicArray<char> text;
+  };
+
+  void evict_to_budget();
+
+  MemSize budget_;
+  U64 frame_ = 0;
+
+  LruTable table_;
+  // Indexed like the entries of `table_`.
+  nu::DynamicArray<Entry> entries_;
+
+  TextLayoutCacheStatistics statistics_;
+};
+
+}  // namespace ca
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "canvas/renderer/frame_allocator.h"
+#include "canvas/renderer/types.h"
+#include "canvas/text/text_layout.h"
+#include "canvas/utils/color.h"
+#include "floats/mat4.h"
+#include "floats/size.h"
+#include "floats/vec2.h"
+#include "nucleus/macros.h"
+#include "nucleus/text/string_view.h"
+
+namespace ca {
+
+class GlyphCache;
+class Renderer;
+class SdfAtlas;
+struct SdfGlyph;
+
+// Draws UTF-8 text at any size from signed distance field glyphs, either from a static atlas or
+// from a glyph cache for large character sets.  Text is turned into quads as it is submitted, from
+// a layout that comes from the layout cache if one is set, and drawn by `render`, with one draw for
+// each run of text with the same transform and texture.
+class TextRenderer {
+public:
+  NU_DELETE_COPY_AND_MOVE(TextRenderer);
+
+  explicit TextRenderer(Renderer* renderer);
+
+  // The atlas or cache must outlive the renderer.
+  bool initialize(const SdfAtlas* atlas);
+  bool initialize(GlyphCache* glyph_cache);
+
+  // Share layouts with everything else using `cache`, which must outlive the renderer.  Without
+  // one, text is laid out again every time it is drawn.
+  void set_layout_cache(TextLayoutCache* cache) {
+    layout_cache_ = cache;
+  }
+
+  // `position` is the top left of the first line, with y pointing down, and `size` is the height
+  // of an em in the units of `transform`.  Lines wider than `wrap_width` are wrapped at spaces, if
+  // it is more than 0.
+  void draw_text(const fl::Mat4& transform, const fl::Vec2& position, F32 size,
+                 nu::StringView text, const Color& color, F32 wrap_width = 0.0f);
+
+  // The glyph quads and bounds `draw_text` would use.  Valid until the next layout.
+  const TextLayout& layout(nu::StringView text, F32 size, F32 wrap_width = 0.0f);
+
+  // Width of the widest line of `text` at `size`.
+  NU_NO_DISCARD F32 text_width(nu::StringView text, F32 size) {
+    return layout(text, size).width;
+  }
+
+  // Draw the text submitted this frame.  Also starts a new frame for the glyph cache, so glyphs
+  // drawn in this frame may be replaced from now on.
+  void render();
+
+private:
+  struct Vertex {
+    F32 x;
+    F32 y;
+    F32 u;
+    F32 v;
+    U32 color;
+  };
+
+  struct Batch {
+    fl::Mat4 transform;
+    TextureId texture;
+    U32 first_vertex;
+    U32 vertex_count;
+  };
+
+  bool create_resources();
+  bool place_glyph(U32 codepoint, GlyphPlacement* placement) const;
+  const SdfGlyph* find_glyph(U32 codepoint, TextureId* texture) const;
+  Batch& batch_for(const fl::Mat4& transform, TextureId texture);
+
+  Renderer* renderer_;
+  const SdfAtlas* atlas_ = nullptr;
+  GlyphCache* glyph_cache_ = nullptr;
+
+  F32 glyph_size_ = 0.0f;
+  F32 ascender_ = 0.0f;
+  F32 line_height_ = 0.0f;
+  fl::Size texture_size_;
+
+  LayoutFont layout_font_;
+  TextLayoutCache* layout_cache_ = nullptr;
+  TextLayout scratch_layout_;
+
+  VertexBufferId vertex_buffer_id_;
+  TextureId texture_id_;
+  ProgramId program_id_;
+  UniformId transform_uniform_id_;
+
+  FrameArray<Vertex> vertices_;
+  FrameArray<Batch> batches_;
+};
+
+}  // namespace ca
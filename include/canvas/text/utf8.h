@@ -0,0 +1,56 @@
+#pragma once
+
+#include "nucleus/text/string_view.h"
+#include "nucleus/types.h"
+
+namespace ca {
+
+constexpr U32 kReplacementCharacter = 0xfffd;
+
+// Decode the code point starting at `*index` and advance past it.  Malformed sequences decode to
+// U+FFFD one byte at a time.
+inline U32 next_codepoint(nu::StringView text, MemSize* index) {
+  auto byte = [&](MemSize i) {
+    return static_cast<U32>(static_cast<U8>(text[i]));
+  };
+
+  MemSize i = *index;
+  U32 first = byte(i);
+  *index = i + 1;
+
+  if (first < 0x80) {
+    return first;
+  }
+
+  MemSize length;
+  U32 codepoint;
+  if ((first & 0xe0) == 0xc0) {
+    length = 2;
+    codepoint = first & 0x1f;
+  } else if ((first & 0xf0) == 0xe0) {
+    length = 3;
+    codepoint = first & 0x0f;
+  } else if ((first & 0xf8) == 0xf0) {
+    length = 4;
+    codepoint = first & 0x07;
+  } else {
+    return kReplacementCharacter;
+  }
+
+  if (i + length > text.length()) {
+    return kReplacementCharacter;
+  }
+
+  for (MemSize k = 1; k < length; ++k) {
+    U32 next = byte(i + k);
+    if ((next & 0xc0) != 0x80) {
+      return kReplacementCharacter;
+    }
+    codepoint = (codepoint << 6) | (next & 0x3f);
+  }
+
+  *index = i + length;
+  return codepoint;
+}
+
+}  // namespace ca
@@ -22,6 +22,17 @@ struct Color {
   Color(F32 r, F32 g, F32 b, F32 a = 1.0f) : r{r}, g{g}, b{b}, a{a} {}
 };
 
+// Pack into 8 bits per channel, with red in the lowest byte so that the bytes in memory are in RGBA
+// order on little endian machines.
+inline U32 pack_rgba8(const Color& color) {
+  auto channel = [](F32 value) -> U32 {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return static_cast<U32>(value * 255.0f + 0.5f);
+  };
+  return channel(color.r) | (channel(color.g) << 8) | (channel(color.b) << 16) |
+         (channel(color.a) << 24);
+}
+
 inline std::ostream& operator<<(std::ostream& os, const Color& value) {
   os << "{" << value.r << ", " << value.g << ", " << value.b << ", " << value.a << "}";
   return os;
@@ -11,16 +11,44 @@ struct PositionTextureCoords {
   fl::Vec2 texture_coords;
 };
 
+constexpr U32 kMaxGeometryLods = 8;
+
+// A range of the index buffer that draws one level of detail.
+struct GeometryLod {
+  U32 index_offset = 0;
+  U32 index_count = 0;
+
+  // Maximum deviation from the full detail surface, in model space units.
+  F32 error = 0.0f;
+};
+
 struct Geometry {
   VertexBufferId vertex_buffer_id;
   IndexBufferId index_buffer_id;
   U32 index_count = 0;
+
+  // Bounding sphere in model space.  A zero radius means the bounds are unknown.
+  fl::Vec3 bounds_center = fl::Vec3::zero;
+  F32 bounds_radius = 0.0f;
+
+  // Levels of detail sharing `index_buffer_id`, from full detail to coarsest.  Geometry without
+  // LODs draws `index_count` indices from the start of the buffer.
+  GeometryLod lods[kMaxGeometryLods] = {};
+  U32 lod_count = 0;
 };
 
 inline bool is_valid(const Geometry& geometry) {
   return geometry.vertex_buffer_id.is_valid() && geometry.index_buffer_id.is_valid();
 }
 
+// The index range to draw for `lod`, clamped to the levels the geometry has.
+inline GeometryLod lod_range(const Geometry& geometry, U32 lod) {
+  if (geometry.lod_count == 0) {
+    return {0, geometry.index_count, 0.0f};
+  }
+  return geometry.lods[lod < geometry.lod_count ? lod : geometry.lod_count - 1];
+}
+
 Geometry create_rectangle(Renderer* renderer, const fl::Vec2& top_left,
                           const fl::Vec2& bottom_right);
 
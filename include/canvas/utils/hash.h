@@ -0,0 +1,31 @@
+#pragma once
+
+#include "nucleus/types.h"
+
+namespace ca {
+
+constexpr U64 kHashSeed = 14695981039346656037ull;
+
+// 64-bit FNV-1a over a block of bytes.  Pass the result of a previous call as `seed` to hash
+// non-contiguous data as one value.
+inline U64 hash_bytes(const void* data, MemSize size, U64 seed = kHashSeed) {
+  auto* bytes = static_cast<const U8*>(data);
+  U64 hash = seed;
+  for (MemSize i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// Final avalanche step so that consecutive keys spread over the low bits of a table index.
+inline U64 hash_mix(U64 value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdull;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ull;
+  value ^= value >> 33;
+  return value;
+}
+
+}  // namespace ca
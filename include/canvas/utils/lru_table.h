@@ -0,0 +1,99 @@
+#pragma once
+
+#include "canvas/utils/hash.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+#include "nucleus/types.h"
+
+namespace ca {
+
+// Bookkeeping for caches with least recently used eviction.  Entries are indices, so the cache
+// keeps its values in an array of its own alongside.  Entries in use are found by a 64-bit key in
+// an open addressing table and linked from most to least recently used.  Entries that are not in
+// use are kept on a free list, so the values of evicted entries can be reused.
+class LruTable {
+public:
+  NU_DELETE_COPY(LruTable);
+  NU_DEFAULT_MOVE(LruTable);
+
+  static constexpr U32 kInvalidEntry = ~0u;
+
+  LruTable() = default;
+
+  // Entries in use.
+  NU_NO_DISCARD MemSize size() const {
+    return size_;
+  }
+
+  // Entries in use and free.
+  NU_NO_DISCARD MemSize capacity() const {
+    return entries_.size();
+  }
+
+  // Add an entry, ready to `insert`, and return its index.
+  U32 add_entry();
+
+  // Take an entry from the free list, ready to `insert`, and return its index, or `kInvalidEntry`
+  // if there are none.
+  U32 take_free_entry();
+
+  // Returns the entry in use with `key` for which `equal(index)` is true, or `kInvalidEntry`.
+  // Keys don't have to be unique, so `equal` can compare whatever they were computed from.
+  template <typename Equal>
+  U32 find(U64 key, Equal&& equal) const;
+
+  // Start using an entry, as the most recently used.
+  void insert(U32 index, U64 key, U64 frame);
+
+  // Make an entry in use the most recently used.
+  void touch(U32 index, U64 frame);
+
+  // The least recently used entry, or `kInvalidEntry` if there is none or it was used in `frame`.
+  NU_NO_DISCARD U32 evictable(U64 frame) const;
+
+  // Stop using an entry and put it on the free list.
+  void remove(U32 index);
+
+private:
+  struct Entry {
+    U64 key;
+    U64 last_used_frame;
+    U32 previous;
+    U32 next;
+  };
+
+  void remove_from_table(U32 index);
+  void grow_table();
+
+  void unlink(U32 index);
+  void link_front(U32 index);
+
+  nu::DynamicArray<Entry> entries_;
+  nu::DynamicArray<U32> free_entries_;
+  MemSize size_ = 0;
+  // Open addressing table of indices into `entries_`, sized to a power of two.
+  nu::DynamicArray<U32> table_;
+  U32 most_recent_ = kInvalidEntry;
+  U32 least_recent_ = kInvalidEntry;
+};
+
+template <typename Equal>
+U32 LruTable::find(U64 key, Equal&& equal) const {
+  if (table_.empty()) {
+    return kInvalidEntry;
+  }
+
+  MemSize mask = table_.size() - 1;
+  for (MemSize slot = hash_mix(key) & mask;; slot = (slot + 1) & mask) {
+    U32 index = table_[slot];
+    if (index == kInvalidEntry) {
+      return index;
+    }
+
+    if (entries_[index].key == key && equal(index)) {
+      return index;
+    }
+  }
+}
+
+}  // namespace ca
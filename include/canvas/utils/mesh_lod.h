@@ -0,0 +1,47 @@
+#pragma once
+
+#include "canvas/utils/geometry.h"
+#include "canvas/utils/mesh_optimizer.h"
+#include "floats/mat4.h"
+#include "floats/size.h"
+#include "nucleus/containers/dynamic_array.h"
+
+namespace ca {
+
+class Renderer;
+
+// Index ranges for every level of detail of a mesh, stored back to back so that all levels can
+// share one index buffer.  Level 0 is the full detail mesh.
+struct MeshLods {
+  nu::DynamicArray<U32> indices;
+  nu::DynamicArray<GeometryLod> levels;
+};
+
+// Simplify an indexed triangle list with quadric error edge collapses.  Vertices are never moved
+// or created, so the result indexes the original vertex buffer.  Vertices on open borders and on
+// attribute seams (same position, different attributes) are never removed.  Stops once the
+// index count drops to `target_index_count` or when the next collapse would exceed
+// `target_error` (in model space units).  Returns the number of indices written to `destination`,
+// which must have room for `index_count` indices.  The error of the result is written to
+// `result_error` if it is not null.
+MemSize simplify_mesh(U32* destination, const U32* indices, MemSize index_count,
+                      const void* vertices, MemSize vertex_count, U32 vertex_size,
+                      MemSize target_index_count, F32 target_error, F32* result_error = nullptr);
+
+// Build up to `lod_count` levels, each with roughly `reduction` times the triangles of the level
+// before it.  Generation stops early when a level can no longer be reduced meaningfully.  Every
+// level is reordered for the vertex cache.
+MeshLods generate_lods(const IndexedMesh& mesh, U32 lod_count, F32 reduction = 0.5f,
+                       F32 target_error = 1e30f);
+
+// Upload the mesh with all of its levels in a single index buffer.
+Geometry create_geometry(Renderer* renderer, const VertexDefinition& definition,
+                         const IndexedMesh& mesh, const MeshLods& lods);
+
+// Pick the coarsest level whose error projects to no more than `pixel_error` pixels on screen.
+// `model_view` and `projection` are the matrices the geometry is drawn with and `viewport` is the
+// size of the render target.  Geometry without bounds or LODs always selects level 0.
+U32 select_lod(const Geometry& geometry, const fl::Mat4& model_view, const fl::Mat4& projection,
+               const fl::Size& viewport, F32 pixel_error = 1.0f);
+
+}  // namespace ca
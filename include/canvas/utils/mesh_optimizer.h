@@ -0,0 +1,94 @@
+#pragma once
+
+#include "canvas/renderer/types.h"
+#include "canvas/renderer/vertex_definition.h"
+#include "canvas/utils/geometry.h"
+#include "nucleus/containers/dynamic_array.h"
+#include "nucleus/macros.h"
+
+namespace ca {
+
+class Renderer;
+
+// Size of the FIFO post-transform cache that the optimizer targets and the analyzer simulates.
+constexpr U32 kDefaultVertexCacheSize = 16;
+
+struct VertexCacheStatistics {
+  // Number of times the vertex shader would run for the index stream.
+  U32 vertices_transformed = 0;
+
+  // Average cache miss ratio: transformed vertices per triangle.  Ranges from ~0.5 to 3.0.
+  F32 acmr = 0.0f;
+
+  // Average transformed vertex ratio: transformed vertices per unique vertex.  1.0 is optimal.
+  F32 atvr = 0.0f;
+};
+
+// An indexed triangle list over tightly packed vertices of `vertex_size` bytes each.  Mesh
+// functions that need positions expect them as 3 x F32 at the start of each vertex.
+struct IndexedMesh {
+  nu::DynamicArray<U8> vertices;
+  nu::DynamicArray<U32> indices;
+  U32 vertex_size = 0;
+
+  NU_NO_DISCARD MemSize vertex_count() const {
+    return vertex_size ? vertices.size() / vertex_size : 0;
+  }
+};
+
+struct MeshOptimizationReport {
+  MemSize vertex_count_before = 0;
+  MemSize vertex_count_after = 0;
+  VertexCacheStatistics before;
+  VertexCacheStatistics after;
+  ComponentType index_type = ComponentType::Unsigned32;
+};
+
+// Fill `remap` (one entry per input vertex) with the index each vertex has after merging vertices
+// with identical bytes.  `indices` may be null for unindexed input.  Vertices that are not
+// referenced are mapped to `~0u`.  Returns the number of unique vertices.
+MemSize generate_vertex_remap(U32* remap, const U32* indices, MemSize index_count,
+                              const void* vertices, MemSize vertex_count, U32 vertex_size);
+
+// Merge identical vertices and return an indexed mesh.  `indices` may be null for unindexed input,
+// in which case every 3 consecutive vertices form a triangle.
+IndexedMesh deduplicate_vertices(const void* vertices, MemSize vertex_count, U32 vertex_size,
+                                 const U32* indices = nullptr, MemSize index_count = 0);
+
+// Reorder triangles for post-transform vertex cache efficiency using Tipsify (Sander et al.).
+// `destination` must not alias `indices`.
+void optimize_vertex_cache(U32* destination, const U32* indices, MemSize index_count,
+                           MemSize vertex_count, U32 cache_size = kDefaultVertexCacheSize);
+
+// Reorder clusters of an already cache optimized index stream so that triangles facing away from
+// the mesh center are drawn first, reducing overdraw.  Clusters are split where the local ACMR
+// stays within `threshold` of the cluster ACMR, so cache efficiency degrades by at most that
+// factor.  `destination` must not alias `indices`.
+void optimize_overdraw(U32* destination, const U32* indices, MemSize index_count,
+                       const void* vertices, MemSize vertex_count, U32 vertex_size,
+                       F32 threshold = 1.05f, U32 cache_size = kDefaultVertexCacheSize);
+
+// Reorder vertices into the order they are first referenced by `indices` and rewrite `indices`
+// in place.  Unreferenced vertices are dropped.  Returns the number of vertices written to
+// `destination`, which must not alias `vertices`.
+MemSize optimize_vertex_fetch(void* destination, U32* indices, MemSize index_count,
+                              const void* vertices, MemSize vertex_count, U32 vertex_size);
+
+// Simulate a FIFO cache of `cache_size` entries over the index stream.
+VertexCacheStatistics analyze_vertex_cache(const U32* indices, MemSize index_count,
+                                           MemSize vertex_count,
+                                           U32 cache_size = kDefaultVertexCacheSize);
+
+// The smallest index type that can address `vertex_count` vertices.
+ComponentType select_index_type(MemSize vertex_count);
+
+// Run the full pipeline: deduplicate, vertex cache, overdraw and vertex fetch optimization.
+IndexedMesh optimize_mesh(const void* vertices, MemSize vertex_count, U32 vertex_size,
+                          const U32* indices = nullptr, MemSize index_count = 0,
+                          MeshOptimizationReport* report = nullptr);
+
+// Upload the mesh, using 16-bit indices when the vertex count allows it.
+Geometry create_geometry(Renderer* renderer, const VertexDefinition& definition,
+                         const IndexedMesh& mesh);
+
+}  // namespace ca
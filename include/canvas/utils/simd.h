@@ -0,0 +1,22 @@
+#pragma once
+
+// Vector instruction sets available to the compiler.  Code using them always keeps a scalar path
+// for other targets.
+
+#if defined(__AVX__)
+#define CANVAS_AVX 1
+#else
+#define CANVAS_AVX 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CANVAS_SSE 1
+#else
+#define CANVAS_SSE 0
+#endif
+
+#if CANVAS_AVX
+#include <immintrin.h>
+#elif CANVAS_SSE
+#include <emmintrin.h>
+#endif
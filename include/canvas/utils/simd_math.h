@@ -0,0 +1,22 @@
+#pragma once
+
+#include "floats/mat4.h"
+#include "nucleus/types.h"
+
+namespace ca {
+
+// `result = a * b` for column major matrices.  `result` may alias either input.
+void multiply_mat4(const fl::Mat4& a, const fl::Mat4& b, fl::Mat4* result);
+
+// `result[i] = parent * local[i]` for `count` matrices.  `result` may alias `local`.
+void multiply_mat4_batch(const fl::Mat4& parent, const fl::Mat4* local, MemSize count,
+                         fl::Mat4* result);
+
+// Transform `count` points by `matrix` into homogeneous coordinates.  Each source point is 3 x F32
+// at the start of a `source_stride` byte element and each result is written as 4 x F32 at the
+// start of a `destination_stride` byte element.  Processes 4 points per iteration with SSE and 8
+// with AVX.
+void transform_points(const fl::Mat4& matrix, const void* source, MemSize source_stride,
+                      void* destination, MemSize destination_stride, MemSize count);
+
+}  // namespace ca
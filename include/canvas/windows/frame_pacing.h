@@ -0,0 +1,33 @@
+#pragma once
+
+#include "nucleus/types.h"
+
+namespace ca {
+
+enum class FramePacingMode : U32 {
+  // Paint as often as the swap interval allows.
+  Continuous,
+  // Paint at most `maxFps` times a second.
+  Capped,
+  // Only paint when the window was invalidated, by `Window::invalidate` or a resize.  In between,
+  // wait for events without using any CPU.
+  OnDemand,
+};
+
+struct FramePacing {
+  FramePacingMode mode = FramePacingMode::Continuous;
+
+  // Limit for `Capped` and `OnDemand`.  0 for no limit.
+  F64 maxFps = 60.0;
+
+  // Limit in any mode while the window does not have focus, to save power behind other windows.
+  // Off by default, because throttling also slows down anything animating in an unfocused window
+  // that is still visible.  0 for no limit.  Nothing is painted while the window is iconified.
+  F64 backgroundFps = 0.0;
+
+  // Longest time `OnDemand` waits for events before running a frame anyway.  0 to wait for as
+  // long as it takes.
+  F64 idleTimeoutSeconds = 0.0;
+};
+
+}  // namespace ca
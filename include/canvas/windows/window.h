@@ -1,7 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
 #include "canvas/debug/debug_interface.h"
+#include "canvas/renderer/render_thread.h"
 #include "canvas/renderer/renderer.h"
+#include "canvas/windows/frame_pacing.h"
 #include "canvas/windows/window_delegate.h"
 #include "nucleus/macros.h"
 #include "nucleus/memory/scoped_ptr.h"
@@ -11,6 +16,12 @@ typedef struct GLFWwindow GLFWwindow;
 
 namespace ca {
 
+// A rectangle of the window's client area in pixels, from the top left.
+struct WindowRect {
+  fl::Pos position;
+  fl::Size size;
+};
+
 class Window {
 public:
   NU_DELETE_COPY_AND_MOVE(Window);
@@ -30,10 +41,69 @@ public:
     return const_cast<Renderer*>(&m_renderer);
   }
 
+  // Only redraw the parts of the window that were invalidated, at the cost of copying every frame
+  // from an offscreen buffer.  Works best with the `OnDemand` pacing mode.
+  void setPartialRedraw(bool enabled) {
+    m_renderer.set_retain_frames(enabled);
+  }
+
+  // Render on a thread of its own, so events, ticks and recording a frame overlap with rendering
+  // the previous ones.  `paint` records frames into packets that the render thread executes, up to
+  // `latency` frames behind.  The context is current on the render thread while it runs, and
+  // resources created from here on are created there while the caller waits.  Not to be called
+  // while painting.
+  void setThreadedRendering(bool enabled, U32 latency = 1);
+
+  bool isThreadedRendering() const {
+    return m_renderThread.is_running();
+  }
+
   // Process any pending events for this window.  Returns false if the window should stop processing
   // messages.
   bool processEvents();
 
+  // Wait until there are events to process, or `timeoutSeconds` passed if it is more than 0, and
+  // process them.  Returns false if the window should stop processing messages.
+  bool waitEvents(F64 timeoutSeconds = 0.0);
+
+  // Wake up a `waitEvents` call.  Can be called from any thread.
+  void wakeUp();
+
+  bool isFocused() const;
+  bool isIconified() const;
+
+  // How often the message pump paints the window.
+  const FramePacing& framePacing() const {
+    return m_framePacing;
+  }
+
+  void setFramePacing(const FramePacing& framePacing) {
+    m_framePacing = framePacing;
+  }
+
+  // Mark the whole window, or a rectangle of it, as changed, so it is painted again.  The
+  // `OnDemand` pacing mode only paints when something was invalidated by this or by a resize or
+  // damage to the window; input handlers, ticks and tasks decide whether what they did needs a
+  // paint.  Can be called from any thread.
+  void invalidate();
+  void invalidate(const WindowRect& rect);
+
+  bool needsPaint() const {
+    return m_needsPaint.load(std::memory_order_acquire);
+  }
+
+  // While painting, the bounds of everything invalidated since the previous paint, clipped to the
+  // window.  If the renderer retains frames, all rendering is clipped to it and the rest of the
+  // window keeps what the previous frames drew there.
+  const WindowRect& paintRect() const {
+    return m_paintRect;
+  }
+
+  // Time spent waiting on purpose before the next frame, so it isn't counted as a slow frame.
+  void addIdleTime(F64 microseconds) {
+    m_idleTime += microseconds;
+  }
+
   // Activate this window's rendering context.
   void activateContext();
 
@@ -43,6 +113,18 @@ public:
   // Request that the window paint it's contents.
   void paint();
 
+  // Show the profile block tree over the window's contents.  Also toggled with F3.
+  bool isProfilerVisible() const {
+    return m_debugInterface.isProfilerVisible();
+  }
+
+  void setProfilerVisible(bool visible);
+
+  // Timings of the most recent frames.
+  FrameStats& frameStats() {
+    return m_frameStats;
+  }
+
 private:
   // Callbacks
   static void frameBufferSizeCallback(GLFWwindow* window, int width, int height);
@@ -50,6 +132,14 @@ private:
   static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
   static void scrollCallback(GLFWwindow* window, double xOffset, double yOffset);
   static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+  static void refreshCallback(GLFWwindow* window);
+
+  // Stop the render thread and make the context current here again.
+  void stopRenderThread();
+
+  // Called on the render thread.
+  void renderPacket(FramePacket* packet);
+  void releaseContext();
 
   // The window delegate we pass events to.
   WindowDelegate* m_delegate = nullptr;
@@ -60,14 +150,33 @@ private:
   // The renderer we use to render anything to this window.
   Renderer m_renderer;
 
+  // Executes the frames `paint` records, if threaded rendering is enabled.
+  RenderThread m_renderThread{[this](FramePacket* packet) { renderPacket(packet); },
+                              [this]() { activateContext(); }, [this]() { releaseContext(); }};
+
   // The debug interface we use to render details to the developer.
   DebugInterface m_debugInterface{&m_renderer, {1600, 900}};
 
   // Size of the client area of the window.
   fl::Size m_clientSize;
 
-  // Last frame's FPS.
-  F64 m_lastFPS = 0.0;
+  FramePacing m_framePacing;
+
+  // Set when something changed that has to be painted, cleared when a paint starts.
+  std::atomic<bool> m_needsPaint{true};
+
+  // Bounds of everything invalidated since the last paint, guarded by `m_dirtyLock`.
+  std::mutex m_dirtyLock;
+  bool m_dirtyAll = true;
+  fl::Pos m_dirtyMin;
+  fl::Pos m_dirtyMax;
+
+  WindowRect m_paintRect;
+
+  // Timings of the most recent frames and when the last one was presented, in microseconds.
+  FrameStats m_frameStats;
+  F64 m_lastPresentTime = 0.0;
+  F64 m_idleTime = 0.0;
 };
 
 }  // namespace ca
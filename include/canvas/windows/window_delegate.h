@@ -15,6 +15,7 @@ namespace ca {
 
 class Renderer;
 class Window;
+struct WindowRect;
 
 class WindowDelegate : public MouseEventReceiver, public KeyboardEventReceiver {
   NU_DELETE_COPY_AND_MOVE(WindowDelegate);
@@ -40,6 +41,15 @@ public:
 
   virtual void on_render(Renderer* renderer) = 0;
 
+  // The window this delegate is attached to, once it was created.
+  NU_NO_DISCARD Window* window() const {
+    return window_;
+  }
+
+  // Ask for the window to be painted again, because everything or a rectangle of it changed.
+  void invalidate();
+  void invalidate(const WindowRect& rect);
+
   void add_mouse_event_receiver(MouseEventReceiver* handler);
   void remove_mouse_event_receiver(MouseEventReceiver* handler);
 
@@ -57,6 +67,10 @@ public:
   void on_key_released(const KeyEvent& evt) override;
 
 protected:
+  friend class Window;
+
+  Window* window_ = nullptr;
+
   // The title that appears in the window title bar.
   nu::StaticString<128> title_;
 
@@ -1,15 +1,17 @@
 #include "canvas/debug/debug_font.h"
 
+#include <cstring>
+
 #include "canvas/renderer/renderer.h"
 #include "canvas/static_data/all.h"
-#include "floats/transform.h"
+#include "nucleus/containers/dynamic_array.h"
 
 namespace ca {
 
 namespace {
 
-constexpr F32 kTextureWidth = 256.0f;
-constexpr F32 kTextureHeight = 128.0f;
+constexpr F32 kTextureWidth = static_cast<F32>(kMonoFontWidth);
+constexpr F32 kTextureHeight = static_cast<F32>(kMonoFontHeight);
 
 constexpr F32 kGlyphWidth = 8.0f;
 constexpr F32 kGlyphHeight = 16.0f;
@@ -17,12 +19,20 @@ constexpr F32 kGlyphHeight = 16.0f;
 constexpr I32 kHorizontalGlyphCount = 32;
 constexpr I32 kVerticalGlyphCount = 8;
 
-struct Vertex {
-  F32 x;
-  F32 y;
-  F32 u;
-  F32 v;
-};
+// Glyphs are laid out in ems of one glyph height.
+constexpr F32 kGlyphAspect = kGlyphWidth / kGlyphHeight;
+
+// Identifies the font in layout cache keys.
+constexpr U64 kLayoutFontKey = 0x6465627567666e74ull;
+
+I32 glyphIndexFor(U32 codepoint) {
+  return static_cast<I32>(codepoint) - ' ';
+}
+
+bool isInFont(I32 glyphIndex) {
+  // The first glyph is the space, which is never drawn.
+  return glyphIndex > 0 && glyphIndex < kHorizontalGlyphCount * kVerticalGlyphCount;
+}
 
 auto kVertexShaderSource = R"source(
 #version 330
@@ -60,37 +70,40 @@ void main() {
 DebugFont::DebugFont(Renderer* renderer) : m_renderer{renderer} {}
 
 bool DebugFont::initialize() {
-  // Create the geometry for the characters.
+  // Every character takes up a fixed cell, whether it is in the font or not.
+
+  m_layoutFont.key = kLayoutFontKey;
+  m_layoutFont.ascender = 1.0f;
+  m_layoutFont.line_height = 1.0f;
+  m_layoutFont.placement = [](U32 codepoint, GlyphPlacement* placement) {
+    placement->advance = kGlyphAspect;
+    placement->left = 0.0f;
+    placement->top = 1.0f;
+    placement->width = kGlyphAspect;
+    placement->height = 1.0f;
+    placement->visible = isInFont(glyphIndexFor(codepoint));
+    return true;
+  };
+
+  // Glyph quads are built every frame and streamed into a single buffer.
 
   VertexDefinition def;
   def.addAttribute(ComponentType::Float32, ComponentCount::Two);
   def.addAttribute(ComponentType::Float32, ComponentCount::Two);
 
-  // Build a vertex buffer that has geometry for each glyph.
-  Vertex vertices[kHorizontalGlyphCount * kVerticalGlyphCount * 4];
-  MemSize glyphIndex = 0;
-  for (I32 y = 0; y < kVerticalGlyphCount; ++y) {
-    for (I32 x = 0; x < kHorizontalGlyphCount; ++x) {
-      const F32 uvLeft = static_cast<F32>(x) * kGlyphWidth / kTextureWidth;
-      const F32 uvRight = static_cast<F32>(x + 1) * kGlyphWidth / kTextureWidth;
-      const F32 uvTop = static_cast<F32>(y) * kGlyphHeight / kTextureHeight;
-      const F32 uvBottom = static_cast<F32>(y + 1) * kGlyphHeight / kTextureHeight;
-
-      vertices[glyphIndex + 0] = {0.0f, 0.0f, uvLeft, uvTop};
-      vertices[glyphIndex + 1] = {kGlyphWidth, 0.0f, uvRight, uvTop};
-      vertices[glyphIndex + 2] = {kGlyphWidth, kGlyphHeight, uvRight, uvBottom};
-      vertices[glyphIndex + 3] = {0.0f, kGlyphHeight, uvLeft, uvBottom};
-
-      glyphIndex += 4;
-    }
-  }
+  m_vertexBufferId = m_renderer->create_vertex_buffer(def, nullptr, 0);
 
-  m_vertexBufferId = m_renderer->create_vertex_buffer(def, vertices, sizeof(vertices));
+  m_vertices = FrameArray<Vertex>{m_renderer->frame_allocator()};
+  m_batches = FrameArray<Batch>{m_renderer->frame_allocator()};
 
   // Create the texture.
 
-  m_textureId =
-      m_renderer->create_texture(TextureFormat::Alpha, {256, 128}, monoFont, monoFontSize, false);
+  nu::DynamicArray<U8> pixels;
+  pixels.resize(static_cast<MemSize>(kMonoFontWidth) * kMonoFontHeight);
+  expandMonochrome(monoFontBits, kMonoFontWidth, kMonoFontHeight, pixels.data());
+
+  m_textureId = m_renderer->create_texture(TextureFormat::Alpha, {kMonoFontWidth, kMonoFontHeight},
+                                           pixels.data(), pixels.size(), false);
 
   // Create the program.
 
@@ -105,25 +118,66 @@ bool DebugFont::initialize() {
 }
 
 void DebugFont::drawText(const fl::Mat4& transform, const fl::Pos& position, nu::StringView text) {
-  for (auto index = 0U; index < text.length(); ++index) {
-    fl::Vec2 offset{
-        static_cast<F32>(position.x) + static_cast<F32>(index) * (kGlyphWidth),
-        static_cast<F32>(position.y),
-    };
+  // Text with the same transform as the previous call continues its batch.
+  if (m_batches.empty() ||
+      std::memcmp(&m_batches[m_batches.size() - 1].transform, &transform, sizeof(fl::Mat4)) != 0) {
+    m_batches.emplaceBack(transform, static_cast<U32>(m_vertices.size()), 0U);
+  }
 
-    auto moved = transform * translation_matrix(fl::Vec3{offset, 0.0f});
+  const TextLayout* layout = &m_scratchLayout;
+  if (m_layoutCache) {
+    layout = &m_layoutCache->layout(m_layoutFont, text, kGlyphHeight);
+  } else {
+    layout_text(m_layoutFont, text, kGlyphHeight, 0.0f, &m_scratchLayout);
+  }
 
-    UniformBuffer uniforms;
-    uniforms.set(m_transformUniformId, moved);
+  for (const auto& glyph : layout->glyphs) {
+    const I32 glyphIndex = glyphIndexFor(glyph.codepoint);
+
+    const F32 left = static_cast<F32>(position.x) + glyph.left;
+    const F32 top = static_cast<F32>(position.y) + glyph.top;
+    const F32 right = static_cast<F32>(position.x) + glyph.right;
+    const F32 bottom = static_cast<F32>(position.y) + glyph.bottom;
+
+    const I32 x = glyphIndex % kHorizontalGlyphCount;
+    const I32 y = glyphIndex / kHorizontalGlyphCount;
+    const F32 uvLeft = static_cast<F32>(x) * kGlyphWidth / kTextureWidth;
+    const F32 uvRight = static_cast<F32>(x + 1) * kGlyphWidth / kTextureWidth;
+    const F32 uvTop = static_cast<F32>(y) * kGlyphHeight / kTextureHeight;
+    const F32 uvBottom = static_cast<F32>(y + 1) * kGlyphHeight / kTextureHeight;
+
+    m_vertices.pushBack({left, top, uvLeft, uvTop});
+    m_vertices.pushBack({right, top, uvRight, uvTop});
+    m_vertices.pushBack({right, bottom, uvRight, uvBottom});
+    m_vertices.pushBack({left, top, uvLeft, uvTop});
+    m_vertices.pushBack({right, bottom, uvRight, uvBottom});
+    m_vertices.pushBack({left, bottom, uvLeft, uvBottom});
+  }
+
+  auto& batch = m_batches[m_batches.size() - 1];
+  batch.vertexCount = static_cast<U32>(m_vertices.size()) - batch.firstVertex;
+}
 
-    auto glyphIndex = text[index] - ' ';
-    if (glyphIndex == 0) {
-      // Skip spaces.
-      continue;
+void DebugFont::render() {
+  if (!m_vertices.empty()) {
+    m_renderer->stream_vertex_buffer_data(m_vertexBufferId, m_vertices.data(),
+                                          m_vertices.size() * sizeof(Vertex));
+
+    for (const auto& batch : m_batches) {
+      if (!batch.vertexCount) {
+        continue;
+      }
+
+      UniformBuffer uniforms;
+      uniforms.set(m_transformUniformId, batch.transform);
+
+      m_renderer->draw(DrawType::Triangles, batch.firstVertex, batch.vertexCount, m_programId,
+                       m_vertexBufferId, m_textureId, uniforms);
     }
-    m_renderer->draw(DrawType::TriangleFan, glyphIndex * 4, 4, m_programId, m_vertexBufferId,
-                     m_textureId, uniforms);
   }
+
+  m_vertices.clear();
+  m_batches.clear();
 }
 
 }  // namespace ca
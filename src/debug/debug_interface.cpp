@@ -9,22 +9,31 @@
 namespace ca {
 
 DebugInterface::DebugInterface(Renderer* renderer, fl::Size size)
-  : m_size{size}, m_debugFont{renderer} {}
+  : m_size{size}, m_debugFont{renderer}, m_frameGraph{renderer} {}
 
 auto DebugInterface::initialize() -> bool {
-  return m_debugFont.initialize();
+  m_debugFont.setLayoutCache(&m_layoutCache);
+  return m_debugFont.initialize() && m_frameGraph.initialize();
 }
 
 auto DebugInterface::resize(fl::Size size) -> void {
   m_size = size;
 }
 
-auto DebugInterface::render(F64 fps) -> void {
+auto DebugInterface::render(const FrameStats& frameStats) -> void {
+  m_layoutCache.begin_frame();
+
   // Set up an orthographic view projection.
   auto projection = fl::orthographic_projection(0.0f, static_cast<F32>(m_size.width), 0.0f,
                                                 static_cast<F32>(m_size.height), -1.0f, 1.0f);
 
-  char buf[64];
+  F64 fps = 0.0;
+  if (frameStats.frameCount()) {
+    F64 interval = frameStats.frame(frameStats.frameCount() - 1).presentIntervalMilliseconds;
+    fps = interval > 0.0 ? 1000.0 / interval : 0.0;
+  }
+
+  char buf[128];
 #if COMPILER(MSVC)
   sprintf_s(buf, "%.1lf", fps);
 #else
@@ -32,43 +41,38 @@ auto DebugInterface::render(F64 fps) -> void {
 #endif
   m_debugFont.drawText(projection, {10, 10}, buf);
 
-  return;
-
-  auto* profiler = nu::detail::getCurrentProfileMetrics();
-
-  drawProfileBlock(profiler->root(), fl::Pos{350, 10}, projection);
-}
-
-auto DebugInterface::drawProfileBlock(nu::detail::ProfileMetrics::Block* block,
-                                      const fl::Pos& position, const fl::Mat4& transform,
-                                      I32 indent) -> I32 {
-  auto currentPosition = position;
+  if (m_profilerVisible) {
+    m_frameGraph.render(projection, {10, 110}, {256, 80}, frameStats);
 
-  for (auto* current = block; current; current = current->next) {
-    nu::StaticString<128> line;
-    line.append(current->name.view());
-
-    char buffer[64];
-#if OS(WIN)
-    sprintf_s(buffer, sizeof(buffer), "%.2f", current->stopTime - current->startTime);
+    if (m_percentiles.length() == 0 || ++m_framesSincePercentiles >= 30) {
+      auto summary = frameStats.summary();
+#if COMPILER(MSVC)
+      sprintf_s(buf, "p50 %.1f p95 %.1f p99 %.1f max %.1f ms", summary.presentInterval.p50,
+                summary.presentInterval.p95, summary.presentInterval.p99,
+                summary.presentInterval.max);
 #else
-    sprintf(buffer, "%.2f", current->stopTime - current->startTime);
+      std::sprintf(buf, "p50 %.1f p95 %.1f p99 %.1f max %.1f ms", summary.presentInterval.p50,
+                   summary.presentInterval.p95, summary.presentInterval.p99,
+                   summary.presentInterval.max);
 #endif
-    line.append("  ");
-    line.append(buffer);
+      m_percentiles = nu::StaticString<128>{};
+      m_percentiles.append(buf);
+      m_framesSincePercentiles = 0;
+    }
+    // Below the graph, which covers 110 to 190.
+    m_debugFont.drawText(projection, {10, 194}, m_percentiles.view());
 
-    m_debugFont.drawText(transform, currentPosition, line.view());
+    m_profilePrinter.draw(projection, {350, 10});
+  }
 
-    currentPosition.y += 16;
+  m_debugFont.render();
+}
 
-    if (current->children) {
-      currentPosition.y +=
-          drawProfileBlock(current->children, fl::Pos{currentPosition.x + 10, currentPosition.y},
-                           transform, indent + 1);
-    }
+auto DebugInterface::recordProfile(nu::detail::ProfileMetrics::Block* root,
+                                   const nu::DynamicArray<GpuScopeTiming>& gpuTimings) -> void {
+  if (m_profilerVisible) {
+    m_profilePrinter.record(root, gpuTimings);
   }
-
-  return currentPosition.y - position.y;
 }
 
 }  // namespace ca
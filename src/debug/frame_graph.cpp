@@ -0,0 +1,133 @@
+#include "canvas/debug/frame_graph.h"
+
+#include <algorithm>
+
+#include "canvas/debug/frame_stats.h"
+#include "canvas/renderer/renderer.h"
+#include "canvas/utils/color.h"
+
+namespace ca {
+
+namespace {
+
+// Frames at or under this are on time for a 60Hz display.
+constexpr F64 kTargetFrameMilliseconds = 1000.0 / 60.0;
+
+auto kVertexShaderSource = R"source(
+#version 330
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec4 inColor;
+
+uniform mat4 uTransform;
+
+out vec4 vColor;
+
+void main() {
+  gl_Position = uTransform * vec4(inPosition, 0.0f, 1.0f);
+  vColor = inColor;
+}
+)source";
+
+auto kFragmentShaderSource = R"source(
+#version 330
+
+in vec4 vColor;
+
+out vec4 final;
+
+void main() {
+  final = vColor;
+}
+)source";
+
+}  // namespace
+
+FrameGraph::FrameGraph(Renderer* renderer) : m_renderer{renderer} {}
+
+bool FrameGraph::initialize() {
+  VertexDefinition def;
+  def.addAttribute(ComponentType::Float32, ComponentCount::Two);
+  def.addAttribute(ComponentType::Unsigned8, ComponentCount::Four, true);
+
+  m_vertexBufferId = m_renderer->create_vertex_buffer(def, nullptr, 0);
+
+  m_programId = m_renderer->create_program(ShaderSource::from(kVertexShaderSource),
+                                           ShaderSource::from(kFragmentShaderSource));
+
+  m_transformUniformId = m_renderer->create_uniform("uTransform");
+
+  m_vertices = FrameArray<Vertex>{m_renderer->frame_allocator()};
+
+  return m_vertexBufferId.is_valid() && m_programId.is_valid();
+}
+
+void FrameGraph::render(const fl::Mat4& transform, const fl::Pos& position, const fl::Size& size,
+                        const FrameStats& stats) {
+  const U32 backgroundColor = pack_rgba8(Color{0.0f, 0.0f, 0.0f, 0.5f});
+  const U32 onTimeColor = pack_rgba8(Color{0.2f, 0.8f, 0.2f, 1.0f});
+  const U32 lateColor = pack_rgba8(Color{0.9f, 0.8f, 0.2f, 1.0f});
+  const U32 hitchColor = pack_rgba8(Color{0.9f, 0.2f, 0.2f, 1.0f});
+  const U32 markerColor = pack_rgba8(Color{1.0f, 1.0f, 1.0f, 0.5f});
+
+  const auto left = static_cast<F32>(position.x);
+  const auto bottom = static_cast<F32>(position.y);
+  const auto width = static_cast<F32>(size.width);
+  const auto height = static_cast<F32>(size.height);
+
+  const F64 threshold = stats.hitchThreshold();
+  const auto pixelsPerMillisecond = static_cast<F32>(height / (threshold * 2.0));
+
+  m_vertices.reserve((FrameStats::kHistorySize + 3) * 6);
+
+  addRect(left, bottom - height, left + width, bottom, backgroundColor);
+
+  // Bars fill the graph from the right, most recent frame last.
+  const F32 barWidth = width / static_cast<F32>(FrameStats::kHistorySize);
+  const U32 count = stats.frameCount();
+  for (U32 i = 0; i < count; ++i) {
+    const auto& timing = stats.frame(i);
+    F64 milliseconds = timing.presentIntervalMilliseconds;
+
+    // Time spent waiting for the next frame on purpose is not late.
+    F64 busyMilliseconds = milliseconds - timing.idleMilliseconds;
+    U32 color = onTimeColor;
+    if (busyMilliseconds > threshold) {
+      color = hitchColor;
+    } else if (busyMilliseconds > kTargetFrameMilliseconds * 1.05) {
+      color = lateColor;
+    }
+
+    F32 barHeight = std::min(static_cast<F32>(milliseconds) * pixelsPerMillisecond, height);
+    F32 barLeft = left + width - static_cast<F32>(count - i) * barWidth;
+    addRect(barLeft, bottom - barHeight, barLeft + barWidth, bottom, color);
+  }
+
+  // Markers at the target frame time and the hitch threshold.
+  for (F64 marker : {kTargetFrameMilliseconds, threshold}) {
+    F32 y = bottom - static_cast<F32>(marker) * pixelsPerMillisecond;
+    addRect(left, y, left + width, y + 1.0f, markerColor);
+  }
+
+  m_renderer->stream_vertex_buffer_data(m_vertexBufferId, m_vertices.data(),
+                                        m_vertices.size() * sizeof(Vertex));
+
+  UniformBuffer uniforms;
+  uniforms.set(m_transformUniformId, transform);
+
+  m_renderer->draw(DrawType::Triangles, 0, static_cast<U32>(m_vertices.size()), m_programId,
+                   m_vertexBufferId, {}, uniforms);
+
+  m_vertices.clear();
+}
+
+void FrameGraph::addRect(F32 left, F32 top, F32 right, F32 bottom, U32 color) {
+  m_vertices.pushBack({left, top, color});
+  m_vertices.pushBack({right, top, color});
+  m_vertices.pushBack({right, bottom, color});
+  m_vertices.pushBack({left, top, color});
+  m_vertices.pushBack({right, bottom, color});
+  m_vertices.pushBack({left, bottom, color});
+}
+
+}  // namespace ca
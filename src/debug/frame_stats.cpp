@@ -0,0 +1,160 @@
+#include "canvas/debug/frame_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "nucleus/logging.h"
+
+namespace ca {
+
+namespace {
+
+// Profile blocks are timed in microseconds.
+constexpr F64 kMicrosecondsToMilliseconds = 1.0 / 1000.0;
+
+// Nearest rank percentiles of `values`, which are reordered.
+FramePercentiles percentiles(F64* values, U32 count) {
+  FramePercentiles result;
+  if (!count) {
+    return result;
+  }
+
+  auto rank = [&](F64 percentile) {
+    auto index = static_cast<U32>(std::ceil(percentile * static_cast<F64>(count)));
+    index = std::min(std::max(index, 1U), count) - 1;
+    std::nth_element(values, values + index, values + count);
+    return values[index];
+  };
+
+  result.p50 = rank(0.50);
+  result.p95 = rank(0.95);
+  result.p99 = rank(0.99);
+  result.max = *std::max_element(values, values + count);
+
+  return result;
+}
+
+}  // namespace
+
+FrameStats::FrameStats(F64 hitchThresholdMilliseconds)
+  : m_hitchThreshold{hitchThresholdMilliseconds} {}
+
+auto FrameStats::addFrame(const FrameTiming& timing, nu::detail::ProfileMetrics::Block* root)
+    -> bool {
+  m_frames[m_next] = timing;
+  m_next = (m_next + 1) % kHistorySize;
+  m_count = std::min(m_count + 1, kHistorySize);
+  ++m_frameNumber;
+
+  F64 busyInterval = timing.presentIntervalMilliseconds - timing.idleMilliseconds;
+  if (std::max(timing.cpuMilliseconds, busyInterval) <= m_hitchThreshold) {
+    return false;
+  }
+
+  ++m_hitchCount;
+
+  // Keep the most recent hitches only.
+  if (m_hitches.size() == kMaxHitches) {
+    std::rotate(m_hitches.begin(), m_hitches.begin() + 1, m_hitches.end());
+    m_hitches.resize(kMaxHitches - 1);
+  }
+
+  auto& hitch = m_hitches.emplaceBack().element();
+  hitch.frame = m_frameNumber;
+  hitch.timing = timing;
+  hitch.blocks.clear();
+  snapshotBlocks(root, 0, &hitch);
+
+  return true;
+}
+
+auto FrameStats::summary() const -> FrameStatsSummary {
+  FrameStatsSummary result;
+  result.frameCount = m_count;
+  result.hitchCount = m_hitchCount;
+
+  F64 values[kHistorySize];
+  U32 gpuCount = 0;
+
+  for (U32 i = 0; i < m_count; ++i) {
+    values[i] = frame(i).cpuMilliseconds;
+  }
+  result.cpu = percentiles(values, m_count);
+
+  for (U32 i = 0; i < m_count; ++i) {
+    if (frame(i).gpuMilliseconds >= 0.0) {
+      values[gpuCount++] = frame(i).gpuMilliseconds;
+    }
+  }
+  result.gpu = percentiles(values, gpuCount);
+
+  for (U32 i = 0; i < m_count; ++i) {
+    values[i] = frame(i).presentIntervalMilliseconds;
+  }
+  result.presentInterval = percentiles(values, m_count);
+
+  return result;
+}
+
+auto FrameStats::writeReport(FILE* file) const -> void {
+  auto summary = this->summary();
+
+  std::fprintf(file, "frames: %u, hitches: %llu (over %.2f ms)\n", summary.frameCount,
+               static_cast<unsigned long long>(summary.hitchCount), m_hitchThreshold);
+  std::fprintf(file, "%-10s%10s%10s%10s%10s\n", "ms", "p50", "p95", "p99", "max");
+
+  auto printPercentiles = [file](const char* name, const FramePercentiles& p) {
+    std::fprintf(file, "%-10s%10.2f%10.2f%10.2f%10.2f\n", name, p.p50, p.p95, p.p99, p.max);
+  };
+  printPercentiles("cpu", summary.cpu);
+  printPercentiles("gpu", summary.gpu);
+  printPercentiles("present", summary.presentInterval);
+
+  for (const auto& hitch : m_hitches) {
+    std::fprintf(file, "\nhitch in frame %llu: cpu %.2f ms, present interval %.2f ms\n",
+                 static_cast<unsigned long long>(hitch.frame), hitch.timing.cpuMilliseconds,
+                 hitch.timing.presentIntervalMilliseconds);
+    for (const auto& block : hitch.blocks) {
+      auto name = block.name.view();
+      std::fprintf(file, "%*s%.*s %.2f ms\n", static_cast<I32>(block.depth) * 2 + 2, "",
+                   static_cast<I32>(name.length()), name.data(), block.milliseconds);
+    }
+  }
+
+  std::fprintf(file, "\ncpu,gpu,present\n");
+  for (U32 i = 0; i < m_count; ++i) {
+    const auto& timing = frame(i);
+    std::fprintf(file, "%.3f,%.3f,%.3f\n", timing.cpuMilliseconds, timing.gpuMilliseconds,
+                 timing.presentIntervalMilliseconds);
+  }
+}
+
+auto FrameStats::writeReport(const char* path) const -> bool {
+  FILE* file = std::fopen(path, "w");
+  if (!file) {
+    LOG(Error) << "Could not open " << path << " to write the frame report.";
+    return false;
+  }
+
+  writeReport(file);
+  std::fclose(file);
+
+  return true;
+}
+
+auto FrameStats::snapshotBlocks(nu::detail::ProfileMetrics::Block* block, U32 depth, Hitch* hitch)
+    -> void {
+  for (auto* current = block; current; current = current->next) {
+    auto& snapshot = hitch->blocks.emplaceBack().element();
+    snapshot.name = nu::StaticString<64>{};
+    snapshot.name.append(current->name.view());
+    snapshot.depth = depth;
+    snapshot.milliseconds = (current->stopTime - current->startTime) * kMicrosecondsToMilliseconds;
+
+    if (current->children) {
+      snapshotBlocks(current->children, depth + 1, hitch);
+    }
+  }
+}
+
+}  // namespace ca
@@ -1,18 +1,147 @@
 #include "canvas/debug/profile_printer.h"
 
+#include <algorithm>
+#include <cstdio>
+
 #include "canvas/debug/debug_font.h"
 
 namespace ca {
 
-#if 0
+namespace {
+
+// How often the printed numbers change.
+constexpr U64 kRefreshFrames = 30;
+
+constexpr I32 kNameColumnWidth = 32;
+constexpr I32 kLineHeight = 16;
+
+// Profile blocks are timed in microseconds.
+constexpr F64 kMicrosecondsToMilliseconds = 1.0 / 1000.0;
+
+}  // namespace
+
+auto ProfilePrinter::History::add(F64 sample) -> void {
+  samples[next] = sample;
+  next = (next + 1) % kHistoryFrames;
+  count = std::min(count + 1, kHistoryFrames);
+}
+
+auto ProfilePrinter::History::average() const -> F64 {
+  F64 total = 0.0;
+  for (U32 i = 0; i < count; ++i) {
+    total += samples[i];
+  }
+  return count ? total / static_cast<F64>(count) : 0.0;
+}
+
+auto ProfilePrinter::History::minimum() const -> F64 {
+  return count ? *std::min_element(samples, samples + count) : 0.0;
+}
+
+auto ProfilePrinter::History::maximum() const -> F64 {
+  return count ? *std::max_element(samples, samples + count) : 0.0;
+}
+
+ProfilePrinter::ProfilePrinter(DebugFont* debugFont) : m_debugFont{debugFont} {}
+
+auto ProfilePrinter::record(nu::detail::ProfileMetrics::Block* root,
+                            const nu::DynamicArray<GpuScopeTiming>& gpuTimings) -> void {
+  ++m_frame;
+
+  // Forget blocks that have not run for a while.
+  auto stale = std::remove_if(m_nodes.begin(), m_nodes.end(), [this](const Node& node) {
+    return node.lastFrame + kHistoryFrames < m_frame;
+  });
+  m_nodes.resize(static_cast<MemSize>(stale - m_nodes.begin()));
+
+  m_order.clear();
+  recordBlock(root, kHashSeed, 0, gpuTimings);
 
-ProfilePrinter::ProfilePrinter(Renderer* renderer, DebugFont* debugFont, const Mat4& transform)
-  : m_renderer{renderer}, m_debugFont{debugFont}, m_transform{transform} {}
+  if (m_lines.empty() || m_frame % kRefreshFrames == 0) {
+    updateLines();
+  }
+}
 
-auto ProfilePrinter::draw(nu::detail::ProfileMetrics::Block* root, const Pos& position) -> void {
-  m_cursor = position;
+auto ProfilePrinter::draw(const fl::Mat4& transform, const fl::Pos& position) -> void {
+  auto cursor = position;
+  for (const auto& line : m_lines) {
+    m_debugFont->drawText(transform, cursor, line.view());
+    cursor.y += kLineHeight;
+  }
 }
 
-#endif  // 0
+auto ProfilePrinter::recordBlock(nu::detail::ProfileMetrics::Block* block, U64 parentKey,
+                                 U32 depth, const nu::DynamicArray<GpuScopeTiming>& gpuTimings)
+    -> void {
+  for (auto* current = block; current; current = current->next) {
+    U64 key = profile_scope_key(parentKey, current->name.view());
+
+    U32 index = findNode(key);
+    if (index == m_nodes.size()) {
+      Node node;
+      node.key = key;
+      node.name.append(current->name.view());
+      node.depth = depth;
+      m_nodes.pushBack(node);
+    }
+
+    auto& node = m_nodes[index];
+    node.lastFrame = m_frame;
+    node.cpu.add((current->stopTime - current->startTime) * kMicrosecondsToMilliseconds);
+
+    for (const auto& timing : gpuTimings) {
+      if (timing.key == key) {
+        node.gpu.add(timing.milliseconds);
+        break;
+      }
+    }
+
+    m_order.pushBack(index);
+
+    if (current->children) {
+      recordBlock(current->children, key, depth + 1, gpuTimings);
+    }
+  }
+}
+
+auto ProfilePrinter::findNode(U64 key) -> U32 {
+  // Trees are small, so a linear search is fine.
+  for (U32 i = 0; i < m_nodes.size(); ++i) {
+    if (m_nodes[i].key == key) {
+      return i;
+    }
+  }
+  return static_cast<U32>(m_nodes.size());
+}
+
+auto ProfilePrinter::updateLines() -> void {
+  m_lines.clear();
+
+  char buffer[128];
+  std::snprintf(buffer, sizeof(buffer), "%-*s%8s%8s%8s%8s", kNameColumnWidth, "block (ms)", "avg",
+                "min", "max", "gpu");
+  m_lines.emplaceBack().element().append(buffer);
+
+  for (U32 index : m_order) {
+    const auto& node = m_nodes[index];
+
+    // Indent the name by its depth in the tree.
+    I32 indent = static_cast<I32>(node.depth) * 2;
+    I32 nameWidth = std::max(kNameColumnWidth - indent, 0);
+    const auto name = node.name.view();
+
+    I32 length = std::snprintf(
+        buffer, sizeof(buffer), "%*s%-*.*s%8.2f%8.2f%8.2f", indent, "", nameWidth,
+        static_cast<I32>(std::min<MemSize>(name.length(), static_cast<MemSize>(nameWidth))),
+        name.data(), node.cpu.average(), node.cpu.minimum(), node.cpu.maximum());
+
+    if (node.gpu.count && length > 0 && length < static_cast<I32>(sizeof(buffer))) {
+      std::snprintf(buffer + length, sizeof(buffer) - static_cast<MemSize>(length), "%8.2f",
+                    node.gpu.average());
+    }
+
+    m_lines.emplaceBack().element().append(buffer);
+  }
+}
 
 }  // namespace ca
@@ -2,28 +2,63 @@
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 #include "canvas/windows/window.h"
 #include "nucleus/high_resolution_timer.h"
 
 namespace ca {
 
+namespace {
+
+// How often an iconified window still runs tasks.
+constexpr F64 kIconifiedWaitSeconds = 0.25;
+
+// Sleeps can overshoot by about a scheduler tick, so the end of a wait is spun instead.
+constexpr F64 kSpinMicroseconds = 2000.0;
+
+void sleep_until(F64 deadline) {
+  for (;;) {
+    F64 remaining = deadline - nu::getTimeInMicroseconds();
+    if (remaining <= 0.0) {
+      return;
+    }
+
+    if (remaining > kSpinMicroseconds) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds{static_cast<I64>(remaining - kSpinMicroseconds)});
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+}  // namespace
+
 MessagePumpUI::MessagePumpUI(Window* window) : window_{window} {}
 
 MessagePumpUI::~MessagePumpUI() {}
 
-void MessagePumpUI::schedule_task() {}
+void MessagePumpUI::schedule_task() {
+  task_pending_.store(true, std::memory_order_release);
+  window_->wakeUp();
+}
 
 void MessagePumpUI::run(nu::MessagePump::Delegate* delegate) {
   auto tick = nu::getTimeInMicroseconds();
 
   for (;;) {
     {
-      bool has_more_work = window_->processEvents();
+      bool has_more_work = wait_for_frame();
       if (!has_more_work) {
         break;
       }
     }
 
+    task_pending_.store(false, std::memory_order_release);
+
     auto now = nu::getTimeInMicroseconds();
     window_->tick(static_cast<F32>(1000000.0 / 60.0 / (now - tick)));
     tick = now;
@@ -35,8 +70,51 @@ void MessagePumpUI::run(nu::MessagePump::Delegate* delegate) {
       }
     }
 
+    if (window_->isIconified()) {
+      continue;
+    }
+
+    if (window_->framePacing().mode == FramePacingMode::OnDemand && !window_->needsPaint()) {
+      continue;
+    }
+
+    last_paint_time_ = nu::getTimeInMicroseconds();
     window_->paint();
   }
 }
 
+bool MessagePumpUI::wait_for_frame() {
+  const auto wait_start = nu::getTimeInMicroseconds();
+  bool keep_running;
+
+  const auto& pacing = window_->framePacing();
+  if (window_->isIconified()) {
+    keep_running = window_->waitEvents(kIconifiedWaitSeconds);
+  } else if (pacing.mode == FramePacingMode::OnDemand && !window_->needsPaint() &&
+             !task_pending_.load(std::memory_order_acquire)) {
+    keep_running = window_->waitEvents(pacing.idleTimeoutSeconds);
+  } else {
+    F64 interval = frame_interval();
+    if (interval > 0.0) {
+      sleep_until(last_paint_time_ + interval);
+    }
+    keep_running = window_->processEvents();
+  }
+
+  window_->addIdleTime(nu::getTimeInMicroseconds() - wait_start);
+
+  return keep_running;
+}
+
+F64 MessagePumpUI::frame_interval() const {
+  const auto& pacing = window_->framePacing();
+
+  F64 fps = pacing.mode == FramePacingMode::Continuous ? 0.0 : pacing.maxFps;
+  if (pacing.backgroundFps > 0.0 && !window_->isFocused()) {
+    fps = fps > 0.0 ? std::min(fps, pacing.backgroundFps) : pacing.backgroundFps;
+  }
+
+  return fps > 0.0 ? 1000000.0 / fps : 0.0;
+}
+
 }  // namespace ca
@@ -0,0 +1,95 @@
+#include "canvas/renderer/frame_allocator.h"
+
+#include <cstdlib>
+
+namespace ca {
+
+namespace {
+
+MemSize align_up(MemSize value, MemSize alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+FrameAllocator::FrameAllocator(MemSize capacity) {
+  for (auto& arena : arenas_) {
+    arena.data = static_cast<U8*>(std::malloc(capacity));
+    arena.capacity = arena.data ? capacity : 0;
+  }
+}
+
+FrameAllocator::~FrameAllocator() {
+  for (auto& arena : arenas_) {
+    release(&arena);
+    std::free(arena.data);
+  }
+}
+
+void FrameAllocator::reset() {
+  current_ = 1 - current_;
+  ++frame_;
+  Arena& arena = arenas_[current_];
+
+  // The frame that last used this arena didn't fit, so grow it to what that frame needed.
+  if (arena.overflow) {
+    MemSize needed = arena.used + arena.overflow_bytes;
+    release(&arena);
+
+    std::free(arena.data);
+    MemSize capacity = needed + needed / 4;
+    arena.data = static_cast<U8*>(std::malloc(capacity));
+    arena.capacity = arena.data ? capacity : 0;
+  }
+
+  arena.used = 0;
+}
+
+void* FrameAllocator::allocate(MemSize size, MemSize alignment) {
+  Arena& arena = arenas_[current_];
+
+  MemSize offset = align_up(reinterpret_cast<MemSize>(arena.data) + arena.used, alignment) -
+                   reinterpret_cast<MemSize>(arena.data);
+  if (arena.data && offset + size <= arena.capacity) {
+    arena.used = offset + size;
+    MemSize used = arena.used + arena.overflow_bytes;
+    high_water_mark_ = used > high_water_mark_ ? used : high_water_mark_;
+    return arena.data + offset;
+  }
+
+  if (!arena.overflow) {
+    ++overflow_frames_;
+    LOG(Warning) << "Frame allocator out of space (" << arena.capacity
+                 << " bytes), using the heap for the rest of the frame.";
+  }
+
+  // Heap blocks are chained through a header in front of the aligned allocation.
+  auto* block = static_cast<U8*>(std::malloc(sizeof(Overflow) + alignment + size));
+  if (!block) {
+    return nullptr;
+  }
+
+  auto* overflow = reinterpret_cast<Overflow*>(block);
+  overflow->next = arena.overflow;
+  arena.overflow = overflow;
+  arena.overflow_bytes += size;
+
+  MemSize used = arena.used + arena.overflow_bytes;
+  high_water_mark_ = used > high_water_mark_ ? used : high_water_mark_;
+
+  MemSize address = align_up(reinterpret_cast<MemSize>(block) + sizeof(Overflow), alignment);
+  return reinterpret_cast<void*>(address);
+}
+
+void FrameAllocator::release(Arena* arena) {
+  Overflow* overflow = arena->overflow;
+  while (overflow) {
+    Overflow* next = overflow->next;
+    std::free(overflow);
+    overflow = next;
+  }
+  arena->overflow = nullptr;
+  arena->overflow_bytes = 0;
+}
+
+}  // namespace ca
@@ -0,0 +1,93 @@
+#include "canvas/renderer/frame_packet.h"
+
+#include <cstring>
+
+#include "nucleus/logging.h"
+
+namespace ca {
+
+void FramePacket::reset() {
+  commands_.clear();
+  begin_frames_.clear();
+  clear_colors_.clear();
+  draws_.clear();
+  uniforms_.clear();
+  uploads_.clear();
+  gpu_scope_names_.clear();
+  data_.clear();
+}
+
+void FramePacket::set_gpu_timings(const nu::DynamicArray<GpuScopeTiming>& timings) {
+  gpu_timings_.clear();
+  for (const auto& timing : timings) {
+    gpu_timings_.pushBack(timing);
+  }
+}
+
+void FramePacket::record_begin_frame(const fl::Pos& damage_position, const fl::Size& damage_size) {
+  add_command(CommandType::BeginFrame, begin_frames_.size());
+  begin_frames_.pushBack(BeginFrameCommand{damage_position, damage_size});
+}
+
+void FramePacket::record_end_frame() {
+  add_command(CommandType::EndFrame, 0);
+}
+
+void FramePacket::record_clear(const Color& color) {
+  add_command(CommandType::Clear, clear_colors_.size());
+  clear_colors_.pushBack(color);
+}
+
+void FramePacket::record_draw(CommandType type, const DrawCommand& draw,
+                              const UniformBuffer& uniforms) {
+  DCHECK(type == CommandType::Draw || type == CommandType::DrawIndexed ||
+         type == CommandType::DrawInstanced)
+      << "Not a draw command.";
+
+  add_command(type, draws_.size());
+  DrawCommand& recorded = draws_.pushBack(draw).element();
+  recorded.first_uniform = static_cast<U32>(uniforms_.size());
+
+  uniforms.apply([this](UniformId uniform_id, ComponentType type, U32 count, const void* values) {
+    RecordedUniform& uniform = uniforms_.emplaceBack().element();
+    uniform.uniform_id = uniform_id;
+    uniform.type = type;
+    uniform.count = count;
+    // Every component type uniforms can have is 4 bytes.
+    std::memcpy(uniform.data, values, count * 4);
+  });
+
+  recorded.uniform_count = static_cast<U32>(uniforms_.size()) - recorded.first_uniform;
+}
+
+void FramePacket::record_upload(CommandType type, MemSize resource_id, const fl::Pos& position,
+                                const fl::Size& size, const void* data, MemSize data_size) {
+  add_command(type, uploads_.size());
+  uploads_.pushBack(UploadCommand{resource_id, position, size, add_data(data, data_size)});
+}
+
+void FramePacket::record_begin_gpu_scope(nu::StringView name) {
+  add_command(CommandType::BeginGpuScope, gpu_scope_names_.size());
+  gpu_scope_names_.pushBack(add_data(name.data(), name.length()));
+}
+
+void FramePacket::record_end_gpu_scope() {
+  add_command(CommandType::EndGpuScope, 0);
+}
+
+void FramePacket::add_command(CommandType type, MemSize index) {
+  commands_.pushBack(Command{type, static_cast<U32>(index)});
+}
+
+DataRange FramePacket::add_data(const void* data, MemSize size) {
+  DataRange range{data_.size(), size};
+  if (data && size) {
+    data_.resize(range.offset + size);
+    std::memcpy(data_.data() + range.offset, data, size);
+  } else {
+    range.size = 0;
+  }
+  return range;
+}
+
+}  // namespace ca
@@ -0,0 +1,148 @@
+#include "canvas/renderer/gpu_profiler.h"
+
+#include "canvas/opengl.h"
+#include "canvas/renderer/renderer.h"
+#include "canvas/utils/gl_check.h"
+
+namespace ca {
+
+void GpuProfiler::set_enabled(bool enabled) {
+  enabled_ = enabled;
+
+  if (!enabled_) {
+    for (auto& frame : frames_) {
+      release(&frame);
+    }
+    timings_.clear();
+  }
+}
+
+void GpuProfiler::begin_frame() {
+  if (!enabled_) {
+    return;
+  }
+
+  current_frame_ = (current_frame_ + 1) % kFrameLatency;
+
+  // The oldest frame is reused for this one, so it has to be read now if it ever will be.
+  Frame& frame = frames_[current_frame_];
+  resolve(&frame);
+  release(&frame);
+
+  open_scopes_.clear();
+  in_frame_ = true;
+}
+
+void GpuProfiler::end_frame() {
+  in_frame_ = false;
+}
+
+void GpuProfiler::begin_scope(nu::StringView name) {
+  if (!enabled_ || !in_frame_) {
+    return;
+  }
+
+  Frame& frame = frames_[current_frame_];
+
+  U64 parent_key = kHashSeed;
+  if (!open_scopes_.empty()) {
+    parent_key = frame.scopes[open_scopes_[open_scopes_.size() - 1]].key;
+  }
+
+  U32 begin_query = acquire_query();
+  GL_CHECK(glQueryCounter(begin_query, GL_TIMESTAMP));
+
+  open_scopes_.pushBack(static_cast<U32>(frame.scopes.size()));
+  frame.scopes.pushBack(Scope{profile_scope_key(parent_key, name),
+                              static_cast<U32>(open_scopes_.size() - 1), begin_query, 0});
+}
+
+void GpuProfiler::end_scope() {
+  if (!enabled_ || !in_frame_ || open_scopes_.empty()) {
+    return;
+  }
+
+  U32 end_query = acquire_query();
+  GL_CHECK(glQueryCounter(end_query, GL_TIMESTAMP));
+
+  Frame& frame = frames_[current_frame_];
+  frame.scopes[open_scopes_[open_scopes_.size() - 1]].end_query = end_query;
+  frame.last_query = end_query;
+  open_scopes_.resize(open_scopes_.size() - 1);
+}
+
+void GpuProfiler::delete_queries() {
+  for (auto& frame : frames_) {
+    frame.scopes.clear();
+    frame.last_query = 0;
+  }
+  open_scopes_.clear();
+  free_queries_.clear();
+
+  if (!queries_.empty()) {
+    GL_CHECK(glDeleteQueries(static_cast<GLsizei>(queries_.size()), queries_.data()));
+    queries_.clear();
+  }
+}
+
+U32 GpuProfiler::acquire_query() {
+  if (!free_queries_.empty()) {
+    U32 query = free_queries_[free_queries_.size() - 1];
+    free_queries_.resize(free_queries_.size() - 1);
+    return query;
+  }
+
+  U32 query = 0;
+  GL_CHECK(glGenQueries(1, &query));
+  queries_.pushBack(query);
+  return query;
+}
+
+void GpuProfiler::resolve(Frame* frame) {
+  if (!frame->last_query) {
+    return;
+  }
+
+  GLint available = 0;
+  GL_CHECK(glGetQueryObjectiv(frame->last_query, GL_QUERY_RESULT_AVAILABLE, &available));
+  if (!available) {
+    ++dropped_frames_;
+    return;
+  }
+
+  timings_.clear();
+  for (const Scope& scope : frame->scopes) {
+    if (!scope.end_query) {
+      continue;
+    }
+
+    GLuint64 begin = 0;
+    GLuint64 end = 0;
+    GL_CHECK(glGetQueryObjectui64v(scope.begin_query, GL_QUERY_RESULT, &begin));
+    GL_CHECK(glGetQueryObjectui64v(scope.end_query, GL_QUERY_RESULT, &end));
+
+    timings_.pushBack(
+        GpuScopeTiming{scope.key, scope.depth, static_cast<F64>(end - begin) / 1000000.0});
+  }
+}
+
+void GpuProfiler::release(Frame* frame) {
+  for (const Scope& scope : frame->scopes) {
+    free_queries_.pushBack(scope.begin_query);
+    if (scope.end_query) {
+      free_queries_.pushBack(scope.end_query);
+    }
+  }
+  frame->scopes.clear();
+  frame->last_query = 0;
+}
+
+GpuProfileScope::GpuProfileScope(Renderer* renderer, nu::StringView name) : renderer_{renderer} {
+  renderer_->begin_gpu_scope(name);
+}
+
+GpuProfileScope::~GpuProfileScope() {
+  renderer_->end_gpu_scope();
+}
+
+}  // namespace ca
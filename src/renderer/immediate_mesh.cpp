@@ -2,9 +2,12 @@
 
 namespace ca {
 
-ImmediateMesh::ImmediateMesh(ImmediateRenderer* immediate_renderer, DrawType draw_type,
-                             const fl::Mat4& transform)
-  : immediate_renderer_{immediate_renderer}, draw_type_{draw_type}, transform_{transform} {}
+ImmediateMesh::ImmediateMesh(ImmediateRenderer* immediate_renderer, FrameAllocator* allocator,
+                             DrawType draw_type, const fl::Mat4& transform)
+  : immediate_renderer_{immediate_renderer},
+    draw_type_{draw_type},
+    transform_{transform},
+    vertices_{allocator} {}
 
 ImmediateMesh& ImmediateMesh::transform(const fl::Mat4& transform) {
   transform_ = transform;
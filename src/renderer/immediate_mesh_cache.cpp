@@ -0,0 +1,100 @@
+#include "canvas/renderer/immediate_mesh_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "canvas/renderer/renderer.h"
+
+namespace ca {
+
+ImmediateMeshCache::ImmediateMeshCache(Renderer* renderer,
+                                       const VertexDefinition& vertex_definition, MemSize budget)
+  : renderer_{renderer}, vertex_definition_{vertex_definition}, budget_{budget} {}
+
+ImmediateMeshCache::~ImmediateMeshCache() {
+  // Evicted entries keep their buffers for reuse, so they are deleted too.
+  for (const auto& entry : entries_) {
+    renderer_->delete_vertex_buffer(entry.vertex_buffer_id);
+  }
+}
+
+void ImmediateMeshCache::set_budget(MemSize bytes) {
+  budget_ = bytes;
+  evict_to_budget();
+}
+
+void ImmediateMeshCache::begin_frame() {
+  ++frame_;
+
+  std::swap(previous_candidates_, candidates_);
+  candidates_.clear();
+  std::sort(previous_candidates_.begin(), previous_candidates_.end());
+}
+
+VertexBufferId ImmediateMeshCache::find_or_upload(U64 key, const void* data, MemSize size) {
+  // Keys are only hashes, so the content is compared too.
+  U32 index = table_.find(key, [&](U32 candidate) {
+    const Entry& entry = entries_[candidate];
+    return entry.bytes == size && std::memcmp(entry.data.data(), data, size) == 0;
+  });
+  if (index != LruTable::kInvalidEntry) {
+    ++statistics_.hits;
+    table_.touch(index, frame_);
+    return entries_[index].vertex_buffer_id;
+  }
+
+  ++statistics_.misses;
+
+  if (!std::binary_search(previous_candidates_.begin(), previous_candidates_.end(), key)) {
+    candidates_.pushBack(key);
+    return {};
+  }
+
+  // Reuse the vertex buffer of an evicted entry if there is one.
+  index = table_.take_free_entry();
+  if (index != LruTable::kInvalidEntry) {
+    renderer_->vertex_buffer_data(entries_[index].vertex_buffer_id, data, size);
+  } else {
+    index = table_.add_entry();
+    entries_.emplaceBack().element().vertex_buffer_id =
+        renderer_->create_vertex_buffer(vertex_definition_, data, size);
+  }
+
+  Entry& entry = entries_[index];
+  entry.bytes = size;
+  entry.data.resize(size);
+  std::memcpy(entry.data.data(), data, size);
+  table_.insert(index, key, frame_);
+
+  statistics_.bytes += size;
+  ++statistics_.entry_count;
+
+  evict_to_budget();
+
+  return entries_[index].vertex_buffer_id;
+}
+
+void ImmediateMeshCache::evict_to_budget() {
+  while (statistics_.bytes > budget_) {
+    U32 index = table_.evictable(frame_);
+    if (index == LruTable::kInvalidEntry) {
+      break;
+    }
+
+    table_.remove(index);
+
+    // Release the storage but keep the buffer around for the next entry.
+    Entry& entry = entries_[index];
+    renderer_->vertex_buffer_data(entry.vertex_buffer_id, nullptr, 0);
+
+    statistics_.bytes -= entry.bytes;
+    --statistics_.entry_count;
+    ++statistics_.evictions;
+
+    entry.bytes = 0;
+    entry.data.clear();
+  }
+}
+
+}  // namespace ca
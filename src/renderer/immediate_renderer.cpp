@@ -1,7 +1,12 @@
 #include "canvas/renderer/immediate_renderer.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "canvas/renderer/renderer.h"
 #include "canvas/renderer/vertex_definition.h"
+#include "canvas/utils/hash.h"
+#include "canvas/utils/simd_math.h"
 
 namespace ca {
 
@@ -35,49 +40,309 @@ void main() {
 }
 )source";
 
+auto g_clip_vertex_shader_source = R"source(
+#version 330
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inColor;
+
+out vec4 vsColor;
+
+void main() {
+  gl_Position = inPosition;
+  vsColor = inColor;
+}
+)source";
+
 ProgramId g_program_id{INVALID_RESOURCE_ID};
+ProgramId g_clip_program_id{INVALID_RESOURCE_ID};
+
+// Transforming a few hundred vertices on the CPU costs about as much as the draw call and uniform
+// upload it saves.
+constexpr U32 kDefaultPreTransformLimit = 256;
+
+// Smaller meshes are cheaper to stream with the rest of the frame than to draw on their own.
+constexpr U32 kDefaultCacheMinVertices = 64;
+constexpr MemSize kDefaultCacheBudget = 4 * 1024 * 1024;
+
+VertexDefinition vertex_definition() {
+  VertexDefinition def;
+  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
+  def.addAttribute(ComponentType::Float32, ComponentCount::Four);
+  return def;
+}
+
+// Strips and fans are drawn as lists so that meshes of the same kind can share a draw.
+DrawType list_type(DrawType draw_type) {
+  switch (draw_type) {
+    case DrawType::LineStrip:
+      return DrawType::Lines;
+
+    case DrawType::TriangleStrip:
+    case DrawType::TriangleFan:
+      return DrawType::Triangles;
+
+    default:
+      return draw_type;
+  }
+}
+
+MemSize list_vertex_count(DrawType draw_type, MemSize count) {
+  switch (draw_type) {
+    case DrawType::LineStrip:
+      return count > 1 ? (count - 1) * 2 : 0;
+
+    case DrawType::TriangleStrip:
+    case DrawType::TriangleFan:
+      return count > 2 ? (count - 2) * 3 : 0;
+
+    default:
+      return count;
+  }
+}
+
+template <typename Vertex>
+void append_as_list(DrawType draw_type, const FrameArray<Vertex>& source,
+                    FrameArray<Vertex>* destination) {
+  MemSize count = source.size();
+
+  switch (draw_type) {
+    case DrawType::LineStrip:
+      for (MemSize i = 1; i < count; ++i) {
+        destination->pushBack(source[i - 1]);
+        destination->pushBack(source[i]);
+      }
+      break;
+
+    case DrawType::TriangleStrip:
+      // Every other triangle in a strip has its first two vertices swapped to keep the winding.
+      for (MemSize i = 2; i < count; ++i) {
+        bool even = (i % 2) == 0;
+        destination->pushBack(source[even ? i - 2 : i - 1]);
+        destination->pushBack(source[even ? i - 1 : i - 2]);
+        destination->pushBack(source[i]);
+      }
+      break;
+
+    case DrawType::TriangleFan:
+      for (MemSize i = 2; i < count; ++i) {
+        destination->pushBack(source[0]);
+        destination->pushBack(source[i - 1]);
+        destination->pushBack(source[i]);
+      }
+      break;
+
+    default:
+      for (const auto& vertex : source) {
+        destination->pushBack(vertex);
+      }
+      break;
+  }
+}
 
 }  // namespace
 
-ImmediateRenderer::ImmediateRenderer(Renderer* renderer) : renderer_{renderer} {}
+ImmediateRenderer::ImmediateRenderer(Renderer* renderer)
+  : renderer_{renderer},
+    meshes_{renderer->frame_allocator()},
+    vertices_{renderer->frame_allocator()},
+    mesh_order_{renderer->frame_allocator()},
+    mesh_keys_{renderer->frame_allocator()},
+    batches_{renderer->frame_allocator()},
+    pre_transform_limit_{kDefaultPreTransformLimit},
+    clip_vertices_{renderer->frame_allocator()},
+    clip_batches_{renderer->frame_allocator()},
+    cache_min_vertices_{kDefaultCacheMinVertices},
+    cache_{renderer, vertex_definition(), kDefaultCacheBudget},
+    cached_draws_{renderer->frame_allocator()} {}
 
 ImmediateRenderer::~ImmediateRenderer() {
   if (!meshes_.empty()) {
     LOG(Warning) << "ImmediateRenderer contains meshes. Call flush_to_renderer().";
   }
+
+  if (vertex_buffer_id_.is_valid()) {
+    renderer_->delete_vertex_buffer(vertex_buffer_id_);
+    renderer_->delete_vertex_buffer(clip_vertex_buffer_id_);
+  }
 }
 
 ImmediateMesh& ImmediateRenderer::create_mesh(DrawType draw_type, const fl::Mat4& transform) {
-  auto result = meshes_.emplaceBack(this, draw_type, transform);
-  return result.element();
+  return meshes_.emplaceBack(this, renderer_->frame_allocator(), draw_type, transform);
 }
 
 void ImmediateRenderer::submit_to_renderer() {
+  if (meshes_.empty()) {
+    return;
+  }
+
   if (!g_program_id.is_valid()) {
     g_program_id = renderer_->create_program(ShaderSource::from(g_vertex_shader_source),
                                              ShaderSource::from(g_fragment_shader_source));
+    g_clip_program_id = renderer_->create_program(ShaderSource::from(g_clip_vertex_shader_source),
+                                                  ShaderSource::from(g_fragment_shader_source));
   }
 
-  VertexDefinition def;
-  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
-  def.addAttribute(ComponentType::Float32, ComponentCount::Four);
+  if (!vertex_buffer_id_.is_valid()) {
+    vertex_buffer_id_ = renderer_->create_vertex_buffer(vertex_definition(), nullptr, 0);
+    transform_uniform_id_ = renderer_->create_uniform("uTransform");
 
-  for (const auto& mesh : meshes_) {
-    auto vertex_buffer_id = renderer_->create_vertex_buffer(
-        def, mesh.vertices_.data(), mesh.vertices_.size() * sizeof(ImmediateMesh::Vertex));
+    VertexDefinition clip_def;
+    clip_def.addAttribute(ComponentType::Float32, ComponentCount::Four);
+    clip_def.addAttribute(ComponentType::Float32, ComponentCount::Four);
 
-    auto transform_uniform_id = renderer_->create_uniform("uTransform");
+    clip_vertex_buffer_id_ = renderer_->create_vertex_buffer(clip_def, nullptr, 0);
+  }
+
+  cache_.begin_frame();
+  build_batches();
 
+  for (const auto& draw : cached_draws_) {
     UniformBuffer uniforms;
-    uniforms.set(transform_uniform_id, mesh.transform_);
+    uniforms.set(transform_uniform_id_, meshes_[draw.mesh_index].transform_);
+
+    renderer_->draw(draw.draw_type, 0, draw.vertex_count, g_program_id, draw.vertex_buffer_id, {},
+                    uniforms);
+  }
+
+  if (!vertices_.empty()) {
+    renderer_->stream_vertex_buffer_data(vertex_buffer_id_, vertices_.data(),
+                                         vertices_.size() * sizeof(ImmediateMesh::Vertex));
 
-    renderer_->draw(mesh.draw_type_, 0, static_cast<U32>(mesh.vertices_.size()), g_program_id,
-                    vertex_buffer_id, {}, uniforms);
+    for (const auto& batch : batches_) {
+      UniformBuffer uniforms;
+      uniforms.set(transform_uniform_id_, meshes_[batch.transform_index].transform_);
 
-    renderer_->delete_vertex_buffer(vertex_buffer_id);
+      renderer_->draw(batch.draw_type, batch.vertex_offset, batch.vertex_count, g_program_id,
+                      vertex_buffer_id_, {}, uniforms);
+    }
+  }
+
+  if (!clip_vertices_.empty()) {
+    renderer_->stream_vertex_buffer_data(clip_vertex_buffer_id_, clip_vertices_.data(),
+                                         clip_vertices_.size() * sizeof(ClipVertex));
+
+    for (const auto& batch : clip_batches_) {
+      renderer_->draw(batch.draw_type, batch.vertex_offset, batch.vertex_count,
+                      g_clip_program_id, clip_vertex_buffer_id_);
+    }
   }
 
   meshes_.clear();
+  vertices_.clear();
+  mesh_order_.clear();
+  mesh_keys_.clear();
+  batches_.clear();
+  clip_vertices_.clear();
+  clip_batches_.clear();
+  cached_draws_.clear();
+}
+
+bool ImmediateRenderer::should_cache(const ImmediateMesh& mesh) const {
+  return cache_min_vertices_ > 0 && cache_.budget() > 0 &&
+         mesh.vertices_.size() >= cache_min_vertices_;
+}
+
+void ImmediateRenderer::build_batches() {
+  MemSize mesh_count = meshes_.size();
+
+  // Order meshes by draw type, then transform, keeping the order they were created in within
+  // each group.  The draw type goes in the top bits so that all groups of a type are adjacent.
+  mesh_keys_.reserve(mesh_count);
+  mesh_order_.reserve(mesh_count);
+  for (U32 i = 0; i < mesh_count; ++i) {
+    const auto& mesh = meshes_[i];
+
+    if (should_cache(mesh)) {
+      MemSize size = mesh.vertices_.size() * sizeof(ImmediateMesh::Vertex);
+      U64 key = hash_bytes(mesh.vertices_.data(), size,
+                           hash_bytes(&mesh.draw_type_, sizeof(mesh.draw_type_)));
+
+      // Meshes the cache doesn't take yet are batched like the others.
+      VertexBufferId vertex_buffer_id = cache_.find_or_upload(key, mesh.vertices_.data(), size);
+      if (vertex_buffer_id.is_valid()) {
+        cached_draws_.emplaceBack(CachedDraw{mesh.draw_type_, i, vertex_buffer_id,
+                                             static_cast<U32>(mesh.vertices_.size())});
+
+        // Keys are indexed by mesh, but cached meshes are left out of the order.
+        mesh_keys_.pushBack(0);
+        continue;
+      }
+    }
+
+    U64 draw_type = static_cast<U64>(list_type(mesh.draw_type_));
+    U64 transform_hash = hash_bytes(&mesh.transform_, sizeof(mesh.transform_));
+    mesh_keys_.pushBack((draw_type << 56) | (transform_hash >> 8));
+    mesh_order_.pushBack(i);
+  }
+  std::stable_sort(mesh_order_.begin(), mesh_order_.end(),
+                   [this](U32 left, U32 right) { return mesh_keys_[left] < mesh_keys_[right]; });
+
+  MemSize group_count = mesh_order_.size();
+  MemSize group_begin = 0;
+  while (group_begin < group_count) {
+    const auto& first = meshes_[mesh_order_[group_begin]];
+    DrawType draw_type = list_type(first.draw_type_);
+
+    // Find the end of the group and how many list vertices it has.
+    MemSize group_end = group_begin;
+    U32 vertex_count = 0;
+    for (; group_end < group_count; ++group_end) {
+      const auto& mesh = meshes_[mesh_order_[group_end]];
+      if (list_type(mesh.draw_type_) != draw_type ||
+          std::memcmp(&first.transform_, &mesh.transform_, sizeof(mesh.transform_)) != 0) {
+        break;
+      }
+      vertex_count += list_vertex_count(mesh.draw_type_, mesh.vertices_.size());
+    }
+
+    if (vertex_count == 0) {
+      // Nothing to draw, e.g. a strip with a single vertex.
+    } else if (vertex_count <= pre_transform_limit_) {
+      append_pre_transformed(draw_type, group_begin, group_end);
+    } else {
+      batches_.emplaceBack(
+          Batch{draw_type, mesh_order_[group_begin], static_cast<U32>(vertices_.size()), 0});
+      for (MemSize i = group_begin; i < group_end; ++i) {
+        const auto& mesh = meshes_[mesh_order_[i]];
+        append_as_list(mesh.draw_type_, mesh.vertices_, &vertices_);
+      }
+      Batch& batch = batches_[batches_.size() - 1];
+      batch.vertex_count = static_cast<U32>(vertices_.size()) - batch.vertex_offset;
+    }
+
+    group_begin = group_end;
+  }
+}
+
+void ImmediateRenderer::append_pre_transformed(DrawType draw_type, MemSize group_begin,
+                                               MemSize group_end) {
+  // Groups are ordered by draw type, so all CPU transformed groups of a type share a batch.
+  if (clip_batches_.empty() || clip_batches_[clip_batches_.size() - 1].draw_type != draw_type) {
+    clip_batches_.emplaceBack(
+        Batch{draw_type, 0, static_cast<U32>(clip_vertices_.size()), 0});
+  }
+
+  const fl::Mat4& transform = meshes_[mesh_order_[group_begin]].transform_;
+
+  // Convert to a list in the regular vertex array, transform from there and drop the copy.
+  MemSize list_begin = vertices_.size();
+  for (MemSize i = group_begin; i < group_end; ++i) {
+    const auto& mesh = meshes_[mesh_order_[i]];
+    append_as_list(mesh.draw_type_, mesh.vertices_, &vertices_);
+  }
+
+  MemSize count = vertices_.size() - list_begin;
+  MemSize clip_begin = clip_vertices_.size();
+  for (MemSize i = list_begin; i < vertices_.size(); ++i) {
+    clip_vertices_.emplaceBack(ClipVertex{{0.0f, 0.0f, 0.0f, 1.0f}, vertices_[i].color});
+  }
+
+  transform_points(transform, &vertices_[list_begin].position, sizeof(ImmediateMesh::Vertex),
+                   clip_vertices_[clip_begin].position, sizeof(ClipVertex), count);
+
+  vertices_.shrink(list_begin);
+  clip_batches_[clip_batches_.size() - 1].vertex_count += static_cast<U32>(count);
 }
 
 }  // namespace ca
@@ -1,5 +1,8 @@
 #include "canvas/renderer/line_renderer.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "canvas/renderer/renderer.h"
 
 namespace ca {
@@ -33,26 +36,213 @@ void main() {
 }
 )";
 
+// Expands each instance to a quad across the line, widened by a pixel on both sides for the
+// anti-aliased edge.  Vertex 0 and 1 are at `p1`, 2 and 3 at `p2`.
+const I8* kWideVertexShaderSource = R"(
+#version 330
+
+layout(location = 0) in vec3 inP1;
+layout(location = 1) in vec3 inP2;
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in float inWidth;
+
+uniform mat4 uTransform;
+uniform vec2 uViewportSize;
+
+out vec4 vColor;
+noperspective out float vDistance;
+flat out float vHalfWidth;
+
+// Ends behind the camera are moved along the line to just in front of it before the divide by w,
+// which would otherwise flip them to the other side of the screen.
+const float kMinW = 1e-5;
+
+void main() {
+  vec4 c1 = uTransform * vec4(inP1, 1.0);
+  vec4 c2 = uTransform * vec4(inP2, 1.0);
+
+  if (c1.w < kMinW && c2.w < kMinW) {
+    // Entirely behind the camera: collapse the quad so nothing is drawn.
+    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+    vColor = vec4(0.0);
+    vDistance = 0.0;
+    vHalfWidth = 0.0;
+    return;
+  }
+
+  if (c1.w < kMinW) {
+    c1 = mix(c1, c2, (kMinW - c1.w) / (c2.w - c1.w));
+  } else if (c2.w < kMinW) {
+    c2 = mix(c2, c1, (kMinW - c2.w) / (c1.w - c2.w));
+  }
+
+  vec2 halfViewport = uViewportSize * 0.5;
+  vec2 direction = (c2.xy / c2.w - c1.xy / c1.w) * halfViewport;
+  float len = length(direction);
+  direction = len > 0.0 ? direction / len : vec2(1.0, 0.0);
+  vec2 normal = vec2(-direction.y, direction.x);
+
+  float side = float(gl_VertexID & 1) * 2.0 - 1.0;
+  float extent = inWidth * 0.5 + 1.0;
+
+  vec4 position = (gl_VertexID < 2) ? c1 : c2;
+  position.xy += normal * side * extent / halfViewport * position.w;
+
+  vColor = inColor;
+  vDistance = side * extent;
+  vHalfWidth = inWidth * 0.5;
+  gl_Position = position;
+}
+)";
+
+const I8* kWideFragmentShaderSource = R"(
+#version 330
+
+in vec4 vColor;
+noperspective in float vDistance;
+flat in float vHalfWidth;
+
+out vec4 final;
+
+void main() {
+  float coverage = clamp(vHalfWidth + 0.5 - abs(vDistance), 0.0, 1.0);
+  final = vec4(vColor.rgb, vColor.a * coverage);
+}
+)";
+
+// Spans the grid's plane with a quad and draws the lines analytically.  Line width is measured in
+// screen space with `fwidth`, and lines fade out towards the edge of the grid and where they get
+// closer together than a couple of pixels.
+const I8* kGridVertexShaderSource = R"(
+#version 330
+
+layout(location = 0) in vec3 inCenter;
+layout(location = 1) in vec3 inRight;
+layout(location = 2) in vec3 inForward;
+layout(location = 3) in vec4 inColor;
+layout(location = 4) in float inExtent;
+layout(location = 5) in float inBlockSize;
+
+uniform mat4 uTransform;
+
+out vec2 vCoord;
+flat out float vBlocks;
+flat out vec4 vColor;
+
+void main() {
+  vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+  vec3 position = inCenter + (inRight * corner.x + inForward * corner.y) * inExtent;
+
+  vCoord = corner * inExtent / inBlockSize;
+  vBlocks = inExtent / inBlockSize;
+  vColor = inColor;
+  gl_Position = uTransform * vec4(position, 1.0);
+}
+)";
+
+const I8* kGridFragmentShaderSource = R"(
+#version 330
+
+in vec2 vCoord;
+flat in float vBlocks;
+flat in vec4 vColor;
+
+out vec4 final;
+
+void main() {
+  vec2 derivative = fwidth(vCoord);
+  vec2 distance = abs(fract(vCoord - 0.5) - 0.5) / derivative;
+  float line = 1.0 - min(min(distance.x, distance.y), 1.0);
+
+  // Fade by the distance along the larger axis, so the grid keeps its square outline.
+  vec2 edge = abs(vCoord) / vBlocks;
+  float edgeFade = 1.0 - smoothstep(0.6, 1.0, max(edge.x, edge.y));
+  float densityFade = 1.0 - smoothstep(0.25, 0.5, max(derivative.x, derivative.y));
+
+  float alpha = vColor.a * line * edgeFade * densityFade;
+  if (alpha <= 0.0) {
+    discard;
+  }
+  final = vec4(vColor.rgb, alpha);
+}
+)";
+
+VertexDefinition lineVertexDefinition() {
+  VertexDefinition def;
+  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
+  def.addAttribute(ComponentType::Float32, ComponentCount::Four);
+  return def;
+}
+
+VertexDefinition wideLineVertexDefinition() {
+  VertexDefinition def;
+  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
+  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
+  def.addAttribute(ComponentType::Unsigned8, ComponentCount::Four, true);
+  def.addAttribute(ComponentType::Float32, ComponentCount::One);
+  def.setDivisor(1);
+  return def;
+}
+
+// Lines uploaded per draw.  Keeps every upload to a few megabytes, however many lines there are.
+constexpr MemSize kLinesPerChunk = 64 * 1024;
+
+// A layer id holds the slot index in its low 32 bits and the slot's generation in the high ones.
+LineLayerId makeLayerId(MemSize index, U32 generation) {
+  return LineLayerId{static_cast<MemSize>(generation) << 32 | index};
+}
+
+MemSize layerIndex(LineLayerId id) {
+  return id.id & 0xffffffff;
+}
+
+U32 layerGeneration(LineLayerId id) {
+  return static_cast<U32>(id.id >> 32);
+}
+
 }  // namespace
 
 LineRenderer::LineRenderer() = default;
 
+LineRenderer::~LineRenderer() {
+  if (!m_renderer) {
+    return;
+  }
+
+  for (const auto& layer : m_layers) {
+    if (layer.alive) {
+      m_renderer->delete_vertex_buffer(layer.vertexBufferId);
+      m_renderer->delete_vertex_buffer(layer.wideVertexBufferId);
+    }
+  }
+
+  for (const auto& pendingDelete : m_pendingDeletes) {
+    m_renderer->delete_vertex_buffer(pendingDelete.vertexBufferId);
+    m_renderer->delete_vertex_buffer(pendingDelete.wideVertexBufferId);
+  }
+
+  if (m_vertexBufferId.is_valid()) {
+    m_renderer->delete_vertex_buffer(m_vertexBufferId);
+  }
+  if (m_wideVertexBufferId.is_valid()) {
+    m_renderer->delete_vertex_buffer(m_wideVertexBufferId);
+  }
+  if (m_gridVertexBufferId.is_valid()) {
+    m_renderer->delete_vertex_buffer(m_gridVertexBufferId);
+  }
+}
+
 bool LineRenderer::initialize(Renderer* renderer) {
   m_renderer = renderer;
-  m_lines.clear();
+  m_lines = FrameArray<Line>{renderer->frame_allocator()};
 
-  VertexDefinition def;
-  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
-  def.addAttribute(ComponentType::Float32, ComponentCount::Four);
-  m_vertexBufferId = m_renderer->create_vertex_buffer(def, nullptr, 0);
+  m_vertexBufferId = m_renderer->create_vertex_buffer(lineVertexDefinition(), nullptr, 0);
   if (!m_vertexBufferId.is_valid()) {
     LOG(Error) << "Could not create vertex buffer for line renderer.";
     return false;
   }
 
-  m_indexBufferId = m_renderer->create_index_buffer(ComponentType::Unsigned16, nullptr, 0);
-  if (!m_indexBufferId.is_valid()) {
-    LOG(Error) << "Could not create index buffer for line renderer.";
+  if (!initializeWideLines() || !initializeGrids()) {
     return false;
   }
 
@@ -73,25 +263,81 @@ bool LineRenderer::initialize(Renderer* renderer) {
   return true;
 }
 
+bool LineRenderer::initializeWideLines() {
+  m_wideLines = FrameArray<WideLine>{m_renderer->frame_allocator()};
+
+  m_wideVertexBufferId = m_renderer->create_vertex_buffer(wideLineVertexDefinition(), nullptr, 0);
+  if (!m_wideVertexBufferId.is_valid()) {
+    LOG(Error) << "Could not create wide line vertex buffer for line renderer.";
+    return false;
+  }
+
+  m_viewportSizeUniformId = m_renderer->create_uniform("uViewportSize");
+  if (!m_viewportSizeUniformId.is_valid()) {
+    LOG(Error) << "Could not create uViewportSize uniform for line renderer.";
+    return false;
+  }
+
+  auto vertexShaderSource = ShaderSource::from(kWideVertexShaderSource);
+  auto fragmentShaderSource = ShaderSource::from(kWideFragmentShaderSource);
+  m_wideProgramId = m_renderer->create_program(vertexShaderSource, fragmentShaderSource);
+  if (!m_wideProgramId.is_valid()) {
+    LOG(Error) << "Could not create wide line program for line renderer.";
+    return false;
+  }
+
+  return true;
+}
+
+bool LineRenderer::initializeGrids() {
+  m_grids = FrameArray<Grid>{m_renderer->frame_allocator()};
+
+  VertexDefinition def;
+  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
+  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
+  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
+  def.addAttribute(ComponentType::Unsigned8, ComponentCount::Four, true);
+  def.addAttribute(ComponentType::Float32, ComponentCount::One);
+  def.addAttribute(ComponentType::Float32, ComponentCount::One);
+  def.setDivisor(1);
+  m_gridVertexBufferId = m_renderer->create_vertex_buffer(def, nullptr, 0);
+  if (!m_gridVertexBufferId.is_valid()) {
+    LOG(Error) << "Could not create grid vertex buffer for line renderer.";
+    return false;
+  }
+
+  auto vertexShaderSource = ShaderSource::from(kGridVertexShaderSource);
+  auto fragmentShaderSource = ShaderSource::from(kGridFragmentShaderSource);
+  m_gridProgramId = m_renderer->create_program(vertexShaderSource, fragmentShaderSource);
+  if (!m_gridProgramId.is_valid()) {
+    LOG(Error) << "Could not create grid program for line renderer.";
+    return false;
+  }
+
+  return true;
+}
+
 void LineRenderer::beginFrame() {
+  deletePendingLayers();
+
   m_lines.clear();
-  m_lineIndices.clear();
+  m_wideLines.clear();
+  m_grids.clear();
+}
+
+F32 LineRenderer::gridEdgeFade(const fl::Vec2& coord, F32 blocks) {
+  F32 edge = std::max(std::abs(coord.x), std::abs(coord.y)) / blocks;
+  F32 t = std::min(std::max((edge - 0.6f) / 0.4f, 0.0f), 1.0f);
+  return 1.0f - t * t * (3.0f - 2.0f * t);
 }
 
 void LineRenderer::renderLine(const fl::Vec3& p1, const fl::Vec3& p2, const Color& color) {
-#if 0
-  m_lines.constructBack([&p1, &p2, &color](Line* storage) {
-    storage->p1 = p1;
-    storage->color1 = color;
-    storage->p2 = p2;
-    storage->color2 = color;
-  });
-#else
   m_lines.emplaceBack(p1, color, p2, color);
-#endif
+}
 
-  m_lineIndices.pushBack(static_cast<U16>(m_lineIndices.size()));
-  m_lineIndices.pushBack(static_cast<U16>(m_lineIndices.size()));
+void LineRenderer::renderWideLine(const fl::Vec3& p1, const fl::Vec3& p2, const Color& color,
+                                  F32 width) {
+  m_wideLines.emplaceBack(p1, p2, pack_rgba8(color), width);
 }
 
 void LineRenderer::renderGrid(const fl::Plane& plane, const fl::Vec3& worldUp, const Color& color,
@@ -100,41 +346,223 @@ void LineRenderer::renderGrid(const fl::Plane& plane, const fl::Vec3& worldUp, c
   fl::Vec3 right = fl::crossProduct(plane.normal, worldUp);
   fl::Vec3 forward = fl::crossProduct(plane.normal, right);
 
-  //  renderLine(plane.normal * plane.distance, plane.normal * plane.distance + plane.normal *
-  //  100.0f,
-  //             fl::Color::red);
-  //  renderLine(plane.normal * plane.distance, plane.normal * plane.distance + right * 100.0f,
-  //             fl::Color::green);
-  //  renderLine(plane.normal * plane.distance, plane.normal * plane.distance + forward * 100.0f,
-  //             fl::Color::blue);
+  if (numBlocks <= 0 || blockSize <= 0.0f) {
+    return;
+  }
+
+  m_grids.emplaceBack(center, right, forward, pack_rgba8(color),
+                      static_cast<F32>(numBlocks) * blockSize, blockSize);
+}
+
+LineLayerId LineRenderer::createLayer() {
+  MemSize index = 0;
+  for (; index < m_layers.size(); ++index) {
+    if (!m_layers[index].alive) {
+      break;
+    }
+  }
+
+  if (index == m_layers.size()) {
+    m_layers.emplaceBack();
+  }
+
+  Layer& layer = m_layers[index];
+  layer.lines.clear();
+  layer.wideLines.clear();
+  layer.vertexBufferId = m_renderer->create_vertex_buffer(lineVertexDefinition(), nullptr, 0);
+  layer.wideVertexBufferId =
+      m_renderer->create_vertex_buffer(wideLineVertexDefinition(), nullptr, 0);
+  layer.transform = fl::Mat4::identity;
+  layer.alive = true;
+  layer.visible = true;
+  layer.dirty = false;
+
+  return makeLayerId(index, layer.generation);
+}
+
+void LineRenderer::deleteLayer(LineLayerId id) {
+  Layer* l = layer(id);
+  if (!l) {
+    return;
+  }
+
+  // The frame being recorded may already draw the layer, so its buffers have to outlive it.
+  if (m_renderer->is_recording()) {
+    m_pendingDeletes.pushBack(PendingDelete{l->vertexBufferId, l->wideVertexBufferId,
+                                            m_renderer->frame_allocator()->frame()});
+  } else {
+    m_renderer->delete_vertex_buffer(l->vertexBufferId);
+    m_renderer->delete_vertex_buffer(l->wideVertexBufferId);
+  }
+
+  l->lines = {};
+  l->wideLines = {};
+  l->alive = false;
+  ++l->generation;
+}
+
+void LineRenderer::deletePendingLayers() {
+  // Once the renderer started another frame, the one that was recorded has been submitted, and
+  // deleting from the render thread waits for it to execute.
+  U64 frame = m_renderer->frame_allocator()->frame();
+  MemSize kept = 0;
+  for (const auto& pendingDelete : m_pendingDeletes) {
+    if (pendingDelete.frame == frame) {
+      m_pendingDeletes[kept++] = pendingDelete;
+      continue;
+    }
+
+    m_renderer->delete_vertex_buffer(pendingDelete.vertexBufferId);
+    m_renderer->delete_vertex_buffer(pendingDelete.wideVertexBufferId);
+  }
+  m_pendingDeletes.resize(kept);
+}
+
+void LineRenderer::clearLayer(LineLayerId id) {
+  Layer* l = layer(id);
+  if (!l) {
+    return;
+  }
+
+  l->lines.clear();
+  l->wideLines.clear();
+  l->dirty = true;
+}
+
+void LineRenderer::addLine(LineLayerId id, const fl::Vec3& p1, const fl::Vec3& p2,
+                           const Color& color) {
+  Layer* l = layer(id);
+  if (!l) {
+    return;
+  }
+
+  l->lines.pushBack(Line{p1, color, p2, color});
+  l->dirty = true;
+}
+
+void LineRenderer::addWideLine(LineLayerId id, const fl::Vec3& p1, const fl::Vec3& p2,
+                               const Color& color, F32 width) {
+  Layer* l = layer(id);
+  if (!l) {
+    return;
+  }
+
+  l->wideLines.pushBack(WideLine{p1, p2, pack_rgba8(color), width});
+  l->dirty = true;
+}
+
+void LineRenderer::setLayerTransform(LineLayerId id, const fl::Mat4& transform) {
+  Layer* l = layer(id);
+  if (l) {
+    l->transform = transform;
+  }
+}
 
-  F32 max = static_cast<F32>(numBlocks) * blockSize;
+void LineRenderer::setLayerVisible(LineLayerId id, bool visible) {
+  Layer* l = layer(id);
+  if (l) {
+    l->visible = visible;
+  }
+}
 
-  for (I32 x = -numBlocks; x <= numBlocks; ++x) {
-    fl::Vec3 p1 = center + right * static_cast<F32>(x) * blockSize + forward * +max;
-    fl::Vec3 p2 = center + right * static_cast<F32>(x) * blockSize + forward * -max;
-    renderLine(p1, p2, color);
+LineRenderer::Layer* LineRenderer::layer(LineLayerId id) {
+  MemSize index = layerIndex(id);
+  if (!id.is_valid() || index >= m_layers.size() || !m_layers[index].alive ||
+      m_layers[index].generation != layerGeneration(id)) {
+    LOG(Error) << "Invalid line layer.";
+    return nullptr;
   }
 
-  for (I32 y = -numBlocks; y <= numBlocks; ++y) {
-    fl::Vec3 p1 = center + forward * static_cast<F32>(y) * blockSize + right * +max;
-    fl::Vec3 p2 = center + forward * static_cast<F32>(y) * blockSize + right * -max;
-    renderLine(p1, p2, color);
+  return &m_layers[index];
+}
+
+void LineRenderer::uploadLayer(Layer* layer) {
+  m_renderer->vertex_buffer_data(layer->vertexBufferId, layer->lines.data(),
+                                 layer->lines.size() * sizeof(Line));
+  m_renderer->vertex_buffer_data(layer->wideVertexBufferId, layer->wideLines.data(),
+                                 layer->wideLines.size() * sizeof(WideLine));
+  layer->dirty = false;
+}
+
+void LineRenderer::renderLayers(const fl::Mat4& transform) {
+  const auto& size = m_renderer->size();
+  fl::Vec2 viewportSize{static_cast<F32>(size.width), static_cast<F32>(size.height)};
+
+  for (auto& layer : m_layers) {
+    if (!layer.alive || !layer.visible) {
+      continue;
+    }
+
+    if (layer.dirty) {
+      uploadLayer(&layer);
+    }
+
+    UniformBuffer uniformBuffer;
+    uniformBuffer.set(m_transformUniformId, transform * layer.transform);
+
+    if (!layer.lines.empty()) {
+      m_renderer->draw(DrawType::Lines, 0, static_cast<U32>(layer.lines.size() * 2), m_programId,
+                       layer.vertexBufferId, {}, uniformBuffer);
+    }
+
+    if (!layer.wideLines.empty()) {
+      uniformBuffer.set(m_viewportSizeUniformId, viewportSize);
+      m_renderer->draw_instanced(DrawType::TriangleStrip, 4,
+                                 static_cast<U32>(layer.wideLines.size()), m_wideProgramId,
+                                 layer.wideVertexBufferId, {}, uniformBuffer);
+    }
   }
 }
 
 void LineRenderer::render(const fl::Mat4& transform) {
-  // Upload the new scene.
-  m_renderer->vertex_buffer_data(m_vertexBufferId, m_lines.data(), m_lines.size() * sizeof(Line));
+  renderLayers(transform);
 
-  m_renderer->index_buffer_data(m_indexBufferId, m_lineIndices.data(),
-                                m_lineIndices.size() * 2 * sizeof(U16));
+  UniformBuffer uniformBuffer;
+  uniformBuffer.set(m_transformUniformId, transform);
+
+  // Every line is two consecutive vertices, so no index buffer is needed.  Each chunk orphans the
+  // buffer storage, so the driver doesn't wait for the previous draw before the next upload.
+  for (MemSize first = 0; first < m_lines.size(); first += kLinesPerChunk) {
+    MemSize count = std::min(kLinesPerChunk, m_lines.size() - first);
+    m_renderer->stream_vertex_buffer_data(m_vertexBufferId, m_lines.data() + first,
+                                          count * sizeof(Line));
+    m_renderer->draw(DrawType::Lines, 0, static_cast<U32>(count * 2), m_programId,
+                     m_vertexBufferId, {}, uniformBuffer);
+  }
+
+  renderWideLines(transform);
+  renderGrids(transform);
+}
+
+void LineRenderer::renderGrids(const fl::Mat4& transform) {
+  if (m_grids.empty()) {
+    return;
+  }
 
   UniformBuffer uniformBuffer;
   uniformBuffer.set(m_transformUniformId, transform);
 
-  m_renderer->draw(DrawType::Lines, static_cast<U32>(m_lines.size() * 2), m_programId,
-                   m_vertexBufferId, m_indexBufferId, {}, uniformBuffer);
+  m_renderer->stream_vertex_buffer_data(m_gridVertexBufferId, m_grids.data(),
+                                        m_grids.size() * sizeof(Grid));
+  m_renderer->draw_instanced(DrawType::TriangleStrip, 4, static_cast<U32>(m_grids.size()),
+                             m_gridProgramId, m_gridVertexBufferId, {}, uniformBuffer);
+}
+
+void LineRenderer::renderWideLines(const fl::Mat4& transform) {
+  const auto& size = m_renderer->size();
+
+  UniformBuffer uniformBuffer;
+  uniformBuffer.set(m_transformUniformId, transform);
+  uniformBuffer.set(m_viewportSizeUniformId,
+                    fl::Vec2{static_cast<F32>(size.width), static_cast<F32>(size.height)});
+
+  for (MemSize first = 0; first < m_wideLines.size(); first += kLinesPerChunk) {
+    MemSize count = std::min(kLinesPerChunk, m_wideLines.size() - first);
+    m_renderer->stream_vertex_buffer_data(m_wideVertexBufferId, m_wideLines.data() + first,
+                                          count * sizeof(WideLine));
+    m_renderer->draw_instanced(DrawType::TriangleStrip, 4, static_cast<U32>(count),
+                               m_wideProgramId, m_wideVertexBufferId, {}, uniformBuffer);
+  }
 }
 
 }  // namespace ca
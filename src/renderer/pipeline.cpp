@@ -21,6 +21,14 @@ void Pipeline::draw(DrawType draw_type, U32 index_count, VertexBufferId vertex_b
   renderer_->draw(draw_type, index_count, program_id_, vertex_buffer_id, index_buffer_id, textures,
                   uniforms);
 }
+
+void Pipeline::draw_range(DrawType draw_type, U32 index_offset, U32 index_count,
+                          VertexBufferId vertex_buffer_id, IndexBufferId index_buffer_id,
+                          const TextureSlots& textures, const UniformBuffer& uniforms) {
+  renderer_->draw_range(draw_type, index_offset, index_count, program_id_, vertex_buffer_id,
+                        index_buffer_id, textures, uniforms);
+}
+
 Pipeline::Pipeline(Renderer* renderer, VertexDefinition vertex_definition, ProgramId program_id)
   : renderer_{renderer},
     vertex_definition_{std::move(vertex_definition)},
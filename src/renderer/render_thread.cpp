@@ -0,0 +1,138 @@
+#include "canvas/renderer/render_thread.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "nucleus/logging.h"
+
+namespace ca {
+
+RenderThread::RenderThread(ExecuteFunction execute, Task on_start, Task on_stop)
+  : execute_{std::move(execute)}, on_start_{std::move(on_start)}, on_stop_{std::move(on_stop)} {}
+
+RenderThread::~RenderThread() {
+  stop();
+}
+
+void RenderThread::set_latency(U32 latency) {
+  latency_ = std::min(std::max(latency, 1u), kMaxLatency);
+}
+
+void RenderThread::start() {
+  DCHECK(!is_running()) << "Render thread already started.";
+
+  // Held until `thread_` is assigned, so the thread can't ask whether it is current before.
+  std::lock_guard<std::mutex> lock{lock_};
+
+  stopping_ = false;
+  first_submitted_ = 0;
+  submitted_count_ = 0;
+
+  // One packet to record into while the others are waiting.
+  free_count_ = 0;
+  for (U32 i = 0; i <= latency_; ++i) {
+    packets_[i].reset();
+    free_packets_[free_count_++] = &packets_[i];
+  }
+
+  thread_ = std::thread{&RenderThread::thread_main, this};
+}
+
+void RenderThread::stop() {
+  if (!is_running()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{lock_};
+    stopping_ = true;
+  }
+  work_available_.notify_one();
+
+  thread_.join();
+}
+
+FramePacket* RenderThread::acquire_packet() {
+  DCHECK(is_running()) << "Packets can only be acquired while the render thread is running.";
+
+  FramePacket* packet;
+  {
+    std::unique_lock<std::mutex> lock{lock_};
+    work_done_.wait(lock, [this]() { return free_count_ > 0; });
+    packet = free_packets_[--free_count_];
+  }
+
+  packet->reset();
+  return packet;
+}
+
+void RenderThread::submit(FramePacket* packet) {
+  {
+    std::lock_guard<std::mutex> lock{lock_};
+    DCHECK(submitted_count_ < kPacketCount);
+    submitted_[(first_submitted_ + submitted_count_) % kPacketCount] = packet;
+    ++submitted_count_;
+  }
+  work_available_.notify_one();
+}
+
+void RenderThread::run(Task task) {
+  if (!is_running() || is_current()) {
+    task();
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock{lock_};
+  work_done_.wait(lock, [this]() { return task_ == nullptr; });
+  task_ = &task;
+  work_available_.notify_one();
+  work_done_.wait(lock, [this, &task]() { return task_ != &task; });
+}
+
+void RenderThread::thread_main() {
+  { std::lock_guard<std::mutex> lock{lock_}; }
+
+  on_start_();
+
+  for (;;) {
+    FramePacket* packet = nullptr;
+    Task* task = nullptr;
+
+    {
+      std::unique_lock<std::mutex> lock{lock_};
+      work_available_.wait(lock,
+                           [this]() { return submitted_count_ || task_ || stopping_; });
+
+      // Packets go first, so a task runs after everything submitted before it.
+      if (submitted_count_) {
+        packet = submitted_[first_submitted_];
+        first_submitted_ = (first_submitted_ + 1) % kPacketCount;
+        --submitted_count_;
+      } else if (task_) {
+        task = task_;
+      } else {
+        break;
+      }
+    }
+
+    if (packet) {
+      execute_(packet);
+    } else {
+      (*task)();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{lock_};
+      if (packet) {
+        free_packets_[free_count_++] = packet;
+      } else {
+        task_ = nullptr;
+      }
+    }
+    work_done_.notify_all();
+  }
+
+  on_stop_();
+}
+
+}  // namespace ca
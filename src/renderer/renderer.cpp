@@ -1,9 +1,15 @@
 
 #include "canvas/renderer/renderer.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "canvas/opengl.h"
+#include "canvas/renderer/frame_packet.h"
+#include "canvas/renderer/render_thread.h"
 #include "canvas/renderer/vertex_definition.h"
 #include "canvas/utils/gl_check.h"
+#include "canvas/utils/hash.h"
 #include "canvas/utils/shader_source.h"
 #include "nucleus/logging.h"
 
@@ -11,6 +17,11 @@ namespace ca {
 
 namespace {
 
+constexpr U32 kEmptyUniformSlot = ~0u;
+
+// Not a valid GL location (those are >= -1), so it marks locations that were not looked up yet.
+constexpr I32 kUnknownUniformLocation = -2;
+
 U32 getOglType(ComponentType type) {
   switch (type) {
     case ComponentType::Float32:
@@ -40,6 +51,23 @@ U32 getOglType(ComponentType type) {
   }
 }
 
+MemSize index_size_in_bytes(ComponentType type) {
+  switch (type) {
+    case ComponentType::Unsigned8:
+      return sizeof(U8);
+
+    case ComponentType::Unsigned16:
+      return sizeof(U16);
+
+    case ComponentType::Unsigned32:
+      return sizeof(U32);
+
+    default:
+      DCHECK(false) << "Invalid index type.";
+      return 0;
+  }
+}
+
 bool compileShaderSource(const ShaderSource& source, U32 shaderType, U32* idOut) {
   U32 id = glCreateShader(shaderType);
 
@@ -120,6 +148,13 @@ ProgramId Renderer::create_program(const ShaderSource& vertexShader,
 ProgramId Renderer::create_program(const ShaderSource& vertexShader,
                                    const ShaderSource& geometryShader,
                                    const ShaderSource& fragmentShader) {
+  if (needs_render_thread()) {
+    ProgramId result;
+    run_on_render_thread(
+        [&]() { result = create_program(vertexShader, geometryShader, fragmentShader); });
+    return result;
+  }
+
   bool has_geometry_shader_ = !geometryShader.getSource().empty();
 
   ProgramData result;
@@ -186,12 +221,24 @@ ProgramId Renderer::create_program(const ShaderSource& vertexShader,
 }
 
 void Renderer::delete_program(ProgramId programId) {
+  if (needs_render_thread()) {
+    run_on_render_thread([&]() { delete_program(programId); });
+    return;
+  }
+
   auto programData = programs_[programId.id];
   glDeleteProgram(programData.id);
 }
 
 VertexBufferId Renderer::create_vertex_buffer(const VertexDefinition& bufferDefinition,
                                               const void* data, MemSize dataSize) {
+  if (needs_render_thread()) {
+    VertexBufferId result;
+    run_on_render_thread(
+        [&]() { result = create_vertex_buffer(bufferDefinition, data, dataSize); });
+    return result;
+  }
+
   VertexBufferData result;
 
   // Create a vertex array object and bind it.
@@ -210,9 +257,12 @@ VertexBufferId Renderer::create_vertex_buffer(const VertexDefinition& bufferDefi
   U32 offset = 0;
   for (auto& attr : bufferDefinition) {
     glVertexAttribPointer(componentNumber, U32(attr.getCount()), getOglType(attr.getType()),
-                          GL_FALSE, bufferDefinition.getStride(),
+                          attr.isNormalized() ? GL_TRUE : GL_FALSE, bufferDefinition.getStride(),
                           (GLvoid*)(static_cast<MemSize>(offset)));
     glEnableVertexAttribArray(componentNumber);
+    if (bufferDefinition.getDivisor()) {
+      GL_CHECK(glVertexAttribDivisor(componentNumber, bufferDefinition.getDivisor()));
+    }
 
     ++componentNumber;
     offset += attr.getSizeInBytes();
@@ -221,8 +271,9 @@ VertexBufferId Renderer::create_vertex_buffer(const VertexDefinition& bufferDefi
   // Reset the current VAO bind.
   GL_CHECK(glBindVertexArray(0));
 
-  // We can delete the buffer here, because the VAO is holding a reference to it.
-  // GL_CHECK(glDeleteBuffers(1, &bufferId));
+  // Keep the buffer, so its data can be replaced and it can be deleted along with the VAO.
+  result.buffer_id = bufferId;
+  result.capacity = dataSize;
 
 #if 0
   auto pushBackResult =
@@ -234,21 +285,70 @@ VertexBufferId Renderer::create_vertex_buffer(const VertexDefinition& bufferDefi
   return VertexBufferId{pushBackResult.index()};
 }
 
-void Renderer::vertex_buffer_data(VertexBufferId id, void* data, MemSize dataSize) {
-  auto vertexBufferData = vertex_buffers_[id.id];
+void Renderer::vertex_buffer_data(VertexBufferId id, const void* data, MemSize dataSize) {
+  if (recording_) {
+    recording_->record_upload(CommandType::VertexBufferData, id.id, {}, {}, data, dataSize);
+  } else if (needs_render_thread()) {
+    run_on_render_thread([&]() { execute_vertex_buffer_data(id, data, dataSize); });
+  } else {
+    execute_vertex_buffer_data(id, data, dataSize);
+  }
+}
 
-  GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, vertexBufferData.id));
+void Renderer::execute_vertex_buffer_data(VertexBufferId id, const void* data, MemSize dataSize) {
+  auto& vertexBufferData = vertex_buffers_[id.id];
+
+  GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, vertexBufferData.buffer_id));
   GL_CHECK(glBufferData(GL_ARRAY_BUFFER, dataSize, data, GL_STATIC_DRAW));
+  vertexBufferData.capacity = dataSize;
+}
+
+void Renderer::stream_vertex_buffer_data(VertexBufferId id, const void* data, MemSize data_size) {
+  if (recording_) {
+    recording_->record_upload(CommandType::StreamVertexBufferData, id.id, {}, {}, data,
+                              data_size);
+  } else if (needs_render_thread()) {
+    run_on_render_thread([&]() { execute_stream_vertex_buffer_data(id, data, data_size); });
+  } else {
+    execute_stream_vertex_buffer_data(id, data, data_size);
+  }
+}
+
+void Renderer::execute_stream_vertex_buffer_data(VertexBufferId id, const void* data,
+                                                 MemSize data_size) {
+  auto& vertex_buffer_data = vertex_buffers_[id.id];
+
+  GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_data.buffer_id));
+
+  // Orphan the old storage so the driver doesn't wait for draws that still read from it.  Grow
+  // in steps to avoid reallocating every time a frame draws a little more than the last.
+  if (data_size > vertex_buffer_data.capacity) {
+    vertex_buffer_data.capacity = data_size + data_size / 2;
+  }
+  GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.capacity, nullptr, GL_STREAM_DRAW));
+  GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, 0, data_size, data));
 }
 
 void Renderer::delete_vertex_buffer(VertexBufferId id) {
+  if (needs_render_thread()) {
+    run_on_render_thread([&]() { delete_vertex_buffer(id); });
+    return;
+  }
+
   auto data = vertex_buffers_[id.id];
 
   GL_CHECK(glDeleteVertexArrays(1, &data.id));
+  GL_CHECK(glDeleteBuffers(1, &data.buffer_id));
 }
 
 IndexBufferId Renderer::create_index_buffer(ComponentType componentType, const void* data,
                                             MemSize dataSize) {
+  if (needs_render_thread()) {
+    IndexBufferId result;
+    run_on_render_thread([&]() { result = create_index_buffer(componentType, data, dataSize); });
+    return result;
+  }
+
   GLuint bufferId;
   GL_CHECK(glGenBuffers(1, &bufferId));
   GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferId));
@@ -268,6 +368,16 @@ IndexBufferId Renderer::create_index_buffer(ComponentType componentType, const v
 }
 
 void Renderer::index_buffer_data(IndexBufferId id, void* data, MemSize dataSize) {
+  if (recording_) {
+    recording_->record_upload(CommandType::IndexBufferData, id.id, {}, {}, data, dataSize);
+  } else if (needs_render_thread()) {
+    run_on_render_thread([&]() { execute_index_buffer_data(id, data, dataSize); });
+  } else {
+    execute_index_buffer_data(id, data, dataSize);
+  }
+}
+
+void Renderer::execute_index_buffer_data(IndexBufferId id, const void* data, MemSize dataSize) {
   auto indexBufferData = index_buffers_[id.id];
 
   GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferData.id));
@@ -275,6 +385,11 @@ void Renderer::index_buffer_data(IndexBufferId id, void* data, MemSize dataSize)
 }
 
 void Renderer::delete_index_buffer(IndexBufferId id) {
+  if (needs_render_thread()) {
+    run_on_render_thread([&]() { delete_index_buffer(id); });
+    return;
+  }
+
   auto indexBufferData = index_buffers_[id.id];
 
   GL_CHECK(glDeleteBuffers(1, &indexBufferData.id));
@@ -282,6 +397,12 @@ void Renderer::delete_index_buffer(IndexBufferId id) {
 
 TextureId Renderer::create_texture(TextureFormat format, const fl::Size& size, const void* data,
                                    MemSize dataSize, bool smooth) {
+  if (needs_render_thread()) {
+    TextureId result;
+    run_on_render_thread([&]() { result = create_texture(format, size, data, dataSize, smooth); });
+    return result;
+  }
+
   if (format == TextureFormat::Unknown) {
     LOG(Warning) << "Can not create texture from image with unknown format.";
     return {};
@@ -290,8 +411,9 @@ TextureId Renderer::create_texture(TextureFormat format, const fl::Size& size, c
   TextureData result;
 
   result.size = size;
+  result.format = format;
 
-  const GLint internalFormat = GL_RGBA;
+  GLint internalFormat = GL_RGBA;
 
   GLint glFormat = GL_RGBA;
   U32 components;
@@ -309,6 +431,8 @@ TextureId Renderer::create_texture(TextureFormat format, const fl::Size& size, c
       break;
 
     case TextureFormat::Alpha:
+      // Single channel textures only need a byte per texel on the GPU as well.
+      internalFormat = GL_R8;
       glFormat = GL_RED;
       components = 1;
       break;
@@ -319,7 +443,9 @@ TextureId Renderer::create_texture(TextureFormat format, const fl::Size& size, c
       break;
   }
 
-  if (components * size.width * size.height > dataSize) {
+  // Without data the texture is allocated but left undefined, to be filled with
+  // `texture_sub_data`.
+  if (data && components * size.width * size.height > dataSize) {
     LOG(Warning) << "The provided data is not enough to fill the texture rectangle. (size = "
                  << size << ", dataSize = " << dataSize << ")";
     return {};
@@ -330,8 +456,12 @@ TextureId Renderer::create_texture(TextureFormat format, const fl::Size& size, c
   // Bind the texture.
   GL_CHECK(glBindTexture(GL_TEXTURE_2D, result.id));
 
+  // Rows are tightly packed, like in `texture_sub_data`, so single channel images of any width
+  // upload correctly.
+  GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
   GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, result.size.width, result.size.height, 0,
                         glFormat, GL_UNSIGNED_BYTE, data));
+  GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
 
   // Set the texture clamping.
   GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, smooth ? GL_LINEAR : GL_NEAREST));
@@ -347,16 +477,136 @@ TextureId Renderer::create_texture(TextureFormat format, const fl::Size& size, c
     storage->size = result.size;
   });
 #else
-  auto r = textures_.emplaceBack(result.id, result.size);
+  auto r = textures_.emplaceBack(result);
 #endif  // 0
 
   return TextureId{r.index()};
 }
 
-UniformId Renderer::create_uniform(const nu::StringView& name) {
-  UniformData uniformData = {name};
-  uniforms_.pushBack(uniformData);
-  return UniformId{uniforms_.size() - 1};
+void Renderer::texture_sub_data(TextureId id, const fl::Pos& position, const fl::Size& size,
+                                const void* data) {
+  if (!id.is_valid()) {
+    LOG(Warning) << "Updating invalid texture.";
+    return;
+  }
+
+  if (recording_) {
+    MemSize texel_size = textures_[id.id].format == TextureFormat::Alpha ? 1 : 4;
+    recording_->record_upload(CommandType::TextureSubData, id.id, position, size, data,
+                              texel_size * size.width * size.height);
+  } else if (needs_render_thread()) {
+    run_on_render_thread([&]() { execute_texture_sub_data(id, position, size, data); });
+  } else {
+    execute_texture_sub_data(id, position, size, data);
+  }
+}
+
+void Renderer::execute_texture_sub_data(TextureId id, const fl::Pos& position,
+                                        const fl::Size& size, const void* data) {
+  auto& textureData = textures_[id.id];
+  GLenum glFormat = textureData.format == TextureFormat::Alpha ? GL_RED : GL_RGBA;
+
+  // Rows of a sub image are tightly packed, whatever their width.
+  GL_CHECK(glBindTexture(GL_TEXTURE_2D, textureData.id));
+  GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, position.x, position.y, size.width, size.height,
+                           glFormat, GL_UNSIGNED_BYTE, data));
+  GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+  GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+void Renderer::delete_texture(TextureId id) {
+  if (!id.is_valid()) {
+    return;
+  }
+
+  if (needs_render_thread()) {
+    run_on_render_thread([&]() { delete_texture(id); });
+    return;
+  }
+
+  auto& textureData = textures_[id.id];
+  if (textureData.id) {
+    GL_CHECK(glDeleteTextures(1, &textureData.id));
+    textureData.id = 0;
+  }
+}
+
+UniformId Renderer::create_uniform(const nu::StringView& full_name) {
+  // Hash and compare the name as it is stored, or a long name would never match its own entry.
+  nu::StringView name{full_name.data(), std::min(full_name.length(), kMaxUniformNameLength)};
+  if (name.length() < full_name.length()) {
+    LOG(Warning) << "Uniform name is too long: " << full_name;
+  }
+  U64 hash = hash_mix(hash_bytes(name.data(), name.length()));
+
+  std::lock_guard<std::mutex> lock{uniforms_lock_};
+
+  if (uniforms_.size() * 2 >= uniform_table_.size()) {
+    grow_uniform_table();
+  }
+
+  MemSize mask = uniform_table_.size() - 1;
+  for (MemSize slot = hash & mask;; slot = (slot + 1) & mask) {
+    U32 index = uniform_table_[slot];
+    if (index == kEmptyUniformSlot) {
+      uniform_table_[slot] = static_cast<U32>(uniforms_.size());
+      uniforms_.pushBack(UniformData{name, hash});
+      return UniformId{uniforms_.size() - 1};
+    }
+
+    const auto& uniform_data = uniforms_[index];
+    if (uniform_data.hash == hash && uniform_data.name.length() == name.length() &&
+        std::memcmp(uniform_data.name.data(), name.data(), name.length()) == 0) {
+      return UniformId{index};
+    }
+  }
+}
+
+void Renderer::grow_uniform_table() {
+  MemSize size = uniform_table_.empty() ? 64 : uniform_table_.size() * 2;
+  uniform_table_.resize(size);
+  std::fill(uniform_table_.begin(), uniform_table_.end(), kEmptyUniformSlot);
+
+  MemSize mask = size - 1;
+  for (U32 index = 0; index < uniforms_.size(); ++index) {
+    MemSize slot = uniforms_[index].hash & mask;
+    while (uniform_table_[slot] != kEmptyUniformSlot) {
+      slot = (slot + 1) & mask;
+    }
+    uniform_table_[slot] = index;
+  }
+}
+
+I32 Renderer::uniform_location(ProgramData* program_data, UniformId uniform_id) {
+  auto& locations = program_data->uniform_locations;
+  if (uniform_id.id < locations.size() && locations[uniform_id.id] != kUnknownUniformLocation) {
+    return locations[uniform_id.id];
+  }
+
+  char buf[sizeof(UniformData::name) + 1];
+  {
+    std::lock_guard<std::mutex> lock{uniforms_lock_};
+
+    if (uniform_id.id >= locations.size()) {
+      MemSize old_size = locations.size();
+      locations.resize(uniforms_.size());
+      std::fill(locations.begin() + old_size, locations.end(), kUnknownUniformLocation);
+    }
+
+    const auto& uniform_data = uniforms_[uniform_id.id];
+    std::memcpy(buf, uniform_data.name.data(), uniform_data.name.length());
+    buf[uniform_data.name.length()] = '\0';
+  }
+
+  I32 location = glGetUniformLocation(program_data->id, buf);
+  if (location == -1) {
+    LOG(Warning) << "Could not get location for uniform: " << buf;
+  }
+
+  // Missing uniforms are cached too, so the warning is only logged once per program.
+  locations[uniform_id.id] = location;
+  return location;
 }
 
 PipelineBuilder Renderer::create_pipeline_builder() const {
@@ -364,76 +614,391 @@ PipelineBuilder Renderer::create_pipeline_builder() const {
 }
 
 void Renderer::resize(const fl::Size& size) {
+  if (needs_render_thread()) {
+    run_on_render_thread([&]() { resize(size); });
+    return;
+  }
+
   size_ = size;
   GL_CHECK(glViewport(0, 0, size.width, size.height));
 }
 
+void Renderer::set_retain_frames(bool retain) {
+  if (needs_render_thread()) {
+    run_on_render_thread([&]() { set_retain_frames(retain); });
+    return;
+  }
+
+  retain_frames_ = retain;
+  if (!retain_frames_) {
+    delete_retained_frame_buffer();
+  }
+}
+
+void Renderer::release_resources() {
+  if (needs_render_thread()) {
+    run_on_render_thread([&]() { release_resources(); });
+    return;
+  }
+
+  set_retain_frames(false);
+  gpu_profiler_.delete_queries();
+}
+
+void Renderer::begin_recording(FramePacket* packet) {
+  DCHECK(!recording_) << "Already recording a frame.";
+  recording_ = packet;
+}
+
+void Renderer::end_recording() {
+  recording_ = nullptr;
+}
+
+void Renderer::execute(const FramePacket& packet) {
+  for (const Command& command : packet.commands()) {
+    switch (command.type) {
+      case CommandType::BeginFrame: {
+        if (gpu_profiler_.is_enabled() != packet.gpu_profiling()) {
+          gpu_profiler_.set_enabled(packet.gpu_profiling());
+        }
+        const auto& begin_frame = packet.begin_frame(command.index);
+        execute_begin_frame(begin_frame.damage_position, begin_frame.damage_size);
+        break;
+      }
+
+      case CommandType::EndFrame:
+        execute_end_frame();
+        break;
+
+      case CommandType::Clear:
+        execute_clear(packet.clear_color(command.index));
+        break;
+
+      case CommandType::Draw:
+      case CommandType::DrawIndexed:
+      case CommandType::DrawInstanced: {
+        const DrawCommand& draw = packet.draw(command.index);
+        ProgramData* program_data = pre_draw(draw.program_id, draw.textures, draw.state);
+        if (program_data) {
+          for (U32 i = 0; i < draw.uniform_count; ++i) {
+            const RecordedUniform& uniform = packet.uniform(draw.first_uniform + i);
+            apply_uniform(program_data, uniform.uniform_id, uniform.type, uniform.count,
+                          uniform.data);
+          }
+        }
+        execute_draw(command.type, draw);
+        break;
+      }
+
+      case CommandType::VertexBufferData: {
+        const UploadCommand& upload = packet.upload(command.index);
+        execute_vertex_buffer_data(VertexBufferId{upload.resource_id}, packet.data(upload.data),
+                                   upload.data.size);
+        break;
+      }
+
+      case CommandType::StreamVertexBufferData: {
+        const UploadCommand& upload = packet.upload(command.index);
+        execute_stream_vertex_buffer_data(VertexBufferId{upload.resource_id},
+                                          packet.data(upload.data), upload.data.size);
+        break;
+      }
+
+      case CommandType::IndexBufferData: {
+        const UploadCommand& upload = packet.upload(command.index);
+        execute_index_buffer_data(IndexBufferId{upload.resource_id}, packet.data(upload.data),
+                                  upload.data.size);
+        break;
+      }
+
+      case CommandType::TextureSubData: {
+        const UploadCommand& upload = packet.upload(command.index);
+        execute_texture_sub_data(TextureId{upload.resource_id}, upload.position, upload.size,
+                                 packet.data(upload.data));
+        break;
+      }
+
+      case CommandType::BeginGpuScope:
+        gpu_profiler_.begin_scope(packet.gpu_scope_name(command.index));
+        break;
+
+      case CommandType::EndGpuScope:
+        gpu_profiler_.end_scope();
+        break;
+    }
+  }
+}
+
+void Renderer::set_render_thread(RenderThread* render_thread) {
+  render_thread_ = render_thread;
+}
+
+void Renderer::begin_gpu_scope(nu::StringView name) {
+  if (recording_) {
+    if (recording_->gpu_profiling()) {
+      recording_->record_begin_gpu_scope(name);
+    }
+  } else {
+    gpu_profiler_.begin_scope(name);
+  }
+}
+
+void Renderer::end_gpu_scope() {
+  if (recording_) {
+    if (recording_->gpu_profiling()) {
+      recording_->record_end_gpu_scope();
+    }
+  } else {
+    gpu_profiler_.end_scope();
+  }
+}
+
 void Renderer::begin_frame() {
-  glClearColor(0.1f, 0.2f, 0.3f, 1.0f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  begin_frame({0, 0}, size_);
 }
 
-void Renderer::end_frame() {}
+void Renderer::begin_frame(const fl::Pos& damage_position, const fl::Size& damage_size) {
+  frame_allocator_.reset();
+
+  if (recording_) {
+    recording_->record_begin_frame(damage_position, damage_size);
+  } else {
+    execute_begin_frame(damage_position, damage_size);
+  }
+}
+
+void Renderer::end_frame() {
+  if (recording_) {
+    recording_->record_end_frame();
+  } else {
+    execute_end_frame();
+  }
+}
 
 void Renderer::clear(const Color& color) {
-  GL_CHECK(glClearColor(color.r, color.g, color.b, color.a));
-  GL_CHECK(glClear(GL_COLOR_BUFFER_BIT));
+  if (recording_) {
+    recording_->record_clear(color);
+  } else {
+    execute_clear(color);
+  }
 }
 
 void Renderer::draw(DrawType draw_type, U32 vertex_offset, U32 vertex_count, ProgramId program_id,
                     VertexBufferId vertex_buffer_id, const TextureSlots& textures,
                     const UniformBuffer& uniforms) {
-  pre_draw(program_id, textures, uniforms);
+  submit_draw(CommandType::Draw,
+              DrawCommand{draw_type, vertex_offset, vertex_count, 0, program_id,
+                          vertex_buffer_id, {}, textures, render_state_, 0, 0},
+              uniforms);
+}
 
-  if (!vertex_buffer_id.is_valid()) {
-    LOG(Error) << "Draw command without vertex buffer.";
+void Renderer::draw_instanced(DrawType draw_type, U32 vertex_count, U32 instance_count,
+                              ProgramId program_id, VertexBufferId vertex_buffer_id,
+                              const TextureSlots& textures, const UniformBuffer& uniforms) {
+  submit_draw(CommandType::DrawInstanced,
+              DrawCommand{draw_type, 0, vertex_count, instance_count, program_id,
+                          vertex_buffer_id, {}, textures, render_state_, 0, 0},
+              uniforms);
+}
+
+void Renderer::draw(DrawType draw_type, U32 index_count, ProgramId program_id,
+                    VertexBufferId vertex_buffer_id, IndexBufferId index_buffer_id,
+                    const TextureSlots& textures, const UniformBuffer& uniforms) {
+  draw_range(draw_type, 0, index_count, program_id, vertex_buffer_id, index_buffer_id, textures,
+             uniforms);
+}
+
+void Renderer::draw_range(DrawType draw_type, U32 index_offset, U32 index_count,
+                          ProgramId program_id, VertexBufferId vertex_buffer_id,
+                          IndexBufferId index_buffer_id, const TextureSlots& textures,
+                          const UniformBuffer& uniforms) {
+  submit_draw(CommandType::DrawIndexed,
+              DrawCommand{draw_type, index_offset, index_count, 0, program_id, vertex_buffer_id,
+                          index_buffer_id, textures, render_state_, 0, 0},
+              uniforms);
+}
+
+void Renderer::submit_draw(CommandType type, const DrawCommand& draw,
+                           const UniformBuffer& uniforms) {
+  if (recording_) {
+    recording_->record_draw(type, draw, uniforms);
     return;
   }
 
-  auto& vertexBufferData = vertex_buffers_[vertex_buffer_id.id];
-  GL_CHECK(glBindVertexArray(vertexBufferData.id));
+  if (needs_render_thread()) {
+    run_on_render_thread([&]() { submit_draw(type, draw, uniforms); });
+    return;
+  }
 
-  auto mode = mode_from_draw_type(draw_type);
-  GL_CHECK(glDrawArrays(mode, vertex_offset, vertex_count));
+  ProgramData* program_data = pre_draw(draw.program_id, draw.textures, draw.state);
+  if (program_data) {
+    uniforms.apply([&](UniformId uniform_id, ComponentType component_type, U32 count,
+                       const void* values) {
+      apply_uniform(program_data, uniform_id, component_type, count, values);
+    });
+  }
 
-  post_draw();
+  execute_draw(type, draw);
 }
 
-void Renderer::draw(DrawType draw_type, U32 index_count, ProgramId program_id,
-                    VertexBufferId vertex_buffer_id, IndexBufferId index_buffer_id,
-                    const TextureSlots& textures, const UniformBuffer& uniforms) {
-  pre_draw(program_id, textures, uniforms);
+bool Renderer::needs_render_thread() const {
+  return render_thread_ && !render_thread_->is_current();
+}
+
+void Renderer::run_on_render_thread(nu::Function<void()> task) {
+  render_thread_->run(std::move(task));
+}
+
+void Renderer::execute_begin_frame(const fl::Pos& damage_position, const fl::Size& damage_size) {
+  gpu_profiler_.begin_frame();
+
+  if (retain_frames_) {
+    bool has_contents = update_retained_frame_buffer();
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_));
+
+    // A new buffer has nothing in it to keep, so all of it is drawn.
+    if (has_contents) {
+      // Scissor rectangles start at the bottom left.
+      GL_CHECK(glEnable(GL_SCISSOR_TEST));
+      GL_CHECK(glScissor(damage_position.x,
+                         size_.height - damage_position.y - damage_size.height,
+                         damage_size.width, damage_size.height));
+    }
+  }
+
+  glClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void Renderer::execute_end_frame() {
+  gpu_profiler_.end_frame();
+
+  if (retain_frames_ && frame_buffer_) {
+    GL_CHECK(glDisable(GL_SCISSOR_TEST));
 
-  if (!vertex_buffer_id.is_valid()) {
+    // The window's back buffer is undefined after a swap, so all of it is copied.  The copy costs
+    // far less than drawing the frame again.
+    GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, frame_buffer_));
+    GL_CHECK(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+    GL_CHECK(glBlitFramebuffer(0, 0, size_.width, size_.height, 0, 0, size_.width, size_.height,
+                               GL_COLOR_BUFFER_BIT, GL_NEAREST));
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+  }
+}
+
+bool Renderer::update_retained_frame_buffer() {
+  if (frame_buffer_ && frame_buffer_size_.width == size_.width &&
+      frame_buffer_size_.height == size_.height) {
+    return true;
+  }
+
+  delete_retained_frame_buffer();
+
+  GL_CHECK(glGenRenderbuffers(1, &color_render_buffer_));
+  GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, color_render_buffer_));
+  GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size_.width, size_.height));
+
+  GL_CHECK(glGenRenderbuffers(1, &depth_render_buffer_));
+  GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, depth_render_buffer_));
+  GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size_.width, size_.height));
+  GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+  GL_CHECK(glGenFramebuffers(1, &frame_buffer_));
+  GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_));
+  GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                     color_render_buffer_));
+  GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                                     depth_render_buffer_));
+
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    LOG(Error) << "Could not create frame buffer to retain frames in (status " << status
+               << "), drawing every frame in full.";
+    delete_retained_frame_buffer();
+    retain_frames_ = false;
+    return false;
+  }
+
+  frame_buffer_size_ = size_;
+  return false;
+}
+
+void Renderer::delete_retained_frame_buffer() {
+  if (frame_buffer_) {
+    GL_CHECK(glDeleteFramebuffers(1, &frame_buffer_));
+    frame_buffer_ = 0;
+  }
+
+  if (color_render_buffer_) {
+    GL_CHECK(glDeleteRenderbuffers(1, &color_render_buffer_));
+    color_render_buffer_ = 0;
+  }
+
+  if (depth_render_buffer_) {
+    GL_CHECK(glDeleteRenderbuffers(1, &depth_render_buffer_));
+    depth_render_buffer_ = 0;
+  }
+
+  frame_buffer_size_ = {};
+}
+
+void Renderer::execute_clear(const Color& color) {
+  GL_CHECK(glClearColor(color.r, color.g, color.b, color.a));
+  GL_CHECK(glClear(GL_COLOR_BUFFER_BIT));
+}
+
+void Renderer::execute_draw(CommandType type, const DrawCommand& draw) {
+  if (!draw.vertex_buffer_id.is_valid()) {
     LOG(Error) << "Draw command without vertex buffer.";
     return;
   }
 
-  if (!index_buffer_id.is_valid()) {
+  if (type == CommandType::DrawIndexed && !draw.index_buffer_id.is_valid()) {
     LOG(Error) << "Draw command without index buffer.";
     return;
   }
 
-  auto& vertexBufferData = vertex_buffers_[vertex_buffer_id.id];
+  auto& vertexBufferData = vertex_buffers_[draw.vertex_buffer_id.id];
   GL_CHECK(glBindVertexArray(vertexBufferData.id));
 
-  auto& indexBufferData = index_buffers_[index_buffer_id.id];
-  GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferData.id));
+  auto mode = mode_from_draw_type(draw.draw_type);
 
-  U32 oglType = getOglType(indexBufferData.component_type);
+  switch (type) {
+    case CommandType::Draw:
+      GL_CHECK(glDrawArrays(mode, draw.first, draw.count));
+      break;
+
+    case CommandType::DrawInstanced:
+      GL_CHECK(glDrawArraysInstanced(mode, draw.first, draw.count, draw.instance_count));
+      break;
 
-  U32 mode = mode_from_draw_type(draw_type);
+    case CommandType::DrawIndexed: {
+      auto& indexBufferData = index_buffers_[draw.index_buffer_id.id];
+      GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferData.id));
 
-  GL_CHECK(glDrawElements(mode, index_count, oglType, nullptr));
+      U32 oglType = getOglType(indexBufferData.component_type);
 
-  post_draw();
+      auto* first_index = reinterpret_cast<const GLvoid*>(
+          static_cast<MemSize>(draw.first) * index_size_in_bytes(indexBufferData.component_type));
+
+      GL_CHECK(glDrawElements(mode, draw.count, oglType, first_index));
+      break;
+    }
+
+    default:
+      DCHECK(false) << "Not a draw command.";
+      break;
+  }
+
+  post_draw(draw.state);
 }
 
-void Renderer::pre_draw(ProgramId program_id, const TextureSlots& textures,
-                        const UniformBuffer& uniforms) {
+Renderer::ProgramData* Renderer::pre_draw(ProgramId program_id, const TextureSlots& textures,
+                                          const RenderState& state) {
   if (!program_id.is_valid()) {
     LOG(Error) << "Draw command without program.";
-    return;
+    return nullptr;
   }
 
   auto& programData = programs_[program_id.id];
@@ -445,68 +1010,65 @@ void Renderer::pre_draw(ProgramId program_id, const TextureSlots& textures,
     GL_CHECK(glBindTexture(GL_TEXTURE_2D, textureData.id));
   });
 
-  // Process uniforms.
-  uniforms.apply([&](UniformId uniformId, ComponentType type, U32 count, const void* values) {
-    const auto& uniformData = uniforms_[uniformId.id];
-    char buf[64];
-    std::strncpy(buf, uniformData.name.data(), uniformData.name.length());
-    buf[uniformData.name.length()] = '\0';
-    I32 location = glGetUniformLocation(programData.id, buf);
-    if (location == -1) {
-      LOG(Warning) << "Could not get location for uniform: " << buf;
-      return;
-    }
+  if (state.depth_test()) {
+    GL_CHECK(glEnable(GL_DEPTH_TEST));
+  }
 
-    if (type == ComponentType::Float32) {
-      switch (count) {
-        case 1:
-          GL_CHECK(glUniform1fv(location, 1, (GLfloat*)values));
-          break;
+  if (state.cull_face()) {
+    GL_CHECK(glEnable(GL_CULL_FACE));
+  }
 
-        case 2:
-          GL_CHECK(glUniform2fv(location, 1, (GLfloat*)values));
-          break;
+  GL_CHECK(glEnable(GL_BLEND));
+  GL_CHECK(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
-        case 3:
-          GL_CHECK(glUniform3fv(location, 1, (GLfloat*)values));
-          break;
+  return &programData;
+}
 
-        case 4:
-          GL_CHECK(glUniform4fv(location, 1, (GLfloat*)values));
-          break;
+void Renderer::apply_uniform(ProgramData* program_data, UniformId uniform_id, ComponentType type,
+                             U32 count, const void* values) {
+  I32 location = uniform_location(program_data, uniform_id);
+  if (location == -1) {
+    return;
+  }
 
-        case 16:
-          GL_CHECK(glUniformMatrix4fv(location, 1, GL_FALSE, (GLfloat*)values));
-          break;
+  if (type == ComponentType::Float32) {
+    switch (count) {
+      case 1:
+        GL_CHECK(glUniform1fv(location, 1, (GLfloat*)values));
+        break;
 
-        default:
-          DCHECK(false) << "Invalid uniform size.";
-          break;
-      }
-    } else if (type == ComponentType::Signed32) {
-      DCHECK(count == 1);
-      GL_CHECK(glUniform1i(location, *(GLint*)values));
-    } else if (type == ComponentType::Unsigned32) {
-      DCHECK(count == 1);
-      GL_CHECK(glUniform1ui(location, *(GLuint*)values));
-    } else {
-      DCHECK(false) << "Unsupported uniform component type.";
-    }
-  });
+      case 2:
+        GL_CHECK(glUniform2fv(location, 1, (GLfloat*)values));
+        break;
 
-  if (render_state_.depth_test()) {
-    GL_CHECK(glEnable(GL_DEPTH_TEST));
-  }
+      case 3:
+        GL_CHECK(glUniform3fv(location, 1, (GLfloat*)values));
+        break;
 
-  if (render_state_.cull_face()) {
-    GL_CHECK(glEnable(GL_CULL_FACE));
-  }
+      case 4:
+        GL_CHECK(glUniform4fv(location, 1, (GLfloat*)values));
+        break;
 
-  GL_CHECK(glEnable(GL_BLEND));
-  GL_CHECK(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+      case 16:
+        GL_CHECK(glUniformMatrix4fv(location, 1, GL_FALSE, (GLfloat*)values));
+        break;
+
+      default:
+        DCHECK(false) << "Invalid uniform size.";
+        break;
+    }
+  } else if (type == ComponentType::Signed32) {
+    DCHECK(count == 1);
+    GL_CHECK(glUniform1i(location, *(GLint*)values));
+  } else if (type == ComponentType::Unsigned32) {
+    DCHECK(count == 1);
+    GL_CHECK(glUniform1ui(location, *(GLuint*)values));
+  } else {
+    DCHECK(false) << "Unsupported uniform component type.";
+  }
 }
 
-void Renderer::post_draw() {
+void Renderer::post_draw(const RenderState& state) {
   for (U32 i = 0; i < TextureSlots::MAX_TEXTURE_SLOTS; ++i) {
     GL_CHECK(glActiveTexture(GL_TEXTURE0 + i));
     GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
@@ -514,11 +1076,11 @@ void Renderer::post_draw() {
 
   GL_CHECK(glDisable(GL_BLEND));
 
-  if (render_state_.cull_face()) {
+  if (state.cull_face()) {
     GL_CHECK(glDisable(GL_CULL_FACE));
   }
 
-  if (render_state_.depth_test()) {
+  if (state.depth_test()) {
     GL_CHECK(glDisable(GL_DEPTH_TEST));
   }
 }
@@ -36,8 +36,8 @@ auto getComponentTypeSizeInBytes(ComponentType type) -> U32 {
 
 }  // namespace
 
-VertexAttribute::VertexAttribute(ComponentType type, ComponentCount count)
-  : m_type{type}, m_count{count} {
+VertexAttribute::VertexAttribute(ComponentType type, ComponentCount count, bool normalized)
+  : m_type{type}, m_count{count}, m_normalized{normalized} {
   m_sizeInBytes = getComponentTypeSizeInBytes(type) * U32(count);
 }
 
@@ -0,0 +1,492 @@
+#include "canvas/scene/bvh.h"
+
+#include <limits>
+
+#include "nucleus/logging.h"
+
+namespace ca {
+
+namespace {
+
+constexpr U32 kInvalidNode = ~0u;
+constexpr U32 kBinCount = 12;
+constexpr U32 kMaxLeafObjects = 8;
+constexpr U32 kMaxDepth = 48;
+constexpr U32 kStackSize = 64;
+
+// Cost of visiting a node relative to testing an object.
+constexpr F32 kTraversalCost = 1.0f;
+
+Aabb empty_aabb() {
+  constexpr F32 kInfinity = std::numeric_limits<F32>::infinity();
+  return Aabb{fl::Vec3{kInfinity, kInfinity, kInfinity},
+              fl::Vec3{-kInfinity, -kInfinity, -kInfinity}};
+}
+
+void grow(Aabb* aabb, const Aabb& other) {
+  aabb->min.x = other.min.x < aabb->min.x ? other.min.x : aabb->min.x;
+  aabb->min.y = other.min.y < aabb->min.y ? other.min.y : aabb->min.y;
+  aabb->min.z = other.min.z < aabb->min.z ? other.min.z : aabb->min.z;
+  aabb->max.x = other.max.x > aabb->max.x ? other.max.x : aabb->max.x;
+  aabb->max.y = other.max.y > aabb->max.y ? other.max.y : aabb->max.y;
+  aabb->max.z = other.max.z > aabb->max.z ? other.max.z : aabb->max.z;
+}
+
+void grow(Aabb* aabb, const fl::Vec3& point) {
+  grow(aabb, Aabb{point, point});
+}
+
+// Half the surface area, which is all SAH needs.
+F32 surface_area(const Aabb& aabb) {
+  F32 x = aabb.max.x - aabb.min.x;
+  F32 y = aabb.max.y - aabb.min.y;
+  F32 z = aabb.max.z - aabb.min.z;
+  if (x < 0.0f || y < 0.0f || z < 0.0f) {
+    return 0.0f;
+  }
+  return x * y + y * z + z * x;
+}
+
+bool same_bounds(const Aabb& a, const Aabb& b) {
+  return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z && a.max.x == b.max.x &&
+         a.max.y == b.max.y && a.max.z == b.max.z;
+}
+
+bool overlaps(const Aabb& a, const Aabb& b) {
+  return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y &&
+         a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+F32 component(const fl::Vec3& v, U32 axis) {
+  return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+enum class Containment {
+  Outside,
+  Intersecting,
+  Inside,
+};
+
+Containment classify(const Frustum& frustum, const Aabb& aabb) {
+  Containment result = Containment::Inside;
+  for (const auto& plane : frustum.planes) {
+    const fl::Vec3& n = plane.normal;
+    F32 px = n.x >= 0.0f ? aabb.max.x : aabb.min.x;
+    F32 py = n.y >= 0.0f ? aabb.max.y : aabb.min.y;
+    F32 pz = n.z >= 0.0f ? aabb.max.z : aabb.min.z;
+    if (n.x * px + n.y * py + n.z * pz < plane.distance) {
+      return Containment::Outside;
+    }
+
+    F32 nx = n.x >= 0.0f ? aabb.min.x : aabb.max.x;
+    F32 ny = n.y >= 0.0f ? aabb.min.y : aabb.max.y;
+    F32 nz = n.z >= 0.0f ? aabb.min.z : aabb.max.z;
+    if (n.x * nx + n.y * ny + n.z * nz < plane.distance) {
+      result = Containment::Intersecting;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+Bvh::Bvh() = default;
+
+BvhHandle Bvh::insert(const Aabb& bounds, U32 user_data) {
+  BvhHandle handle;
+  if (!free_handles_.empty()) {
+    handle = free_handles_[free_handles_.size() - 1];
+    free_handles_.resize(free_handles_.size() - 1);
+  } else {
+    handle = static_cast<BvhHandle>(objects_.size());
+    objects_.pushBack({});
+  }
+
+  objects_[handle] = Object{bounds, user_data, kInvalidNode, true};
+  ++object_count_;
+  needs_rebuild_ = true;
+
+  return handle;
+}
+
+void Bvh::update(BvhHandle handle, const Aabb& bounds) {
+  DCHECK(handle < objects_.size() && objects_[handle].alive) << "Invalid BVH handle";
+
+  Object& object = objects_[handle];
+  object.bounds = bounds;
+  if (object.leaf != kInvalidNode) {
+    dirty_leaves_.pushBack(object.leaf);
+    ++updates_since_build_;
+  }
+}
+
+void Bvh::remove(BvhHandle handle) {
+  DCHECK(handle < objects_.size() && objects_[handle].alive) << "Invalid BVH handle";
+
+  // The object stays in its leaf until the next rebuild, so the handle can't be reused before.
+  Object& object = objects_[handle];
+  object.alive = false;
+  if (object.leaf != kInvalidNode) {
+    dirty_leaves_.pushBack(object.leaf);
+    ++updates_since_build_;
+  }
+  removed_handles_.pushBack(handle);
+  --object_count_;
+}
+
+const Aabb& Bvh::bounds(BvhHandle handle) const {
+  DCHECK(handle < objects_.size()) << "Invalid BVH handle";
+  return objects_[handle].bounds;
+}
+
+U32 Bvh::user_data(BvhHandle handle) const {
+  DCHECK(handle < objects_.size()) << "Invalid BVH handle";
+  return objects_[handle].user_data;
+}
+
+void Bvh::refit() {
+  if (needs_rebuild_ || updates_since_build_ > object_count_) {
+    rebuild();
+    return;
+  }
+
+  for (U32 leaf : dirty_leaves_) {
+    refit_leaf(leaf);
+  }
+  dirty_leaves_.clear();
+}
+
+void Bvh::rebuild() {
+  for (BvhHandle handle : removed_handles_) {
+    free_handles_.pushBack(handle);
+  }
+  removed_handles_.clear();
+
+  nodes_.clear();
+  node_objects_.clear();
+  dirty_leaves_.clear();
+  needs_rebuild_ = false;
+  updates_since_build_ = 0;
+
+  centroids_.resize(objects_.size());
+  for (U32 i = 0; i < objects_.size(); ++i) {
+    Object& object = objects_[i];
+    object.leaf = kInvalidNode;
+    if (!object.alive) {
+      continue;
+    }
+
+    node_objects_.pushBack(i);
+    centroids_[i] = fl::Vec3{(object.bounds.min.x + object.bounds.max.x) * 0.5f,
+                             (object.bounds.min.y + object.bounds.max.y) * 0.5f,
+                             (object.bounds.min.z + object.bounds.max.z) * 0.5f};
+  }
+
+  if (node_objects_.empty()) {
+    return;
+  }
+
+  nodes_.pushBack(Node{empty_aabb(), kInvalidNode, 0, 0, static_cast<U32>(node_objects_.size())});
+  build_node(0, 0);
+}
+
+void Bvh::build_node(U32 node_index, U32 depth) {
+  U32 first = nodes_[node_index].first;
+  U32 count = nodes_[node_index].count;
+
+  Aabb bounds = empty_aabb();
+  Aabb centroid_bounds = empty_aabb();
+  for (U32 i = first; i < first + count; ++i) {
+    U32 object = node_objects_[i];
+    grow(&bounds, objects_[object].bounds);
+    grow(&centroid_bounds, centroids_[object]);
+  }
+  nodes_[node_index].bounds = bounds;
+
+  auto make_leaf = [&]() {
+    for (U32 i = first; i < first + count; ++i) {
+      objects_[node_objects_[i]].leaf = node_index;
+    }
+  };
+
+  if (count <= 2 || depth >= kMaxDepth) {
+    make_leaf();
+    return;
+  }
+
+  // Find the cheapest split between bins of object centroids on any axis.
+  F32 best_cost = std::numeric_limits<F32>::max();
+  U32 best_axis = 0;
+  U32 best_split = 0;
+
+  for (U32 axis = 0; axis < 3; ++axis) {
+    F32 minimum = component(centroid_bounds.min, axis);
+    F32 extent = component(centroid_bounds.max, axis) - minimum;
+    if (extent <= 0.0f) {
+      continue;
+    }
+    F32 scale = static_cast<F32>(kBinCount) / extent;
+
+    Aabb bin_bounds[kBinCount];
+    U32 bin_counts[kBinCount] = {};
+    for (U32 bin = 0; bin < kBinCount; ++bin) {
+      bin_bounds[bin] = empty_aabb();
+    }
+
+    for (U32 i = first; i < first + count; ++i) {
+      U32 object = node_objects_[i];
+      U32 bin = static_cast<U32>((component(centroids_[object], axis) - minimum) * scale);
+      bin = bin < kBinCount ? bin : kBinCount - 1;
+      grow(&bin_bounds[bin], objects_[object].bounds);
+      ++bin_counts[bin];
+    }
+
+    // Sweep from the right to get the cost of everything above each split.
+    F32 right_costs[kBinCount];
+    Aabb right_bounds = empty_aabb();
+    U32 right_count = 0;
+    for (U32 bin = kBinCount - 1; bin > 0; --bin) {
+      grow(&right_bounds, bin_bounds[bin]);
+      right_count += bin_counts[bin];
+      right_costs[bin] = surface_area(right_bounds) * static_cast<F32>(right_count);
+    }
+
+    Aabb left_bounds = empty_aabb();
+    U32 left_count = 0;
+    for (U32 split = 1; split < kBinCount; ++split) {
+      grow(&left_bounds, bin_bounds[split - 1]);
+      left_count += bin_counts[split - 1];
+      if (left_count == 0 || left_count == count) {
+        continue;
+      }
+
+      F32 cost = surface_area(left_bounds) * static_cast<F32>(left_count) + right_costs[split];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_split = split;
+      }
+    }
+  }
+
+  F32 area = surface_area(bounds);
+  F32 leaf_cost = area * static_cast<F32>(count);
+  bool found_split = best_split != 0;
+  if (found_split && kTraversalCost * area + best_cost >= leaf_cost && count <= kMaxLeafObjects) {
+    make_leaf();
+    return;
+  }
+  if (!found_split && count <= kMaxLeafObjects) {
+    make_leaf();
+    return;
+  }
+
+  U32 middle = first + count / 2;
+  if (found_split) {
+    F32 minimum = component(centroid_bounds.min, best_axis);
+    F32 scale = static_cast<F32>(kBinCount) /
+                (component(centroid_bounds.max, best_axis) - minimum);
+
+    U32 left = first;
+    U32 right = first + count;
+    while (left < right) {
+      U32 object = node_objects_[left];
+      U32 bin = static_cast<U32>((component(centroids_[object], best_axis) - minimum) * scale);
+      bin = bin < kBinCount ? bin : kBinCount - 1;
+      if (bin < best_split) {
+        ++left;
+      } else {
+        --right;
+        node_objects_[left] = node_objects_[right];
+        node_objects_[right] = object;
+      }
+    }
+    middle = left;
+  }
+
+  // Identical centroids can't be separated; split the range in half to keep leaves small.
+  if (middle == first || middle == first + count) {
+    middle = first + count / 2;
+  }
+
+  U32 left_child = static_cast<U32>(nodes_.size());
+  nodes_.pushBack(Node{empty_aabb(), node_index, 0, first, middle - first});
+  nodes_.pushBack(Node{empty_aabb(), node_index, 0, middle, first + count - middle});
+  nodes_[node_index].left = left_child;
+
+  build_node(left_child, depth + 1);
+  build_node(left_child + 1, depth + 1);
+}
+
+void Bvh::refit_leaf(U32 node_index) {
+  Node& leaf = nodes_[node_index];
+  Aabb bounds = empty_aabb();
+  for (U32 i = leaf.first; i < leaf.first + leaf.count; ++i) {
+    const Object& object = objects_[node_objects_[i]];
+    if (object.alive) {
+      grow(&bounds, object.bounds);
+    }
+  }
+  leaf.bounds = bounds;
+
+  // Walk up until a node's bounds don't change; nothing above it changes either.
+  U32 parent = leaf.parent;
+  while (parent != kInvalidNode) {
+    Node& node = nodes_[parent];
+    Aabb merged = nodes_[node.left].bounds;
+    grow(&merged, nodes_[node.left + 1].bounds);
+    if (same_bounds(merged, node.bounds)) {
+      break;
+    }
+    node.bounds = merged;
+    parent = node.parent;
+  }
+}
+
+void Bvh::append_objects(const Node& node, nu::DynamicArray<U32>* result) const {
+  for (U32 i = node.first; i < node.first + node.count; ++i) {
+    const Object& object = objects_[node_objects_[i]];
+    if (object.alive) {
+      result->pushBack(object.user_data);
+    }
+  }
+}
+
+void Bvh::query_frustum(const Frustum& frustum, nu::DynamicArray<U32>* result) const {
+  if (nodes_.empty()) {
+    return;
+  }
+
+  U32 stack[kStackSize];
+  U32 stack_size = 0;
+  stack[stack_size++] = 0;
+
+  while (stack_size > 0) {
+    const Node& node = nodes_[stack[--stack_size]];
+
+    Containment containment = classify(frustum, node.bounds);
+    if (containment == Containment::Outside) {
+      continue;
+    }
+
+    // Everything below a node that is fully inside is visible without further tests.
+    if (containment == Containment::Inside) {
+      append_objects(node, result);
+      continue;
+    }
+
+    if (node.left == 0) {
+      for (U32 i = node.first; i < node.first + node.count; ++i) {
+        const Object& object = objects_[node_objects_[i]];
+        if (object.alive && is_visible(frustum, object.bounds)) {
+          result->pushBack(object.user_data);
+        }
+      }
+      continue;
+    }
+
+    stack[stack_size++] = node.left;
+    stack[stack_size++] = node.left + 1;
+  }
+}
+
+void Bvh::query_box(const Aabb& aabb, nu::DynamicArray<U32>* result) const {
+  if (nodes_.empty()) {
+    return;
+  }
+
+  U32 stack[kStackSize];
+  U32 stack_size = 0;
+  stack[stack_size++] = 0;
+
+  while (stack_size > 0) {
+    const Node& node = nodes_[stack[--stack_size]];
+    if (!overlaps(node.bounds, aabb)) {
+      continue;
+    }
+
+    if (node.left == 0) {
+      for (U32 i = node.first; i < node.first + node.count; ++i) {
+        const Object& object = objects_[node_objects_[i]];
+        if (object.alive && overlaps(object.bounds, aabb)) {
+          result->pushBack(object.user_data);
+        }
+      }
+      continue;
+    }
+
+    stack[stack_size++] = node.left;
+    stack[stack_size++] = node.left + 1;
+  }
+}
+
+bool Bvh::ray_cast(const Ray& ray, F32 max_distance, BvhRayHit* hit,
+                   const BvhRayFilter& filter) const {
+  F32 distance;
+  if (nodes_.empty() || !intersect_ray_aabb(ray, nodes_[0].bounds, max_distance, &distance)) {
+    return false;
+  }
+
+  struct Entry {
+    U32 node;
+    F32 distance;
+  };
+  Entry stack[kStackSize];
+  U32 stack_size = 0;
+  stack[stack_size++] = Entry{0, distance};
+
+  F32 closest = max_distance;
+  bool found = false;
+
+  while (stack_size > 0) {
+    Entry entry = stack[--stack_size];
+    if (entry.distance > closest) {
+      continue;
+    }
+
+    const Node& node = nodes_[entry.node];
+    if (node.left == 0) {
+      for (U32 i = node.first; i < node.first + node.count; ++i) {
+        U32 handle = node_objects_[i];
+        const Object& object = objects_[handle];
+        if (!object.alive || !intersect_ray_aabb(ray, object.bounds, closest, &distance)) {
+          continue;
+        }
+        if (filter && (!filter(object.user_data, ray, &distance) || distance > closest)) {
+          continue;
+        }
+
+        closest = distance;
+        found = true;
+        hit->handle = handle;
+        hit->user_data = object.user_data;
+        hit->distance = distance;
+      }
+      continue;
+    }
+
+    // Visit the nearer child first by pushing it last.
+    F32 left_distance, right_distance;
+    bool left_hit = intersect_ray_aabb(ray, nodes_[node.left].bounds, closest, &left_distance);
+    bool right_hit =
+        intersect_ray_aabb(ray, nodes_[node.left + 1].bounds, closest, &right_distance);
+
+    if (left_hit && right_hit) {
+      if (left_distance <= right_distance) {
+        stack[stack_size++] = Entry{node.left + 1, right_distance};
+        stack[stack_size++] = Entry{node.left, left_distance};
+      } else {
+        stack[stack_size++] = Entry{node.left, left_distance};
+        stack[stack_size++] = Entry{node.left + 1, right_distance};
+      }
+    } else if (left_hit) {
+      stack[stack_size++] = Entry{node.left, left_distance};
+    } else if (right_hit) {
+      stack[stack_size++] = Entry{node.left + 1, right_distance};
+    }
+  }
+
+  return found;
+}
+
+}  // namespace ca
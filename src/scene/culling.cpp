@@ -0,0 +1,221 @@
+#include "canvas/scene/culling.h"
+
+#include <cmath>
+
+#include "canvas/utils/simd.h"
+
+namespace ca {
+
+namespace {
+
+// Plane `a * x + b * y + c * z + d >= 0` in the frustum convention.
+fl::Plane make_plane(F32 a, F32 b, F32 c, F32 d) {
+  F32 length = std::sqrt(a * a + b * b + c * c);
+  if (length > 0.0f) {
+    a /= length;
+    b /= length;
+    c /= length;
+    d /= length;
+  }
+  return fl::Plane{fl::Vec3{a, b, c}, -d};
+}
+
+// Append `base + lane` for every set bit in `mask` without branching on the mask.
+U32 write_visible(U32 mask, U32 lanes, U32 base, U32* visible) {
+  U32 count = 0;
+  for (U32 lane = 0; lane < lanes; ++lane) {
+    visible[count] = base + lane;
+    count += (mask >> lane) & 1u;
+  }
+  return count;
+}
+
+// For every plane, the box corner furthest along the plane normal.
+struct PositiveVertexArrays {
+  const F32* x[Frustum::PlaneCount];
+  const F32* y[Frustum::PlaneCount];
+  const F32* z[Frustum::PlaneCount];
+};
+
+PositiveVertexArrays positive_vertex_arrays(const Frustum& frustum,
+                                            const AabbBoundsArrays& bounds) {
+  PositiveVertexArrays result;
+  for (U32 p = 0; p < Frustum::PlaneCount; ++p) {
+    const fl::Vec3& normal = frustum.planes[p].normal;
+    result.x[p] = normal.x >= 0.0f ? bounds.max_x : bounds.min_x;
+    result.y[p] = normal.y >= 0.0f ? bounds.max_y : bounds.min_y;
+    result.z[p] = normal.z >= 0.0f ? bounds.max_z : bounds.min_z;
+  }
+  return result;
+}
+
+}  // namespace
+
+Frustum extract_frustum(const fl::Mat4& view_projection) {
+  // Rows of the matrix, which is stored by columns.
+  const fl::Vec4* c = view_projection.col;
+  F32 row0[] = {c[0].x, c[1].x, c[2].x, c[3].x};
+  F32 row1[] = {c[0].y, c[1].y, c[2].y, c[3].y};
+  F32 row2[] = {c[0].z, c[1].z, c[2].z, c[3].z};
+  F32 row3[] = {c[0].w, c[1].w, c[2].w, c[3].w};
+
+  Frustum result;
+  result.planes[Frustum::Left] =
+      make_plane(row3[0] + row0[0], row3[1] + row0[1], row3[2] + row0[2], row3[3] + row0[3]);
+  result.planes[Frustum::Right] =
+      make_plane(row3[0] - row0[0], row3[1] - row0[1], row3[2] - row0[2], row3[3] - row0[3]);
+  result.planes[Frustum::Bottom] =
+      make_plane(row3[0] + row1[0], row3[1] + row1[1], row3[2] + row1[2], row3[3] + row1[3]);
+  result.planes[Frustum::Top] =
+      make_plane(row3[0] - row1[0], row3[1] - row1[1], row3[2] - row1[2], row3[3] - row1[3]);
+  result.planes[Frustum::Near] =
+      make_plane(row3[0] + row2[0], row3[1] + row2[1], row3[2] + row2[2], row3[3] + row2[3]);
+  result.planes[Frustum::Far] =
+      make_plane(row3[0] - row2[0], row3[1] - row2[1], row3[2] - row2[2], row3[3] - row2[3]);
+
+  return result;
+}
+
+bool is_visible(const Frustum& frustum, const BoundingSphere& sphere) {
+  for (const auto& plane : frustum.planes) {
+    F32 distance = plane.normal.x * sphere.center.x + plane.normal.y * sphere.center.y +
+                   plane.normal.z * sphere.center.z - plane.distance;
+    if (distance < -sphere.radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool is_visible(const Frustum& frustum, const Aabb& aabb) {
+  for (const auto& plane : frustum.planes) {
+    F32 x = plane.normal.x >= 0.0f ? aabb.max.x : aabb.min.x;
+    F32 y = plane.normal.y >= 0.0f ? aabb.max.y : aabb.min.y;
+    F32 z = plane.normal.z >= 0.0f ? aabb.max.z : aabb.min.z;
+    if (plane.normal.x * x + plane.normal.y * y + plane.normal.z * z < plane.distance) {
+      return false;
+    }
+  }
+  return true;
+}
+
+U32 cull_spheres(const Frustum& frustum, const SphereBoundsArrays& bounds, U32 first, U32 count,
+                 U32* visible) {
+  const fl::Plane* planes = frustum.planes;
+  U32 visible_count = 0;
+  U32 index = first;
+  U32 end = first + count;
+
+#if CANVAS_AVX
+  for (; index + 8 <= end; index += 8) {
+    __m256 x = _mm256_loadu_ps(bounds.center_x + index);
+    __m256 y = _mm256_loadu_ps(bounds.center_y + index);
+    __m256 z = _mm256_loadu_ps(bounds.center_z + index);
+    __m256 negative_radius =
+        _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(bounds.radius + index));
+
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (U32 p = 0; p < Frustum::PlaneCount; ++p) {
+      __m256 distance = _mm256_sub_ps(
+          _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(planes[p].normal.x)),
+                                      _mm256_mul_ps(y, _mm256_set1_ps(planes[p].normal.y))),
+                        _mm256_mul_ps(z, _mm256_set1_ps(planes[p].normal.z))),
+          _mm256_set1_ps(planes[p].distance));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negative_radius, _CMP_GE_OQ));
+    }
+
+    U32 mask = static_cast<U32>(_mm256_movemask_ps(inside));
+    visible_count += write_visible(mask, 8, index, visible + visible_count);
+  }
+#endif
+
+#if CANVAS_SSE
+  for (; index + 4 <= end; index += 4) {
+    __m128 x = _mm_loadu_ps(bounds.center_x + index);
+    __m128 y = _mm_loadu_ps(bounds.center_y + index);
+    __m128 z = _mm_loadu_ps(bounds.center_z + index);
+    __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(bounds.radius + index));
+
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (U32 p = 0; p < Frustum::PlaneCount; ++p) {
+      __m128 distance =
+          _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes[p].normal.x)),
+                                           _mm_mul_ps(y, _mm_set1_ps(planes[p].normal.y))),
+                                _mm_mul_ps(z, _mm_set1_ps(planes[p].normal.z))),
+                     _mm_set1_ps(planes[p].distance));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+    }
+
+    U32 mask = static_cast<U32>(_mm_movemask_ps(inside));
+    visible_count += write_visible(mask, 4, index, visible + visible_count);
+  }
+#endif
+
+  for (; index < end; ++index) {
+    BoundingSphere sphere{
+        fl::Vec3{bounds.center_x[index], bounds.center_y[index], bounds.center_z[index]},
+        bounds.radius[index]};
+    visible[visible_count] = index;
+    visible_count += is_visible(frustum, sphere) ? 1 : 0;
+  }
+
+  return visible_count;
+}
+
+U32 cull_aabbs(const Frustum& frustum, const AabbBoundsArrays& bounds, U32 first, U32 count,
+               U32* visible) {
+  const fl::Plane* planes = frustum.planes;
+  PositiveVertexArrays corners = positive_vertex_arrays(frustum, bounds);
+  U32 visible_count = 0;
+  U32 index = first;
+  U32 end = first + count;
+
+#if CANVAS_AVX
+  for (; index + 8 <= end; index += 8) {
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (U32 p = 0; p < Frustum::PlaneCount; ++p) {
+      __m256 x = _mm256_loadu_ps(corners.x[p] + index);
+      __m256 y = _mm256_loadu_ps(corners.y[p] + index);
+      __m256 z = _mm256_loadu_ps(corners.z[p] + index);
+      __m256 distance =
+          _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(planes[p].normal.x)),
+                                      _mm256_mul_ps(y, _mm256_set1_ps(planes[p].normal.y))),
+                        _mm256_mul_ps(z, _mm256_set1_ps(planes[p].normal.z)));
+      inside = _mm256_and_ps(
+          inside, _mm256_cmp_ps(distance, _mm256_set1_ps(planes[p].distance), _CMP_GE_OQ));
+    }
+
+    U32 mask = static_cast<U32>(_mm256_movemask_ps(inside));
+    visible_count += write_visible(mask, 8, index, visible + visible_count);
+  }
+#endif
+
+#if CANVAS_SSE
+  for (; index + 4 <= end; index += 4) {
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (U32 p = 0; p < Frustum::PlaneCount; ++p) {
+      __m128 x = _mm_loadu_ps(corners.x[p] + index);
+      __m128 y = _mm_loadu_ps(corners.y[p] + index);
+      __m128 z = _mm_loadu_ps(corners.z[p] + index);
+      __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes[p].normal.x)),
+                                              _mm_mul_ps(y, _mm_set1_ps(planes[p].normal.y))),
+                                   _mm_mul_ps(z, _mm_set1_ps(planes[p].normal.z)));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_set1_ps(planes[p].distance)));
+    }
+
+    U32 mask = static_cast<U32>(_mm_movemask_ps(inside));
+    visible_count += write_visible(mask, 4, index, visible + visible_count);
+  }
+#endif
+
+  for (; index < end; ++index) {
+    Aabb aabb{fl::Vec3{bounds.min_x[index], bounds.min_y[index], bounds.min_z[index]},
+              fl::Vec3{bounds.max_x[index], bounds.max_y[index], bounds.max_z[index]}};
+    visible[visible_count] = index;
+    visible_count += is_visible(frustum, aabb) ? 1 : 0;
+  }
+
+  return visible_count;
+}
+
+}  // namespace ca
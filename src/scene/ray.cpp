@@ -0,0 +1,135 @@
+#include "canvas/scene/ray.h"
+
+#include <cmath>
+
+namespace ca {
+
+namespace {
+
+// General 4x4 inverse by cofactors.  Works for either storage order, since the inverse of the
+// transpose is the transpose of the inverse.
+bool invert(const F32* m, F32* out) {
+  F32 inv[16];
+
+  inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] +
+           m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+  inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] -
+           m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+  inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] +
+           m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+  inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] -
+            m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+  inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] -
+           m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+  inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] +
+           m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+  inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] -
+           m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+  inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] +
+            m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+  inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] +
+           m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+  inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] -
+           m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+  inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] +
+            m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+  inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] -
+            m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+  inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] -
+           m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+  inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] +
+           m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+  inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] -
+            m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+  inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] +
+            m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+  F32 determinant = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+  if (determinant == 0.0f) {
+    return false;
+  }
+
+  F32 inverse_determinant = 1.0f / determinant;
+  for (MemSize i = 0; i < 16; ++i) {
+    out[i] = inv[i] * inverse_determinant;
+  }
+
+  return true;
+}
+
+fl::Vec3 unproject(const F32* inverse, F32 x, F32 y, F32 z) {
+  // Column major: element (row, column) is at `column * 4 + row`.
+  F32 rx = inverse[0] * x + inverse[4] * y + inverse[8] * z + inverse[12];
+  F32 ry = inverse[1] * x + inverse[5] * y + inverse[9] * z + inverse[13];
+  F32 rz = inverse[2] * x + inverse[6] * y + inverse[10] * z + inverse[14];
+  F32 rw = inverse[3] * x + inverse[7] * y + inverse[11] * z + inverse[15];
+  F32 w = rw != 0.0f ? 1.0f / rw : 1.0f;
+  return fl::Vec3{rx * w, ry * w, rz * w};
+}
+
+}  // namespace
+
+bool intersect_ray_aabb(const Ray& ray, const Aabb& aabb, F32 max_distance, F32* distance) {
+  F32 t_min = 0.0f;
+  F32 t_max = max_distance;
+
+  const F32 origin[] = {ray.origin.x, ray.origin.y, ray.origin.z};
+  const F32 direction[] = {ray.direction.x, ray.direction.y, ray.direction.z};
+  const F32 minimum[] = {aabb.min.x, aabb.min.y, aabb.min.z};
+  const F32 maximum[] = {aabb.max.x, aabb.max.y, aabb.max.z};
+
+  for (MemSize axis = 0; axis < 3; ++axis) {
+    if (direction[axis] == 0.0f) {
+      if (origin[axis] < minimum[axis] || origin[axis] > maximum[axis]) {
+        return false;
+      }
+      continue;
+    }
+
+    F32 inverse = 1.0f / direction[axis];
+    F32 t0 = (minimum[axis] - origin[axis]) * inverse;
+    F32 t1 = (maximum[axis] - origin[axis]) * inverse;
+    if (t0 > t1) {
+      F32 temp = t0;
+      t0 = t1;
+      t1 = temp;
+    }
+
+    t_min = t0 > t_min ? t0 : t_min;
+    t_max = t1 < t_max ? t1 : t_max;
+    if (t_min > t_max) {
+      return false;
+    }
+  }
+
+  *distance = t_min;
+  return true;
+}
+
+Ray screen_ray(const fl::Pos& position, const fl::Size& viewport,
+               const fl::Mat4& view_projection) {
+  F32 inverse[16];
+  if (!invert(&view_projection.col[0].x, inverse) || viewport.width <= 0 ||
+      viewport.height <= 0) {
+    return Ray{fl::Vec3::zero, fl::Vec3::forward};
+  }
+
+  // Window coordinates have the origin in the top left corner.
+  F32 x = (static_cast<F32>(position.x) + 0.5f) / static_cast<F32>(viewport.width) * 2.0f - 1.0f;
+  F32 y = 1.0f - (static_cast<F32>(position.y) + 0.5f) / static_cast<F32>(viewport.height) * 2.0f;
+
+  fl::Vec3 near_point = unproject(inverse, x, y, -1.0f);
+  fl::Vec3 far_point = unproject(inverse, x, y, 1.0f);
+
+  fl::Vec3 direction{far_point.x - near_point.x, far_point.y - near_point.y,
+                     far_point.z - near_point.z};
+  F32 length = std::sqrt(direction.x * direction.x + direction.y * direction.y +
+                         direction.z * direction.z);
+  if (length > 0.0f) {
+    direction = fl::Vec3{direction.x / length, direction.y / length, direction.z / length};
+  }
+
+  return Ray{near_point, direction};
+}
+
+}  // namespace ca
@@ -0,0 +1,248 @@
+#include "canvas/scene/scene_graph.h"
+
+#include <algorithm>
+
+#include "canvas/utils/simd_math.h"
+#include "nucleus/config.h"
+#include "nucleus/logging.h"
+
+namespace ca {
+
+namespace {
+
+constexpr U32 kInvalidPosition = ~0u;
+
+}  // namespace
+
+SceneGraph::SceneGraph() = default;
+
+SceneNodeId SceneGraph::create_node(SceneNodeId parent, const fl::Mat4& local_transform) {
+  DCHECK(parent == kInvalidSceneNode || (parent < nodes_.size() && nodes_[parent].alive))
+      << "Invalid parent node";
+
+  SceneNodeId node;
+  if (!free_nodes_.empty()) {
+    node = free_nodes_[free_nodes_.size() - 1];
+    free_nodes_.resize(free_nodes_.size() - 1);
+  } else {
+    node = static_cast<SceneNodeId>(nodes_.size());
+    nodes_.pushBack({});
+  }
+
+  U32 position = static_cast<U32>(order_.size());
+  nodes_[node] = NodeInfo{parent, position, true};
+
+  // A new root at the end keeps the order valid; a new child has to be moved next to its parent.
+  order_.pushBack(node);
+  parent_positions_.pushBack(parent == kInvalidSceneNode ? kInvalidPosition
+                                                          : nodes_[parent].position);
+  subtree_sizes_.pushBack(1);
+  local_.pushBack(local_transform);
+  world_.pushBack(local_transform);
+  dirty_.pushBack(1);
+  dirty_positions_.pushBack(position);
+
+  if (parent != kInvalidSceneNode) {
+    needs_sort_ = true;
+  }
+
+  return node;
+}
+
+void SceneGraph::destroy_node(SceneNodeId node) {
+  DCHECK(node < nodes_.size() && nodes_[node].alive) << "Invalid scene node";
+
+  // The node and its descendants are released when the nodes are sorted.
+  nodes_[node].alive = false;
+  needs_sort_ = true;
+}
+
+void SceneGraph::set_parent(SceneNodeId node, SceneNodeId parent) {
+  DCHECK(node < nodes_.size() && nodes_[node].alive) << "Invalid scene node";
+
+#if BUILD(DEBUG)
+  for (SceneNodeId ancestor = parent; ancestor != kInvalidSceneNode;
+       ancestor = nodes_[ancestor].parent) {
+    DCHECK(ancestor != node) << "Parenting a node to its own descendant";
+  }
+#endif
+
+  if (nodes_[node].parent == parent) {
+    return;
+  }
+
+  nodes_[node].parent = parent;
+  needs_sort_ = true;
+}
+
+SceneNodeId SceneGraph::parent(SceneNodeId node) const {
+  DCHECK(node < nodes_.size()) << "Invalid scene node";
+  return nodes_[node].parent;
+}
+
+void SceneGraph::set_local_transform(SceneNodeId node, const fl::Mat4& local_transform) {
+  DCHECK(node < nodes_.size() && nodes_[node].alive) << "Invalid scene node";
+
+  U32 position = nodes_[node].position;
+  local_[position] = local_transform;
+  if (!dirty_[position]) {
+    dirty_[position] = 1;
+    dirty_positions_.pushBack(position);
+  }
+}
+
+const fl::Mat4& SceneGraph::local_transform(SceneNodeId node) const {
+  DCHECK(node < nodes_.size()) << "Invalid scene node";
+  return local_[nodes_[node].position];
+}
+
+const fl::Mat4& SceneGraph::world_transform(SceneNodeId node) const {
+  DCHECK(node < nodes_.size()) << "Invalid scene node";
+  return world_[nodes_[node].position];
+}
+
+U32 SceneGraph::position(SceneNodeId node) const {
+  DCHECK(node < nodes_.size()) << "Invalid scene node";
+  return nodes_[node].position;
+}
+
+void SceneGraph::copy_world_transforms(const SceneNodeId* nodes, MemSize count,
+                                       fl::Mat4* destination) const {
+  for (MemSize i = 0; i < count; ++i) {
+    destination[i] = world_[nodes_[nodes[i]].position];
+  }
+}
+
+void SceneGraph::update() {
+  if (needs_sort_) {
+    sort_nodes();
+    update_range(0, static_cast<U32>(order_.size()));
+    return;
+  }
+
+  // Parents come before their children, so handling dirty nodes in order means a dirty node
+  // inside an already updated subtree can be skipped.
+  std::sort(dirty_positions_.begin(), dirty_positions_.end());
+
+  U32 updated_end = 0;
+  for (U32 position : dirty_positions_) {
+    dirty_[position] = 0;
+    if (position < updated_end) {
+      continue;
+    }
+
+    updated_end = position + subtree_sizes_[position];
+    update_range(position, updated_end);
+  }
+
+  dirty_positions_.clear();
+}
+
+void SceneGraph::sort_nodes() {
+  MemSize node_count = nodes_.size();
+
+  // Child lists, built in reverse so that popping them off a stack visits children in id order.
+  nu::DynamicArray<SceneNodeId> first_child;
+  nu::DynamicArray<SceneNodeId> next_sibling;
+  first_child.resize(node_count);
+  next_sibling.resize(node_count);
+  std::fill(first_child.begin(), first_child.end(), kInvalidSceneNode);
+  std::fill(next_sibling.begin(), next_sibling.end(), kInvalidSceneNode);
+
+  nu::DynamicArray<SceneNodeId> stack;
+  for (SceneNodeId node = 0; node < node_count; ++node) {
+    const NodeInfo& info = nodes_[node];
+    if (!info.alive) {
+      continue;
+    }
+
+    if (info.parent == kInvalidSceneNode) {
+      stack.pushBack(node);
+    } else {
+      next_sibling[node] = first_child[info.parent];
+      first_child[info.parent] = node;
+    }
+  }
+  std::reverse(stack.begin(), stack.end());
+
+  nu::DynamicArray<SceneNodeId> order;
+  nu::DynamicArray<U32> parent_positions;
+  nu::DynamicArray<fl::Mat4> local;
+
+  while (!stack.empty()) {
+    SceneNodeId node = stack[stack.size() - 1];
+    stack.resize(stack.size() - 1);
+
+    NodeInfo& info = nodes_[node];
+    order.pushBack(node);
+    parent_positions.pushBack(info.parent == kInvalidSceneNode ? kInvalidPosition
+                                                               : nodes_[info.parent].position);
+    local.pushBack(local_[info.position]);
+    info.position = static_cast<U32>(order.size() - 1);
+
+    for (SceneNodeId child = first_child[node]; child != kInvalidSceneNode;
+         child = next_sibling[child]) {
+      stack.pushBack(child);
+    }
+  }
+
+  // Nodes that were not reached were destroyed or are below a destroyed node.  Visited nodes
+  // have their new positions, which are always below `order.size()`, so mark the rest by
+  // checking that the node at their old position isn't them.
+  for (SceneNodeId node = 0; node < node_count; ++node) {
+    NodeInfo& info = nodes_[node];
+    if (info.position == kInvalidPosition) {
+      continue;
+    }
+    if (info.position >= order.size() || order[info.position] != node) {
+      info.alive = false;
+      info.position = kInvalidPosition;
+      free_nodes_.pushBack(node);
+    }
+  }
+
+  U32 count = static_cast<U32>(order.size());
+  nu::DynamicArray<U32> subtree_sizes;
+  subtree_sizes.resize(count);
+  std::fill(subtree_sizes.begin(), subtree_sizes.end(), 1u);
+  for (U32 position = count; position-- > 1;) {
+    U32 parent = parent_positions[position];
+    if (parent != kInvalidPosition) {
+      subtree_sizes[parent] += subtree_sizes[position];
+    }
+  }
+
+  order_ = std::move(order);
+  parent_positions_ = std::move(parent_positions);
+  subtree_sizes_ = std::move(subtree_sizes);
+  local_ = std::move(local);
+  world_.resize(count);
+  dirty_.resize(count);
+  std::fill(dirty_.begin(), dirty_.end(), U8{0});
+  dirty_positions_.clear();
+  needs_sort_ = false;
+}
+
+void SceneGraph::update_range(U32 first, U32 end) {
+  U32 position = first;
+  while (position < end) {
+    U32 parent = parent_positions_[position];
+    if (parent == kInvalidPosition) {
+      world_[position] = local_[position];
+      ++position;
+      continue;
+    }
+
+    // Consecutive nodes with the same parent are siblings without children of their own (except
+    // for the last), so they can be multiplied as a batch.
+    U32 run_end = position + 1;
+    while (run_end < end && parent_positions_[run_end] == parent) {
+      ++run_end;
+    }
+
+    multiply_mat4_batch(world_[parent], &local_[position], run_end - position, &world_[position]);
+    position = run_end;
+  }
+}
+
+}  // namespace ca
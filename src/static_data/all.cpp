@@ -0,0 +1,13 @@
+#include "canvas/static_data/all.h"
+
+namespace ca {
+
+void expandMonochrome(const U8* bits, I32 width, I32 height, U8* pixels) {
+  const MemSize pixelCount = static_cast<MemSize>(width) * static_cast<MemSize>(height);
+
+  for (MemSize i = 0; i < pixelCount; ++i) {
+    pixels[i] = (bits[i / 8] & (0x80 >> (i % 8))) ? 255 : 0;
+  }
+}
+
+}  // namespace ca
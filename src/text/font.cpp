@@ -0,0 +1,558 @@
+#include "canvas/text/font.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "nucleus/logging.h"
+
+namespace ca {
+
+namespace {
+
+// Composite glyphs reference other glyphs; anything deeper than this is considered malformed.
+constexpr U32 kMaxCompositeDepth = 8;
+
+enum SimpleGlyphFlags : U8 {
+  kOnCurve = 0x01,
+  kXShort = 0x02,
+  kYShort = 0x04,
+  kRepeat = 0x08,
+  kXSameOrPositive = 0x10,
+  kYSameOrPositive = 0x20,
+};
+
+enum CompositeGlyphFlags : U16 {
+  kArgsAreWords = 0x0001,
+  kArgsAreXYValues = 0x0002,
+  kHaveScale = 0x0008,
+  kMoreComponents = 0x0020,
+  kHaveXYScale = 0x0040,
+  kHaveTwoByTwo = 0x0080,
+};
+
+struct OutlineBuilder {
+  nu::DynamicArray<OutlineSegment>* segments;
+  U32 curve_steps;
+  F32 x = 0.0f;
+  F32 y = 0.0f;
+
+  void line_to(F32 to_x, F32 to_y) {
+    segments->pushBack(OutlineSegment{x, y, to_x, to_y});
+    x = to_x;
+    y = to_y;
+  }
+
+  void quad_to(F32 control_x, F32 control_y, F32 to_x, F32 to_y) {
+    F32 from_x = x;
+    F32 from_y = y;
+    for (U32 step = 1; step <= curve_steps; ++step) {
+      F32 t = static_cast<F32>(step) / static_cast<F32>(curve_steps);
+      F32 u = 1.0f - t;
+      line_to(u * u * from_x + 2.0f * u * t * control_x + t * t * to_x,
+              u * u * from_y + 2.0f * u * t * control_y + t * t * to_y);
+    }
+  }
+};
+
+}  // namespace
+
+bool Font::load(const void* data, MemSize size) {
+  data_.clear();
+  glyph_count_ = 0;
+
+  data_.resize(size);
+  std::memcpy(data_.data(), data, size);
+
+  if (size < 12) {
+    LOG(Error) << "Font data is too small.";
+    return false;
+  }
+
+  MemSize head = 0;
+  MemSize hhea = 0;
+  MemSize maxp = 0;
+  MemSize cmap = 0;
+  MemSize glyf = 0;
+  MemSize glyf_size = 0;
+  MemSize loca = 0;
+  MemSize hmtx = 0;
+
+  U16 table_count = read_u16(4);
+  for (U16 i = 0; i < table_count; ++i) {
+    MemSize record = 12 + static_cast<MemSize>(i) * 16;
+    MemSize offset = read_u32(record + 8);
+    MemSize length = read_u32(record + 12);
+    if (record + 16 > size || offset + length > size) {
+      LOG(Error) << "Font table out of bounds.";
+      return false;
+    }
+
+    const U8* tag = data_.data() + record;
+    if (std::memcmp(tag, "head", 4) == 0) {
+      head = offset;
+    } else if (std::memcmp(tag, "hhea", 4) == 0) {
+      hhea = offset;
+    } else if (std::memcmp(tag, "maxp", 4) == 0) {
+      maxp = offset;
+    } else if (std::memcmp(tag, "cmap", 4) == 0) {
+      cmap = offset;
+    } else if (std::memcmp(tag, "glyf", 4) == 0) {
+      glyf = offset;
+      glyf_size = length;
+    } else if (std::memcmp(tag, "loca", 4) == 0) {
+      loca = offset;
+    } else if (std::memcmp(tag, "hmtx", 4) == 0) {
+      hmtx = offset;
+    }
+  }
+
+  if (!head || !hhea || !maxp || !cmap || !glyf || !loca || !hmtx) {
+    LOG(Error) << "Font is missing required tables (only TrueType outlines are supported).";
+    return false;
+  }
+
+  metrics_.units_per_em = static_cast<F32>(read_u16(head + 18));
+  metrics_.x_min = static_cast<F32>(static_cast<I16>(read_u16(head + 36)));
+  metrics_.y_min = static_cast<F32>(static_cast<I16>(read_u16(head + 38)));
+  metrics_.x_max = static_cast<F32>(static_cast<I16>(read_u16(head + 40)));
+  metrics_.y_max = static_cast<F32>(static_cast<I16>(read_u16(head + 42)));
+  long_loca_ = read_u16(head + 50) != 0;
+  metrics_.ascender = static_cast<F32>(static_cast<I16>(read_u16(hhea + 4)));
+  metrics_.descender = static_cast<F32>(static_cast<I16>(read_u16(hhea + 6)));
+  metrics_.line_gap = static_cast<F32>(static_cast<I16>(read_u16(hhea + 8)));
+  hmetric_count_ = read_u16(hhea + 34);
+
+  // Prefer the full Unicode map, then the basic multilingual plane.
+  cmap_ = 0;
+  cmap_format_ = 0;
+  U16 subtable_count = read_u16(cmap + 2);
+  for (U16 i = 0; i < subtable_count; ++i) {
+    MemSize record = cmap + 4 + static_cast<MemSize>(i) * 8;
+    U16 platform = read_u16(record);
+    U16 encoding = read_u16(record + 2);
+    MemSize subtable = cmap + read_u32(record + 4);
+    U16 format = read_u16(subtable);
+
+    bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+    if (!unicode) {
+      continue;
+    }
+
+    if (format == 12 || (format == 4 && cmap_format_ != 12)) {
+      cmap_ = subtable;
+      cmap_format_ = format;
+    }
+  }
+
+  if (!cmap_ || !metrics_.units_per_em || !hmetric_count_) {
+    LOG(Error) << "Font has no usable character map or metrics.";
+    return false;
+  }
+
+  glyf_ = glyf;
+  glyf_size_ = glyf_size;
+  loca_ = loca;
+  hmtx_ = hmtx;
+  glyph_count_ = read_u16(maxp + 4);
+
+  return glyph_count_ > 0;
+}
+
+bool Font::load_from_file(const char* path) {
+  std::FILE* file = std::fopen(path, "rb");
+  if (!file) {
+    LOG(Error) << "Could not open font file: " << path;
+    return false;
+  }
+
+  nu::DynamicArray<U8> contents;
+  U8 buffer[4096];
+  for (MemSize read; (read = std::fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+    MemSize offset = contents.size();
+    contents.resize(offset + read);
+    std::memcpy(contents.data() + offset, buffer, read);
+  }
+  std::fclose(file);
+
+  return load(contents.data(), contents.size());
+}
+
+U32 Font::glyph_index(U32 codepoint) const {
+  if (cmap_format_ == 12) {
+    // Don't trust the group count further than the subtable and the file go.
+    MemSize available = cmap_ < data_.size() ? data_.size() - cmap_ : 0;
+    MemSize subtable_length = std::min<MemSize>(read_u32(cmap_ + 4), available);
+    MemSize group_count = subtable_length >= 16 ? (subtable_length - 16) / 12 : 0;
+    group_count = std::min<MemSize>(group_count, read_u32(cmap_ + 12));
+
+    // Groups are sorted and don't overlap, so their last code points are sorted as well.
+    MemSize low = 0;
+    MemSize high = group_count;
+    while (low < high) {
+      MemSize middle = (low + high) / 2;
+      if (read_u32(cmap_ + 16 + middle * 12 + 4) < codepoint) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+
+    if (low == group_count) {
+      return 0;
+    }
+
+    MemSize group = cmap_ + 16 + low * 12;
+    U32 first = read_u32(group);
+    if (codepoint < first) {
+      return 0;
+    }
+
+    U32 glyph = read_u32(group + 8) + (codepoint - first);
+    return glyph < glyph_count_ ? glyph : 0;
+  }
+
+  if (codepoint > 0xffff) {
+    return 0;
+  }
+
+  MemSize segment_count = read_u16(cmap_ + 6) / 2;
+  MemSize end_codes = cmap_ + 14;
+  MemSize start_codes = end_codes + segment_count * 2 + 2;
+  MemSize id_deltas = start_codes + segment_count * 2;
+  MemSize id_range_offsets = id_deltas + segment_count * 2;
+
+  // Segments are sorted by end code.
+  MemSize low = 0;
+  MemSize high = segment_count;
+  while (low < high) {
+    MemSize middle = (low + high) / 2;
+    if (read_u16(end_codes + middle * 2) < codepoint) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  if (low == segment_count || read_u16(start_codes + low * 2) > codepoint) {
+    return 0;
+  }
+
+  U16 start = read_u16(start_codes + low * 2);
+  U16 delta = read_u16(id_deltas + low * 2);
+  MemSize range_offset_position = id_range_offsets + low * 2;
+  U16 range_offset = read_u16(range_offset_position);
+
+  U32 glyph;
+  if (range_offset == 0) {
+    glyph = (codepoint + delta) & 0xffff;
+  } else {
+    glyph = read_u16(range_offset_position + range_offset + (codepoint - start) * 2);
+    if (glyph) {
+      glyph = (glyph + delta) & 0xffff;
+    }
+  }
+
+  return glyph < glyph_count_ ? glyph : 0;
+}
+
+F32 Font::advance(U32 glyph) const {
+  U32 metric = glyph < hmetric_count_ ? glyph : hmetric_count_ - 1;
+  return static_cast<F32>(read_u16(hmtx_ + static_cast<MemSize>(metric) * 4));
+}
+
+bool Font::glyph_outline(U32 glyph, nu::DynamicArray<OutlineSegment>* segments,
+                         U32 curve_steps) const {
+  if (glyph >= glyph_count_) {
+    return false;
+  }
+
+  return outline(glyph, segments, curve_steps > 0 ? curve_steps : 1, 0);
+}
+
+bool Font::glyph_range(U32 glyph, MemSize* begin, MemSize* end) const {
+  if (long_loca_) {
+    *begin = read_u32(loca_ + static_cast<MemSize>(glyph) * 4);
+    *end = read_u32(loca_ + static_cast<MemSize>(glyph) * 4 + 4);
+  } else {
+    *begin = static_cast<MemSize>(read_u16(loca_ + static_cast<MemSize>(glyph) * 2)) * 2;
+    *end = static_cast<MemSize>(read_u16(loca_ + static_cast<MemSize>(glyph) * 2 + 2)) * 2;
+  }
+
+  if (*begin > *end || *end > glyf_size_) {
+    return false;
+  }
+
+  *begin += glyf_;
+  *end += glyf_;
+  return true;
+}
+
+bool Font::outline(U32 glyph, nu::DynamicArray<OutlineSegment>* segments, U32 curve_steps,
+                   U32 depth) const {
+  MemSize begin;
+  MemSize end;
+  if (!glyph_range(glyph, &begin, &end)) {
+    return false;
+  }
+
+  // Glyphs without an outline, like space, have no data at all.
+  if (begin == end) {
+    return true;
+  }
+
+  if (end - begin < 10) {
+    return false;
+  }
+
+  auto contour_count = static_cast<I16>(read_u16(begin));
+  if (contour_count >= 0) {
+    return simple_outline(begin, end, contour_count, segments, curve_steps);
+  }
+
+  return depth < kMaxCompositeDepth &&
+         composite_outline(begin, end, segments, curve_steps, depth + 1);
+}
+
+bool Font::simple_outline(MemSize begin, MemSize end, I32 contour_count,
+                          nu::DynamicArray<OutlineSegment>* segments, U32 curve_steps) const {
+  if (contour_count == 0) {
+    return true;
+  }
+
+  MemSize end_points = begin + 10;
+  MemSize point_count = static_cast<MemSize>(read_u16(end_points + (contour_count - 1) * 2)) + 1;
+  MemSize offset = end_points + contour_count * 2;
+  offset += 2 + read_u16(offset);
+
+  nu::DynamicArray<U8> flags;
+  flags.resize(point_count);
+  for (MemSize i = 0; i < point_count;) {
+    if (offset >= end) {
+      return false;
+    }
+    U8 flag = data_[offset++];
+    MemSize repeat = 1;
+    if (flag & kRepeat) {
+      if (offset >= end) {
+        return false;
+      }
+      repeat += data_[offset++];
+    }
+    for (; repeat && i < point_count; --repeat) {
+      flags[i++] = flag;
+    }
+  }
+
+  nu::DynamicArray<F32> xs;
+  nu::DynamicArray<F32> ys;
+  xs.resize(point_count);
+  ys.resize(point_count);
+
+  auto read_coordinates = [&](nu::DynamicArray<F32>* values, U8 short_flag,
+                              U8 same_flag) -> bool {
+    I32 value = 0;
+    for (MemSize i = 0; i < point_count; ++i) {
+      U8 flag = flags[i];
+      if (flag & short_flag) {
+        if (offset + 1 > end) {
+          return false;
+        }
+        I32 delta = data_[offset++];
+        value += (flag & same_flag) ? delta : -delta;
+      } else if (!(flag & same_flag)) {
+        if (offset + 2 > end) {
+          return false;
+        }
+        value += static_cast<I16>(read_u16(offset));
+        offset += 2;
+      }
+      (*values)[i] = static_cast<F32>(value);
+    }
+    return true;
+  };
+
+  if (!read_coordinates(&xs, kXShort, kXSameOrPositive) ||
+      !read_coordinates(&ys, kYShort, kYSameOrPositive)) {
+    return false;
+  }
+
+  OutlineBuilder builder{segments, curve_steps};
+
+  MemSize first = 0;
+  for (I32 contour = 0; contour < contour_count; ++contour) {
+    MemSize last = read_u16(end_points + contour * 2);
+    if (last < first || last >= point_count) {
+      return false;
+    }
+
+    MemSize count = last - first + 1;
+    auto on_curve = [&](MemSize i) {
+      return (flags[first + i] & kOnCurve) != 0;
+    };
+
+    // Start at an on-curve point, or between the first two control points if there is none.
+    MemSize start = 0;
+    while (start < count && !on_curve(start)) {
+      ++start;
+    }
+
+    F32 start_x;
+    F32 start_y;
+    MemSize visit_first;
+    if (start == count) {
+      start_x = (xs[last] + xs[first]) * 0.5f;
+      start_y = (ys[last] + ys[first]) * 0.5f;
+      start = 0;
+      visit_first = 0;
+    } else {
+      start_x = xs[first + start];
+      start_y = ys[first + start];
+      visit_first = 1;
+    }
+
+    builder.x = start_x;
+    builder.y = start_y;
+
+    bool has_control = false;
+    F32 control_x = 0.0f;
+    F32 control_y = 0.0f;
+
+    for (MemSize k = visit_first; k < count; ++k) {
+      MemSize i = (start + k) % count;
+      F32 x = xs[first + i];
+      F32 y = ys[first + i];
+
+      if (on_curve(i)) {
+        if (has_control) {
+          builder.quad_to(control_x, control_y, x, y);
+        } else {
+          builder.line_to(x, y);
+        }
+        has_control = false;
+      } else {
+        // Two control points in a row imply an on-curve point between them.
+        if (has_control) {
+          builder.quad_to(control_x, control_y, (control_x + x) * 0.5f, (control_y + y) * 0.5f);
+        }
+        control_x = x;
+        control_y = y;
+        has_control = true;
+      }
+    }
+
+    if (has_control) {
+      builder.quad_to(control_x, control_y, start_x, start_y);
+    } else if (builder.x != start_x || builder.y != start_y) {
+      builder.line_to(start_x, start_y);
+    }
+
+    first = last + 1;
+  }
+
+  return true;
+}
+
+bool Font::composite_outline(MemSize begin, MemSize end,
+                             nu::DynamicArray<OutlineSegment>* segments, U32 curve_steps,
+                             U32 depth) const {
+  auto f2dot14 = [this](MemSize offset) {
+    return static_cast<F32>(static_cast<I16>(read_u16(offset))) / 16384.0f;
+  };
+
+  nu::DynamicArray<OutlineSegment> component;
+
+  MemSize offset = begin + 10;
+  U16 flags;
+  do {
+    if (offset + 4 > end) {
+      return false;
+    }
+    flags = read_u16(offset);
+    U16 glyph = read_u16(offset + 2);
+    offset += 4;
+
+    // The arguments and the scale that follow have to be in the glyph as well.
+    MemSize size = (flags & kArgsAreWords) ? 4 : 2;
+    if (flags & kHaveScale) {
+      size += 2;
+    } else if (flags & kHaveXYScale) {
+      size += 4;
+    } else if (flags & kHaveTwoByTwo) {
+      size += 8;
+    }
+    if (offset + size > end) {
+      return false;
+    }
+
+    F32 dx;
+    F32 dy;
+    if (flags & kArgsAreWords) {
+      dx = static_cast<F32>(static_cast<I16>(read_u16(offset)));
+      dy = static_cast<F32>(static_cast<I16>(read_u16(offset + 2)));
+      offset += 4;
+    } else {
+      dx = static_cast<F32>(static_cast<I8>(data_[offset]));
+      dy = static_cast<F32>(static_cast<I8>(data_[offset + 1]));
+      offset += 2;
+    }
+
+    // Components positioned by matching points are placed at the origin.
+    if (!(flags & kArgsAreXYValues)) {
+      dx = 0.0f;
+      dy = 0.0f;
+    }
+
+    F32 a = 1.0f;
+    F32 b = 0.0f;
+    F32 c = 0.0f;
+    F32 d = 1.0f;
+    if (flags & kHaveScale) {
+      a = d = f2dot14(offset);
+      offset += 2;
+    } else if (flags & kHaveXYScale) {
+      a = f2dot14(offset);
+      d = f2dot14(offset + 2);
+      offset += 4;
+    } else if (flags & kHaveTwoByTwo) {
+      a = f2dot14(offset);
+      b = f2dot14(offset + 2);
+      c = f2dot14(offset + 4);
+      d = f2dot14(offset + 6);
+      offset += 8;
+    }
+
+    component.clear();
+    if (glyph >= glyph_count_ || !outline(glyph, &component, curve_steps, depth)) {
+      return false;
+    }
+
+    for (const auto& segment : component) {
+      segments->pushBack(OutlineSegment{
+          a * segment.x0 + c * segment.y0 + dx,
+          b * segment.x0 + d * segment.y0 + dy,
+          a * segment.x1 + c * segment.y1 + dx,
+          b * segment.x1 + d * segment.y1 + dy,
+      });
+    }
+  } while (flags & kMoreComponents);
+
+  return true;
+}
+
+U16 Font::read_u16(MemSize offset) const {
+  if (offset + 2 > data_.size()) {
+    return 0;
+  }
+  return static_cast<U16>((data_[offset] << 8) | data_[offset + 1]);
+}
+
+U32 Font::read_u32(MemSize offset) const {
+  if (offset + 4 > data_.size()) {
+    return 0;
+  }
+  return (static_cast<U32>(data_[offset]) << 24) | (static_cast<U32>(data_[offset + 1]) << 16) |
+         (static_cast<U32>(data_[offset + 2]) << 8) | static_cast<U32>(data_[offset + 3]);
+}
+
+}  // namespace ca
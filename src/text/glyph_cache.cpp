@@ -0,0 +1,161 @@
+#include "canvas/text/glyph_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "canvas/renderer/renderer.h"
+#include "canvas/text/font.h"
+
+namespace ca {
+
+namespace {
+
+// Empty border inside every cell, so linear filtering never reads a neighbouring glyph.
+constexpr I32 kCellMargin = 1;
+
+}  // namespace
+
+GlyphCache::GlyphCache(Renderer* renderer, const Font* font, const GlyphCacheSettings& settings)
+  : renderer_{renderer}, font_{font}, settings_{settings} {
+  const auto& metrics = font_->metrics();
+  if (!font_->is_loaded()) {
+    LOG(Error) << "Glyph cache created with a font that is not loaded.";
+    return;
+  }
+
+  const F32 scale = settings_.glyph_size / metrics.units_per_em;
+  ascender_ = metrics.ascender / metrics.units_per_em;
+  line_height_ = (metrics.ascender - metrics.descender + metrics.line_gap) / metrics.units_per_em;
+
+  // Cells fit the bounds of every glyph in the font, plus the spread on both sides.
+  cell_width_ = static_cast<I32>(std::ceil((metrics.x_max - metrics.x_min) * scale +
+                                           2.0f * settings_.spread)) +
+                2 * kCellMargin;
+  cell_height_ = static_cast<I32>(std::ceil((metrics.y_max - metrics.y_min) * scale +
+                                            2.0f * settings_.spread)) +
+                 2 * kCellMargin;
+  cell_width_ = std::min(std::max(cell_width_, 1), settings_.page_size);
+  cell_height_ = std::min(std::max(cell_height_, 1), settings_.page_size);
+
+  cells_per_row_ = settings_.page_size / cell_width_;
+  cells_per_page_ = static_cast<U32>(cells_per_row_ * (settings_.page_size / cell_height_));
+
+  MemSize page_bytes = static_cast<MemSize>(settings_.page_size) * settings_.page_size;
+  max_pages_ = std::max<MemSize>(settings_.texture_budget / page_bytes, 1);
+
+  cell_pixels_.resize(static_cast<MemSize>(cell_width_) * cell_height_);
+}
+
+GlyphCache::~GlyphCache() {
+  for (TextureId page : pages_) {
+    renderer_->delete_texture(page);
+  }
+}
+
+void GlyphCache::begin_frame() {
+  ++frame_;
+}
+
+const CachedGlyph* GlyphCache::glyph(U32 codepoint) {
+  if (!cells_per_page_) {
+    return nullptr;
+  }
+
+  // Code points are their own keys, so there is nothing else to compare.
+  U32 index = table_.find(codepoint, [](U32) { return true; });
+  if (index != LruTable::kInvalidEntry) {
+    ++statistics_.hits;
+    table_.touch(index, frame_);
+    return &slots_[index];
+  }
+
+  ++statistics_.misses;
+
+  index = acquire_slot();
+  if (index == LruTable::kInvalidEntry) {
+    ++statistics_.overflows;
+    return nullptr;
+  }
+
+  rasterize(&slots_[index], codepoint);
+  table_.insert(index, codepoint, frame_);
+  ++statistics_.glyph_count;
+
+  return &slots_[index];
+}
+
+U32 GlyphCache::acquire_slot() {
+  // Hand out the cells in order, adding pages while the budget allows.
+  if (slots_.size() < pages_.size() * cells_per_page_ ||
+      (pages_.size() < max_pages_ && add_page())) {
+    slots_.pushBack(CachedGlyph{{}, pages_[slots_.size() / cells_per_page_]});
+    return table_.add_entry();
+  }
+
+  U32 index = table_.evictable(frame_);
+  if (index == LruTable::kInvalidEntry) {
+    return index;
+  }
+
+  table_.remove(index);
+  --statistics_.glyph_count;
+  ++statistics_.evictions;
+
+  return table_.take_free_entry();
+}
+
+bool GlyphCache::add_page() {
+  TextureId texture =
+      renderer_->create_texture(TextureFormat::Alpha, {settings_.page_size, settings_.page_size},
+                                nullptr, 0, true);
+  if (!texture.is_valid()) {
+    LOG(Error) << "Could not create glyph cache page.";
+    max_pages_ = pages_.size();
+    return false;
+  }
+
+  pages_.pushBack(texture);
+  ++statistics_.page_count;
+  return true;
+}
+
+bool GlyphCache::measure(U32 codepoint, SdfGlyph* glyph) {
+  glyph->codepoint = codepoint;
+  if (!cells_per_page_ ||
+      !measure_sdf_glyph(*font_, font_->glyph_index(codepoint), settings_.glyph_size,
+                         settings_.spread, glyph, &segments_)) {
+    return false;
+  }
+
+  // Clip anything larger than the font's bounds said it could be.
+  glyph->width = static_cast<U16>(std::min<I32>(glyph->width, cell_width_ - 2 * kCellMargin));
+  glyph->height = static_cast<U16>(std::min<I32>(glyph->height, cell_height_ - 2 * kCellMargin));
+
+  return true;
+}
+
+void GlyphCache::rasterize(CachedGlyph* slot, U32 codepoint) {
+  U32 index = static_cast<U32>(slot - slots_.data());
+  U32 cell = index % cells_per_page_;
+  I32 cell_x = static_cast<I32>(cell % cells_per_row_) * cell_width_;
+  I32 cell_y = static_cast<I32>(cell / cells_per_row_) * cell_height_;
+
+  SdfGlyph& glyph = slot->glyph;
+  glyph.x = static_cast<U16>(cell_x + kCellMargin);
+  glyph.y = static_cast<U16>(cell_y + kCellMargin);
+
+  if (!measure(codepoint, &glyph)) {
+    return;
+  }
+
+  // Upload the whole cell, so the margin is cleared of whatever glyph was there before.
+  std::memset(cell_pixels_.data(), 0, cell_pixels_.size());
+  rasterize_sdf_glyph(*font_, glyph, segments_, settings_.glyph_size, settings_.spread,
+                      cell_pixels_.data() + kCellMargin * cell_width_ + kCellMargin, cell_width_);
+
+  renderer_->texture_sub_data(slot->texture, {cell_x, cell_y},
+                              {cell_width_, cell_height_}, cell_pixels_.data());
+}
+
+}  // namespace ca
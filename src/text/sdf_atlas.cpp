@@ -0,0 +1,330 @@
+#include "canvas/text/sdf_atlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "canvas/utils/hash.h"
+#include "nucleus/logging.h"
+
+namespace ca {
+
+namespace {
+
+constexpr U32 kCacheVersion = 1;
+
+// Pixels left empty between glyphs so that linear filtering doesn't bleed into neighbours.
+constexpr I32 kGlyphGap = 1;
+
+struct CacheHeader {
+  char magic[4];
+  U32 version;
+  U64 source_hash;
+  I32 width;
+  I32 height;
+  F32 glyph_size;
+  F32 spread;
+  F32 ascender;
+  F32 line_height;
+  U32 first_codepoint;
+  U32 glyph_count;
+};
+
+F32 distance_squared_to_segment(F32 px, F32 py, const OutlineSegment& segment) {
+  F32 dx = segment.x1 - segment.x0;
+  F32 dy = segment.y1 - segment.y0;
+  F32 length_squared = dx * dx + dy * dy;
+
+  F32 t = 0.0f;
+  if (length_squared > 0.0f) {
+    t = ((px - segment.x0) * dx + (py - segment.y0) * dy) / length_squared;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+  }
+
+  F32 ex = segment.x0 + dx * t - px;
+  F32 ey = segment.y0 + dy * t - py;
+  return ex * ex + ey * ey;
+}
+
+}  // namespace
+
+void generate_sdf(const OutlineSegment* segments, MemSize segment_count, F32 origin_x,
+                  F32 origin_y, F32 scale, F32 spread, U8* pixels, I32 width, I32 height,
+                  I32 stride) {
+  for (I32 y = 0; y < height; ++y) {
+    F32 py = origin_y - (static_cast<F32>(y) + 0.5f) / scale;
+    U8* row = pixels + static_cast<MemSize>(y) * stride;
+
+    for (I32 x = 0; x < width; ++x) {
+      F32 px = origin_x + (static_cast<F32>(x) + 0.5f) / scale;
+
+      F32 closest = std::numeric_limits<F32>::max();
+      I32 winding = 0;
+      for (MemSize i = 0; i < segment_count; ++i) {
+        const auto& segment = segments[i];
+        closest = std::min(closest, distance_squared_to_segment(px, py, segment));
+
+        // Count crossings of a ray towards +x.
+        if ((segment.y0 <= py) != (segment.y1 <= py)) {
+          F32 t = (py - segment.y0) / (segment.y1 - segment.y0);
+          if (segment.x0 + t * (segment.x1 - segment.x0) > px) {
+            winding += segment.y1 > segment.y0 ? 1 : -1;
+          }
+        }
+      }
+
+      F32 distance = std::sqrt(closest) * scale;
+      if (!winding) {
+        distance = -distance;
+      }
+
+      F32 value = 128.0f + distance / spread * 127.0f;
+      row[x] = static_cast<U8>(std::min(std::max(value, 0.0f), 255.0f));
+    }
+  }
+}
+
+bool measure_sdf_glyph(const Font& font, U32 glyph_index, F32 glyph_size, F32 spread,
+                       SdfGlyph* glyph, nu::DynamicArray<OutlineSegment>* segments) {
+  const auto& metrics = font.metrics();
+  const F32 scale = glyph_size / metrics.units_per_em;
+
+  glyph->width = 0;
+  glyph->height = 0;
+  glyph->left = 0.0f;
+  glyph->top = 0.0f;
+  glyph->advance = font.advance(glyph_index) / metrics.units_per_em;
+
+  segments->clear();
+  if (!font.glyph_outline(glyph_index, segments) || segments->empty()) {
+    return false;
+  }
+
+  F32 min_x = (*segments)[0].x0;
+  F32 max_x = min_x;
+  F32 min_y = (*segments)[0].y0;
+  F32 max_y = min_y;
+  for (const auto& segment : *segments) {
+    min_x = std::min(min_x, segment.x0);
+    max_x = std::max(max_x, segment.x0);
+    min_y = std::min(min_y, segment.y0);
+    max_y = std::max(max_y, segment.y0);
+  }
+
+  glyph->width = static_cast<U16>(std::ceil((max_x - min_x) * scale + 2.0f * spread));
+  glyph->height = static_cast<U16>(std::ceil((max_y - min_y) * scale + 2.0f * spread));
+  glyph->left = (min_x - spread / scale) / metrics.units_per_em;
+  glyph->top = (max_y + spread / scale) / metrics.units_per_em;
+
+  return true;
+}
+
+void rasterize_sdf_glyph(const Font& font, const SdfGlyph& glyph,
+                         const nu::DynamicArray<OutlineSegment>& segments, F32 glyph_size,
+                         F32 spread, U8* pixels, I32 stride) {
+  const F32 units_per_em = font.metrics().units_per_em;
+  generate_sdf(segments.data(), segments.size(), glyph.left * units_per_em,
+               glyph.top * units_per_em, glyph_size / units_per_em, spread, pixels, glyph.width,
+               glyph.height, stride);
+}
+
+bool SdfAtlas::build(const Font& font, const SdfAtlasSettings& settings) {
+  if (!font.is_loaded() || settings.last_codepoint < settings.first_codepoint ||
+      settings.glyph_size <= 0.0f || settings.spread <= 0.0f) {
+    LOG(Error) << "Invalid font or settings for SDF atlas.";
+    return false;
+  }
+
+  const auto& metrics = font.metrics();
+  const I32 atlas_width = static_cast<I32>(settings.atlas_width);
+
+  glyph_size_ = settings.glyph_size;
+  spread_ = settings.spread;
+  ascender_ = metrics.ascender / metrics.units_per_em;
+  line_height_ = (metrics.ascender - metrics.descender + metrics.line_gap) / metrics.units_per_em;
+  first_codepoint_ = settings.first_codepoint;
+  source_hash_ = hash_source(font, settings);
+
+  // Measure every glyph first, so the outlines can be rasterized straight into the atlas once
+  // they are packed.
+  U32 glyph_count = settings.last_codepoint - settings.first_codepoint + 1;
+  glyphs_.clear();
+  glyphs_.resize(glyph_count);
+
+  nu::DynamicArray<OutlineSegment> segments;
+  nu::DynamicArray<U32> order;
+  for (U32 i = 0; i < glyph_count; ++i) {
+    SdfGlyph& glyph = glyphs_[i];
+    glyph.codepoint = settings.first_codepoint + i;
+    glyph.x = 0;
+    glyph.y = 0;
+
+    if (!measure_sdf_glyph(font, font.glyph_index(glyph.codepoint), glyph_size_, spread_, &glyph,
+                           &segments)) {
+      continue;
+    }
+
+    if (glyph.width + kGlyphGap > atlas_width) {
+      LOG(Error) << "Glyph " << glyph.codepoint << " does not fit in an atlas " << atlas_width
+                 << " pixels wide.";
+      return false;
+    }
+
+    order.pushBack(i);
+  }
+
+  // Pack into shelves, tallest glyphs first.
+  std::sort(order.begin(), order.end(),
+            [this](U32 left, U32 right) { return glyphs_[left].height > glyphs_[right].height; });
+
+  I32 cursor_x = 0;
+  I32 shelf_y = 0;
+  I32 shelf_height = 0;
+  for (U32 index : order) {
+    SdfGlyph& glyph = glyphs_[index];
+    if (cursor_x + glyph.width + kGlyphGap > atlas_width) {
+      cursor_x = 0;
+      shelf_y += shelf_height;
+      shelf_height = 0;
+    }
+
+    glyph.x = static_cast<U16>(cursor_x);
+    glyph.y = static_cast<U16>(shelf_y);
+    cursor_x += glyph.width + kGlyphGap;
+    shelf_height = std::max(shelf_height, glyph.height + kGlyphGap);
+  }
+
+  // Textures are uploaded with tightly packed rows, so the atlas needs no padding.
+  size_ = fl::Size{atlas_width, std::max(shelf_y + shelf_height, 1)};
+  pixels_.clear();
+  pixels_.resize(static_cast<MemSize>(size_.width) * size_.height);
+  std::memset(pixels_.data(), 0, pixels_.size());
+
+  for (U32 index : order) {
+    SdfGlyph& glyph = glyphs_[index];
+
+    // Measuring again is cheaper than keeping every outline around.
+    measure_sdf_glyph(font, font.glyph_index(glyph.codepoint), glyph_size_, spread_, &glyph,
+                      &segments);
+    rasterize_sdf_glyph(font, glyph, segments, glyph_size_, spread_,
+                        pixels_.data() + static_cast<MemSize>(glyph.y) * size_.width + glyph.x,
+                        size_.width);
+  }
+
+  return true;
+}
+
+bool SdfAtlas::load_or_build(const Font& font, const SdfAtlasSettings& settings,
+                             const char* cache_path) {
+  if (load(cache_path) && source_hash_ == hash_source(font, settings)) {
+    return true;
+  }
+
+  if (!build(font, settings)) {
+    return false;
+  }
+
+  if (!save(cache_path)) {
+    LOG(Warning) << "Could not write SDF atlas cache: " << cache_path;
+  }
+
+  return true;
+}
+
+bool SdfAtlas::save(const char* path) const {
+  std::FILE* file = std::fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+
+  CacheHeader header{{'C', 'S', 'D', 'F'},
+                     kCacheVersion,
+                     source_hash_,
+                     size_.width,
+                     size_.height,
+                     glyph_size_,
+                     spread_,
+                     ascender_,
+                     line_height_,
+                     first_codepoint_,
+                     static_cast<U32>(glyphs_.size())};
+
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+            std::fwrite(glyphs_.data(), sizeof(SdfGlyph), glyphs_.size(), file) ==
+                glyphs_.size() &&
+            std::fwrite(pixels_.data(), 1, pixels_.size(), file) == pixels_.size();
+
+  return std::fclose(file) == 0 && ok;
+}
+
+bool SdfAtlas::load(const char* path) {
+  std::FILE* file = std::fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+
+  long file_size = -1;
+  if (std::fseek(file, 0, SEEK_END) == 0) {
+    file_size = std::ftell(file);
+    std::rewind(file);
+  }
+
+  CacheHeader header;
+  bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+            std::memcmp(header.magic, "CSDF", 4) == 0 && header.version == kCacheVersion &&
+            header.width > 0 && header.height > 0;
+
+  // Check the counts against the size of the file before allocating for them, so a corrupt
+  // header can not ask for more memory than the file could hold.
+  if (ok) {
+    U64 expected_size = sizeof(header) + static_cast<U64>(header.glyph_count) * sizeof(SdfGlyph) +
+                        static_cast<U64>(header.width) * static_cast<U64>(header.height);
+    ok = file_size >= 0 && static_cast<U64>(file_size) == expected_size;
+  }
+
+  if (ok) {
+    glyphs_.clear();
+    glyphs_.resize(header.glyph_count);
+    pixels_.clear();
+    pixels_.resize(static_cast<MemSize>(header.width) * header.height);
+
+    ok = std::fread(glyphs_.data(), sizeof(SdfGlyph), glyphs_.size(), file) == glyphs_.size() &&
+         std::fread(pixels_.data(), 1, pixels_.size(), file) == pixels_.size();
+  }
+
+  std::fclose(file);
+
+  if (!ok) {
+    glyphs_.clear();
+    pixels_.clear();
+    source_hash_ = 0;
+    return false;
+  }
+
+  source_hash_ = header.source_hash;
+  size_ = fl::Size{header.width, header.height};
+  glyph_size_ = header.glyph_size;
+  spread_ = header.spread;
+  ascender_ = header.ascender;
+  line_height_ = header.line_height;
+  first_codepoint_ = header.first_codepoint;
+
+  return true;
+}
+
+const SdfGlyph* SdfAtlas::glyph(U32 codepoint) const {
+  if (codepoint < first_codepoint_ || codepoint - first_codepoint_ >= glyphs_.size()) {
+    return nullptr;
+  }
+
+  return &glyphs_[codepoint - first_codepoint_];
+}
+
+U64 SdfAtlas::hash_source(const Font& font, const SdfAtlasSettings& settings) {
+  U64 hash = hash_bytes(font.data().data(), font.data().size());
+  return hash_bytes(&settings, sizeof(settings), hash);
+}
+
+}  // namespace ca
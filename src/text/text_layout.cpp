@@ -0,0 +1,171 @@
+#include "canvas/text/text_layout.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "canvas/text/utf8.h"
+#include "canvas/utils/hash.h"
+
+namespace ca {
+
+namespace {
+
+constexpr MemSize kNoBreak = ~MemSize{0};
+
+MemSize layout_bytes(const TextLayout& layout) {
+  return sizeof(TextLayout) + layout.glyphs.size() * sizeof(LayoutGlyph);
+}
+
+}  // namespace
+
+void layout_text(const LayoutFont& font, nu::StringView text, F32 size, F32 wrap_width,
+                 TextLayout* layout) {
+  auto& glyphs = layout->glyphs;
+  glyphs.clear();
+
+  const F32 line_height = font.line_height * size;
+
+  F32 pen_x = 0.0f;
+  F32 baseline = font.ascender * size;
+  F32 width = 0.0f;
+  U32 line_count = 1;
+
+  // Where the current line can be broken: the first glyph after the last space and the pen
+  // position before and after that space.
+  MemSize break_glyph = kNoBreak;
+  F32 break_line_width = 0.0f;
+  F32 break_x = 0.0f;
+
+  for (MemSize index = 0; index < text.length();) {
+    U32 codepoint = next_codepoint(text, &index);
+    if (codepoint == '\n') {
+      width = std::max(width, pen_x);
+      pen_x = 0.0f;
+      baseline += line_height;
+      ++line_count;
+      break_glyph = kNoBreak;
+      continue;
+    }
+
+    GlyphPlacement placement;
+    if (!font.placement(codepoint, &placement)) {
+      continue;
+    }
+
+    F32 advance = placement.advance * size;
+    if (wrap_width > 0.0f && codepoint != ' ' && pen_x + advance > wrap_width &&
+        break_glyph != kNoBreak) {
+      // Move everything after the break to the start of a new line.
+      for (MemSize i = break_glyph; i < glyphs.size(); ++i) {
+        glyphs[i].left -= break_x;
+        glyphs[i].right -= break_x;
+        glyphs[i].top += line_height;
+        glyphs[i].bottom += line_height;
+      }
+
+      width = std::max(width, break_line_width);
+      pen_x -= break_x;
+      baseline += line_height;
+      ++line_count;
+      break_glyph = kNoBreak;
+    }
+
+    if (placement.visible) {
+      F32 left = pen_x + placement.left * size;
+      F32 top = baseline - placement.top * size;
+      glyphs.pushBack(LayoutGlyph{codepoint, left, top, left + placement.width * size,
+                                  top + placement.height * size});
+    }
+
+    if (codepoint == ' ') {
+      break_glyph = glyphs.size();
+      break_line_width = pen_x;
+      break_x = pen_x + advance;
+    }
+
+    pen_x += advance;
+  }
+
+  layout->width = std::max(width, pen_x);
+  layout->height = static_cast<F32>(line_count) * line_height;
+}
+
+TextLayoutCache::TextLayoutCache(MemSize budget) : budget_{budget} {}
+
+void TextLayoutCache::set_budget(MemSize bytes) {
+  budget_ = bytes;
+  evict_to_budget();
+}
+
+void TextLayoutCache::begin_frame() {
+  ++frame_;
+}
+
+const TextLayout& TextLayoutCache::layout(const LayoutFont& font, nu::StringView text, F32 size,
+                                          F32 wrap_width) {
+  U64 key = hash_bytes(text.data(), text.length());
+  key = hash_bytes(&font.key, sizeof(font.key), key);
+  key = hash_bytes(&size, sizeof(size), key);
+  key = hash_bytes(&wrap_width, sizeof(wrap_width), key);
+
+  // Keys are only hashes, so what they were made from is compared too.
+  U32 index = table_.find(key, [&](U32 candidate) {
+    const Entry& entry = entries_[candidate];
+    return entry.font_key == font.key && entry.size == size && entry.wrap_width == wrap_width &&
+           entry.text.size() == text.length() &&
+           std::memcmp(entry.text.data(), text.data(), text.length()) == 0;
+  });
+  if (index != LruTable::kInvalidEntry) {
+    ++statistics_.hits;
+    table_.touch(index, frame_);
+    return entries_[index].layout;
+  }
+
+  ++statistics_.misses;
+
+  // Reuse an evicted entry, and the storage of its layout, if there is one.
+  index = table_.take_free_entry();
+  if (index == LruTable::kInvalidEntry) {
+    index = table_.add_entry();
+    entries_.emplaceBack();
+  }
+
+  Entry& entry = entries_[index];
+  layout_text(font, text, size, wrap_width, &entry.layout);
+  entry.font_key = font.key;
+  entry.size = size;
+  entry.wrap_width = wrap_width;
+  entry.text.resize(text.length());
+  std::memcpy(entry.text.data(), text.data(), text.length());
+  entry.bytes = layout_bytes(entry.layout) + text.length();
+  table_.insert(index, key, frame_);
+
+  statistics_.bytes += entry.bytes;
+  ++statistics_.entry_count;
+
+  evict_to_budget();
+
+  return entries_[index].layout;
+}
+
+void TextLayoutCache::evict_to_budget() {
+  while (statistics_.bytes > budget_) {
+    U32 index = table_.evictable(frame_);
+    if (index == LruTable::kInvalidEntry) {
+      break;
+    }
+
+    table_.remove(index);
+
+    Entry& entry = entries_[index];
+    statistics_.bytes -= entry.bytes;
+    --statistics_.entry_count;
+    ++statistics_.evictions;
+
+    entry.layout.glyphs.clear();
+    entry.text.clear();
+    entry.bytes = 0;
+  }
+}
+
+}  // namespace ca
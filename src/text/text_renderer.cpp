@@ -0,0 +1,247 @@
+#include "canvas/text/text_renderer.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "canvas/renderer/renderer.h"
+#include "canvas/text/glyph_cache.h"
+#include "canvas/text/sdf_atlas.h"
+
+namespace ca {
+
+namespace {
+
+const I8* kVertexShaderSource = R"(
+#version 330
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec4 inColor;
+
+uniform mat4 uTransform;
+
+out vec2 vTexCoord;
+out vec4 vColor;
+
+void main() {
+  gl_Position = uTransform * vec4(inPosition, 0.0, 1.0);
+  vTexCoord = inTexCoord;
+  vColor = inColor;
+}
+)";
+
+// The edge is where the distance crosses 0.5.  Smoothing over the screen space rate of change of
+// the distance keeps edges about a pixel wide at any scale.
+const I8* kFragmentShaderSource = R"(
+#version 330
+
+in vec2 vTexCoord;
+in vec4 vColor;
+
+uniform sampler2D uTexture;
+
+out vec4 final;
+
+void main() {
+  float distance = texture(uTexture, vTexCoord).r;
+  float width = max(fwidth(distance), 0.0001);
+  float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+  final = vec4(vColor.rgb, vColor.a * coverage);
+}
+)";
+
+}  // namespace
+
+TextRenderer::TextRenderer(Renderer* renderer) : renderer_{renderer} {}
+
+bool TextRenderer::initialize(const SdfAtlas* atlas) {
+  atlas_ = atlas;
+  glyph_size_ = atlas->glyph_size();
+  ascender_ = atlas->ascender();
+  line_height_ = atlas->line_height();
+  texture_size_ = atlas->size();
+
+  const auto& pixels = atlas_->pixels();
+  texture_id_ = renderer_->create_texture(TextureFormat::Alpha, atlas_->size(), pixels.data(),
+                                          pixels.size(), true);
+  if (!texture_id_.is_valid()) {
+    LOG(Error) << "Could not create atlas texture for text renderer.";
+    return false;
+  }
+
+  return create_resources();
+}
+
+bool TextRenderer::initialize(GlyphCache* glyph_cache) {
+  glyph_cache_ = glyph_cache;
+  glyph_size_ = glyph_cache->glyph_size();
+  ascender_ = glyph_cache->ascender();
+  line_height_ = glyph_cache->line_height();
+  texture_size_ = fl::Size{glyph_cache->page_size(), glyph_cache->page_size()};
+
+  return create_resources();
+}
+
+bool TextRenderer::create_resources() {
+  layout_font_.key = atlas_ ? atlas_->source_hash()
+                            : static_cast<U64>(reinterpret_cast<uintptr_t>(glyph_cache_));
+  layout_font_.ascender = ascender_;
+  layout_font_.line_height = line_height_;
+  layout_font_.placement = [this](U32 codepoint, GlyphPlacement* placement) {
+    return place_glyph(codepoint, placement);
+  };
+
+  VertexDefinition def;
+  def.addAttribute(ComponentType::Float32, ComponentCount::Two);
+  def.addAttribute(ComponentType::Float32, ComponentCount::Two);
+  def.addAttribute(ComponentType::Unsigned8, ComponentCount::Four, true);
+  vertex_buffer_id_ = renderer_->create_vertex_buffer(def, nullptr, 0);
+  if (!vertex_buffer_id_.is_valid()) {
+    LOG(Error) << "Could not create vertex buffer for text renderer.";
+    return false;
+  }
+
+  program_id_ = renderer_->create_program(ShaderSource::from(kVertexShaderSource),
+                                          ShaderSource::from(kFragmentShaderSource));
+  if (!program_id_.is_valid()) {
+    LOG(Error) << "Could not create program for text renderer.";
+    return false;
+  }
+
+  transform_uniform_id_ = renderer_->create_uniform("uTransform");
+
+  vertices_ = FrameArray<Vertex>{renderer_->frame_allocator()};
+  batches_ = FrameArray<Batch>{renderer_->frame_allocator()};
+
+  return true;
+}
+
+void TextRenderer::draw_text(const fl::Mat4& transform, const fl::Vec2& position, F32 size,
+                             nu::StringView text, const Color& color, F32 wrap_width) {
+  const TextLayout& text_layout = layout(text, size, wrap_width);
+
+  const U32 packed_color = pack_rgba8(color);
+  const F32 u_scale = 1.0f / static_cast<F32>(texture_size_.width);
+  const F32 v_scale = 1.0f / static_cast<F32>(texture_size_.height);
+
+  for (const LayoutGlyph& placed : text_layout.glyphs) {
+    // Layouts only keep positions; where the glyph is in a texture is looked up every time,
+    // because the glyph cache may have moved it since the text was laid out.
+    TextureId texture;
+    const SdfGlyph* glyph = find_glyph(placed.codepoint, &texture);
+    if (!glyph || !glyph->width || !glyph->height) {
+      continue;
+    }
+
+    F32 left = position.x + placed.left;
+    F32 top = position.y + placed.top;
+    F32 right = position.x + placed.right;
+    F32 bottom = position.y + placed.bottom;
+
+    F32 u0 = static_cast<F32>(glyph->x) * u_scale;
+    F32 v0 = static_cast<F32>(glyph->y) * v_scale;
+    F32 u1 = static_cast<F32>(glyph->x + glyph->width) * u_scale;
+    F32 v1 = static_cast<F32>(glyph->y + glyph->height) * v_scale;
+
+    vertices_.pushBack({left, top, u0, v0, packed_color});
+    vertices_.pushBack({right, top, u1, v0, packed_color});
+    vertices_.pushBack({right, bottom, u1, v1, packed_color});
+    vertices_.pushBack({left, top, u0, v0, packed_color});
+    vertices_.pushBack({right, bottom, u1, v1, packed_color});
+    vertices_.pushBack({left, bottom, u0, v1, packed_color});
+
+    batch_for(transform, texture).vertex_count += 6;
+  }
+}
+
+const TextLayout& TextRenderer::layout(nu::StringView text, F32 size, F32 wrap_width) {
+  if (layout_cache_) {
+    return layout_cache_->layout(layout_font_, text, size, wrap_width);
+  }
+
+  layout_text(layout_font_, text, size, wrap_width, &scratch_layout_);
+  return scratch_layout_;
+}
+
+void TextRenderer::render() {
+  if (!vertices_.empty()) {
+    renderer_->stream_vertex_buffer_data(vertex_buffer_id_, vertices_.data(),
+                                         vertices_.size() * sizeof(Vertex));
+
+    for (const auto& batch : batches_) {
+      if (!batch.vertex_count) {
+        continue;
+      }
+
+      UniformBuffer uniforms;
+      uniforms.set(transform_uniform_id_, batch.transform);
+
+      renderer_->draw(DrawType::Triangles, batch.first_vertex, batch.vertex_count, program_id_,
+                      vertex_buffer_id_, batch.texture, uniforms);
+    }
+  }
+
+  vertices_.clear();
+  batches_.clear();
+
+  if (glyph_cache_) {
+    glyph_cache_->begin_frame();
+  }
+}
+
+bool TextRenderer::place_glyph(U32 codepoint, GlyphPlacement* placement) const {
+  TextureId texture;
+  const SdfGlyph* glyph = find_glyph(codepoint, &texture);
+
+  // When every cell of the glyph cache is used in this frame, the glyph is measured without a
+  // cell.  Layouts may be cached, so they get the glyph either way; it is drawn once it has one.
+  SdfGlyph measured{};
+  if (!glyph && glyph_cache_) {
+    glyph_cache_->measure(codepoint, &measured);
+    glyph = &measured;
+  }
+
+  if (!glyph) {
+    return false;
+  }
+
+  const F32 texel_to_em = 1.0f / glyph_size_;
+  placement->advance = glyph->advance;
+  placement->left = glyph->left;
+  placement->top = glyph->top;
+  placement->width = static_cast<F32>(glyph->width) * texel_to_em;
+  placement->height = static_cast<F32>(glyph->height) * texel_to_em;
+  placement->visible = glyph->width && glyph->height;
+
+  return true;
+}
+
+const SdfGlyph* TextRenderer::find_glyph(U32 codepoint, TextureId* texture) const {
+  if (glyph_cache_) {
+    const CachedGlyph* cached = glyph_cache_->glyph(codepoint);
+    if (!cached) {
+      return nullptr;
+    }
+    *texture = cached->texture;
+    return &cached->glyph;
+  }
+
+  *texture = texture_id_;
+  const SdfGlyph* glyph = atlas_->glyph(codepoint);
+  return glyph ? glyph : atlas_->glyph('?');
+}
+
+TextRenderer::Batch& TextRenderer::batch_for(const fl::Mat4& transform, TextureId texture) {
+  // The glyph's vertices were just added, so a new batch starts 6 vertices back.
+  if (!batches_.empty()) {
+    Batch& last = batches_[batches_.size() - 1];
+    if (last.texture == texture &&
+        std::memcmp(&last.transform, &transform, sizeof(fl::Mat4)) == 0) {
+      return last;
+    }
+  }
+
+  return batches_.emplaceBack(transform, texture, static_cast<U32>(vertices_.size()) - 6, 0U);
+}
+
+}  // namespace ca
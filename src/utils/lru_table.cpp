@@ -0,0 +1,140 @@
+#include "canvas/utils/lru_table.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "nucleus/logging.h"
+
+namespace ca {
+
+U32 LruTable::add_entry() {
+  U32 index = static_cast<U32>(entries_.size());
+  entries_.pushBack(Entry{0, 0, kInvalidEntry, kInvalidEntry});
+  return index;
+}
+
+U32 LruTable::take_free_entry() {
+  if (free_entries_.empty()) {
+    return kInvalidEntry;
+  }
+
+  U32 index = free_entries_[free_entries_.size() - 1];
+  free_entries_.resize(free_entries_.size() - 1);
+  return index;
+}
+
+void LruTable::insert(U32 index, U64 key, U64 frame) {
+  if ((size_ + 1) * 2 > table_.size()) {
+    grow_table();
+  }
+
+  Entry& entry = entries_[index];
+  entry.key = key;
+  entry.last_used_frame = frame;
+  link_front(index);
+
+  MemSize mask = table_.size() - 1;
+  MemSize slot = hash_mix(key) & mask;
+  while (table_[slot] != kInvalidEntry) {
+    slot = (slot + 1) & mask;
+  }
+  table_[slot] = index;
+
+  ++size_;
+}
+
+void LruTable::touch(U32 index, U64 frame) {
+  entries_[index].last_used_frame = frame;
+  unlink(index);
+  link_front(index);
+}
+
+U32 LruTable::evictable(U64 frame) const {
+  if (least_recent_ == kInvalidEntry || entries_[least_recent_].last_used_frame == frame) {
+    return kInvalidEntry;
+  }
+  return least_recent_;
+}
+
+void LruTable::remove(U32 index) {
+  DCHECK(size_ > 0) << "Removing from an empty table.";
+
+  unlink(index);
+  remove_from_table(index);
+  free_entries_.pushBack(index);
+  --size_;
+}
+
+void LruTable::remove_from_table(U32 index) {
+  MemSize mask = table_.size() - 1;
+  MemSize slot = hash_mix(entries_[index].key) & mask;
+  while (table_[slot] != index) {
+    slot = (slot + 1) & mask;
+  }
+  table_[slot] = kInvalidEntry;
+
+  // Shift following entries of the probe sequence back, so lookups don't stop at the hole.
+  for (MemSize next = (slot + 1) & mask; table_[next] != kInvalidEntry;
+       next = (next + 1) & mask) {
+    MemSize home = hash_mix(entries_[table_[next]].key) & mask;
+    if (((next - home) & mask) >= ((next - slot) & mask)) {
+      table_[slot] = table_[next];
+      table_[next] = kInvalidEntry;
+      slot = next;
+    }
+  }
+}
+
+void LruTable::grow_table() {
+  nu::DynamicArray<U32> old_table = std::move(table_);
+
+  table_ = nu::DynamicArray<U32>{};
+  table_.resize(old_table.empty() ? 64 : old_table.size() * 2);
+  std::fill(table_.begin(), table_.end(), kInvalidEntry);
+
+  MemSize mask = table_.size() - 1;
+  for (U32 index : old_table) {
+    if (index == kInvalidEntry) {
+      continue;
+    }
+    MemSize slot = hash_mix(entries_[index].key) & mask;
+    while (table_[slot] != kInvalidEntry) {
+      slot = (slot + 1) & mask;
+    }
+    table_[slot] = index;
+  }
+}
+
+void LruTable::unlink(U32 index) {
+  Entry& entry = entries_[index];
+
+  if (entry.previous != kInvalidEntry) {
+    entries_[entry.previous].next = entry.next;
+  } else {
+    most_recent_ = entry.next;
+  }
+
+  if (entry.next != kInvalidEntry) {
+    entries_[entry.next].previous = entry.previous;
+  } else {
+    least_recent_ = entry.previous;
+  }
+
+  entry.previous = kInvalidEntry;
+  entry.next = kInvalidEntry;
+}
+
+void LruTable::link_front(U32 index) {
+  Entry& entry = entries_[index];
+  entry.previous = kInvalidEntry;
+  entry.next = most_recent_;
+
+  if (most_recent_ != kInvalidEntry) {
+    entries_[most_recent_].previous = index;
+  } else {
+    least_recent_ = index;
+  }
+  most_recent_ = index;
+}
+
+}  // namespace ca
@@ -0,0 +1,495 @@
+#include "canvas/utils/mesh_lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "canvas/renderer/renderer.h"
+#include "canvas/utils/hash.h"
+#include "mesh_upload.h"
+#include "nucleus/logging.h"
+
+namespace ca {
+
+namespace {
+
+constexpr U32 kInvalidIndex = ~0u;
+
+struct Position {
+  F32 x;
+  F32 y;
+  F32 z;
+};
+
+// Sum of squared distances to a set of planes, weighted by triangle area.
+struct Quadric {
+  F64 a00, a11, a22, a01, a02, a12;
+  F64 b0, b1, b2;
+  F64 c;
+  F64 weight;
+};
+
+struct Collapse {
+  U32 from;
+  U32 to;
+  F32 error;
+};
+
+Position cross(const Position& a, const Position& b) {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+Position subtract(const Position& a, const Position& b) {
+  return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+F32 dot(const Position& a, const Position& b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+void add_plane(Quadric* quadric, const Position& normal, F32 distance, F64 weight) {
+  F64 a = normal.x;
+  F64 b = normal.y;
+  F64 c = normal.z;
+  F64 d = distance;
+
+  quadric->a00 += a * a * weight;
+  quadric->a11 += b * b * weight;
+  quadric->a22 += c * c * weight;
+  quadric->a01 += a * b * weight;
+  quadric->a02 += a * c * weight;
+  quadric->a12 += b * c * weight;
+  quadric->b0 += a * d * weight;
+  quadric->b1 += b * d * weight;
+  quadric->b2 += c * d * weight;
+  quadric->c += d * d * weight;
+  quadric->weight += weight;
+}
+
+void add_quadric(Quadric* target, const Quadric& source) {
+  target->a00 += source.a00;
+  target->a11 += source.a11;
+  target->a22 += source.a22;
+  target->a01 += source.a01;
+  target->a02 += source.a02;
+  target->a12 += source.a12;
+  target->b0 += source.b0;
+  target->b1 += source.b1;
+  target->b2 += source.b2;
+  target->c += source.c;
+  target->weight += source.weight;
+}
+
+// RMS distance from `p` to the planes of both quadrics.
+F32 collapse_error(const Quadric& q1, const Quadric& q2, const Position& p) {
+  F64 weight = q1.weight + q2.weight;
+  if (weight <= 0.0) {
+    return 0.0f;
+  }
+
+  F64 x = p.x;
+  F64 y = p.y;
+  F64 z = p.z;
+
+  auto evaluate = [&](const Quadric& q) {
+    return q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+           2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+           2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+  };
+
+  F64 error = (evaluate(q1) + evaluate(q2)) / weight;
+  return static_cast<F32>(std::sqrt(std::max(error, 0.0)));
+}
+
+// Collapsing `from` onto `to` must not turn any of the remaining triangles around `from` over.
+bool collapse_flips(const U32* indices, const U32* adjacency, const U32* offsets,
+                    const Position* positions, U32 from, U32 to) {
+  for (U32 i = offsets[from]; i < offsets[from + 1]; ++i) {
+    const U32* triangle = indices + static_cast<MemSize>(adjacency[i]) * 3;
+    if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+      continue;
+    }
+
+    Position before[3];
+    Position after[3];
+    for (U32 corner = 0; corner < 3; ++corner) {
+      before[corner] = positions[triangle[corner]];
+      after[corner] = positions[triangle[corner] == from ? to : triangle[corner]];
+    }
+
+    Position normal_before =
+        cross(subtract(before[1], before[0]), subtract(before[2], before[0]));
+    Position normal_after = cross(subtract(after[1], after[0]), subtract(after[2], after[0]));
+    if (dot(normal_before, normal_after) <= 0.0f) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}  // namespace
+
+MemSize simplify_mesh(U32* destination, const U32* indices, MemSize index_count,
+                      const void* vertices, MemSize vertex_count, U32 vertex_size,
+                      MemSize target_index_count, F32 target_error, F32* result_error) {
+  auto* bytes = static_cast<const U8*>(vertices);
+
+  // Start from the non-degenerate triangles of the input.
+  MemSize count = 0;
+  for (MemSize i = 0; i + 2 < index_count; i += 3) {
+    U32 a = indices[i + 0];
+    U32 b = indices[i + 1];
+    U32 c = indices[i + 2];
+    if (a != b && b != c && c != a) {
+      destination[count++] = a;
+      destination[count++] = b;
+      destination[count++] = c;
+    }
+  }
+
+  nu::DynamicArray<Position> positions;
+  positions.resize(vertex_count);
+  for (MemSize i = 0; i < vertex_count; ++i) {
+    std::memcpy(&positions[i], bytes + i * vertex_size, sizeof(Position));
+  }
+
+  nu::DynamicArray<U8> locked;
+  locked.resize(vertex_count);
+  std::fill(locked.begin(), locked.end(), U8{0});
+
+  // Lock vertices that share their position with another vertex (attribute seams), otherwise
+  // collapsing one side of the seam would open a crack.
+  {
+    MemSize table_size = 16;
+    while (table_size < vertex_count * 2) {
+      table_size <<= 1;
+    }
+    MemSize mask = table_size - 1;
+
+    nu::DynamicArray<U32> table;
+    table.resize(table_size);
+    std::fill(table.begin(), table.end(), kInvalidIndex);
+
+    for (MemSize i = 0; i < vertex_count; ++i) {
+      MemSize bucket = hash_mix(hash_bytes(&positions[i], sizeof(Position))) & mask;
+      for (;;) {
+        U32 existing = table[bucket];
+        if (existing == kInvalidIndex) {
+          table[bucket] = static_cast<U32>(i);
+          break;
+        }
+        if (std::memcmp(&positions[existing], &positions[i], sizeof(Position)) == 0) {
+          locked[existing] = 1;
+          locked[i] = 1;
+          break;
+        }
+        bucket = (bucket + 1) & mask;
+      }
+    }
+  }
+
+  // Lock vertices on edges that are not shared by exactly two triangles.
+  {
+    nu::DynamicArray<U64> edges;
+    edges.resize(count);
+    for (MemSize i = 0; i < count; i += 3) {
+      for (U32 corner = 0; corner < 3; ++corner) {
+        U64 a = destination[i + corner];
+        U64 b = destination[i + (corner + 1) % 3];
+        edges[i + corner] = a < b ? (a << 32) | b : (b << 32) | a;
+      }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    for (MemSize i = 0; i < edges.size();) {
+      MemSize run = 1;
+      while (i + run < edges.size() && edges[i + run] == edges[i]) {
+        ++run;
+      }
+      if (run != 2) {
+        locked[static_cast<U32>(edges[i] >> 32)] = 1;
+        locked[static_cast<U32>(edges[i] & 0xffffffffu)] = 1;
+      }
+      i += run;
+    }
+  }
+
+  nu::DynamicArray<Quadric> quadrics;
+  quadrics.resize(vertex_count);
+  std::memset(quadrics.data(), 0, vertex_count * sizeof(Quadric));
+  for (MemSize i = 0; i < count; i += 3) {
+    const Position& p0 = positions[destination[i + 0]];
+    const Position& p1 = positions[destination[i + 1]];
+    const Position& p2 = positions[destination[i + 2]];
+
+    Position normal = cross(subtract(p1, p0), subtract(p2, p0));
+    F32 length = std::sqrt(dot(normal, normal));
+    if (length <= 0.0f) {
+      continue;
+    }
+    normal = {normal.x / length, normal.y / length, normal.z / length};
+    F32 distance = -dot(normal, p0);
+    F64 area = length * 0.5;
+
+    for (U32 corner = 0; corner < 3; ++corner) {
+      add_plane(&quadrics[destination[i + corner]], normal, distance, area);
+    }
+  }
+
+  nu::DynamicArray<U32> offsets;
+  offsets.resize(vertex_count + 1);
+  nu::DynamicArray<U32> adjacency;
+  nu::DynamicArray<U32> remap;
+  remap.resize(vertex_count);
+  nu::DynamicArray<U8> touched;
+  touched.resize(vertex_count);
+  nu::DynamicArray<Collapse> collapses;
+
+  F32 error = 0.0f;
+
+  while (count > target_index_count) {
+    // Vertex to triangle adjacency for the current triangles.
+    std::fill(offsets.begin(), offsets.end(), 0u);
+    for (MemSize i = 0; i < count; ++i) {
+      ++offsets[destination[i] + 1];
+    }
+    for (MemSize i = 0; i < vertex_count; ++i) {
+      offsets[i + 1] += offsets[i];
+    }
+    adjacency.resize(count);
+    {
+      nu::DynamicArray<U32> cursor;
+      cursor.resize(vertex_count);
+      std::copy(offsets.begin(), offsets.begin() + vertex_count, cursor.begin());
+      for (MemSize i = 0; i < count; ++i) {
+        adjacency[cursor[destination[i]]++] = static_cast<U32>(i / 3);
+      }
+    }
+
+    // Every interior edge shows up once as (a, b) with a < b.
+    collapses.clear();
+    for (MemSize i = 0; i < count; i += 3) {
+      for (U32 corner = 0; corner < 3; ++corner) {
+        U32 a = destination[i + corner];
+        U32 b = destination[i + (corner + 1) % 3];
+        if (a > b || (locked[a] && locked[b])) {
+          continue;
+        }
+
+        F32 a_to_b = locked[a] ? HUGE_VALF : collapse_error(quadrics[a], quadrics[b], positions[b]);
+        F32 b_to_a = locked[b] ? HUGE_VALF : collapse_error(quadrics[a], quadrics[b], positions[a]);
+        if (a_to_b <= b_to_a) {
+          collapses.pushBack({a, b, a_to_b});
+        } else {
+          collapses.pushBack({b, a, b_to_a});
+        }
+      }
+    }
+
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse& left, const Collapse& right) { return left.error < right.error; });
+
+    for (MemSize i = 0; i < vertex_count; ++i) {
+      remap[i] = static_cast<U32>(i);
+    }
+    std::fill(touched.begin(), touched.end(), U8{0});
+
+    MemSize removed = 0;
+    MemSize collapse_count = 0;
+    for (const auto& collapse : collapses) {
+      if (collapse.error > target_error) {
+        break;
+      }
+
+      if (touched[collapse.from] || touched[collapse.to]) {
+        continue;
+      }
+
+      if (collapse_flips(destination, adjacency.data(), offsets.data(), positions.data(),
+                         collapse.from, collapse.to)) {
+        continue;
+      }
+
+      // Triangles around `from` change shape, so their vertices can not collapse again until the
+      // next pass.
+      for (U32 j = offsets[collapse.from]; j < offsets[collapse.from + 1]; ++j) {
+        const U32* triangle = destination + static_cast<MemSize>(adjacency[j]) * 3;
+        if (triangle[0] == collapse.to || triangle[1] == collapse.to ||
+            triangle[2] == collapse.to) {
+          removed += 3;
+        }
+        touched[triangle[0]] = 1;
+        touched[triangle[1]] = 1;
+        touched[triangle[2]] = 1;
+      }
+
+      remap[collapse.from] = collapse.to;
+      add_quadric(&quadrics[collapse.to], quadrics[collapse.from]);
+      error = std::max(error, collapse.error);
+      ++collapse_count;
+
+      if (count - removed <= target_index_count) {
+        break;
+      }
+    }
+
+    if (collapse_count == 0) {
+      break;
+    }
+
+    MemSize write = 0;
+    for (MemSize i = 0; i < count; i += 3) {
+      U32 a = remap[destination[i + 0]];
+      U32 b = remap[destination[i + 1]];
+      U32 c = remap[destination[i + 2]];
+      if (a != b && b != c && c != a) {
+        destination[write++] = a;
+        destination[write++] = b;
+        destination[write++] = c;
+      }
+    }
+    count = write;
+  }
+
+  if (result_error) {
+    *result_error = error;
+  }
+
+  return count;
+}
+
+MeshLods generate_lods(const IndexedMesh& mesh, U32 lod_count, F32 reduction, F32 target_error) {
+  MeshLods result;
+
+  MemSize index_count = mesh.indices.size() - mesh.indices.size() % 3;
+  if (lod_count == 0 || index_count == 0) {
+    return result;
+  }
+
+  lod_count = std::min(lod_count, kMaxGeometryLods);
+
+  result.indices.resize(index_count);
+  std::memcpy(result.indices.data(), mesh.indices.data(), index_count * sizeof(U32));
+  result.levels.pushBack({0, static_cast<U32>(index_count), 0.0f});
+
+  nu::DynamicArray<U32> current;
+  current.resize(index_count);
+  std::memcpy(current.data(), mesh.indices.data(), index_count * sizeof(U32));
+
+  nu::DynamicArray<U32> simplified;
+  F32 accumulated_error = 0.0f;
+
+  for (U32 lod = 1; lod < lod_count; ++lod) {
+    MemSize current_count = current.size();
+    MemSize target = static_cast<MemSize>(static_cast<F32>(current_count / 3) * reduction) * 3;
+
+    simplified.resize(current_count);
+    F32 level_error = 0.0f;
+    MemSize simplified_count =
+        simplify_mesh(simplified.data(), current.data(), current_count, mesh.vertices.data(),
+                      mesh.vertex_count(), mesh.vertex_size, target, target_error, &level_error);
+
+    // Stop when the mesh is locked up by borders and seams; another level would cost memory
+    // without saving any vertex work.
+    if (simplified_count == 0 ||
+        static_cast<F32>(simplified_count) > static_cast<F32>(current_count) * 0.95f) {
+      break;
+    }
+
+    current.resize(simplified_count);
+    optimize_vertex_cache(current.data(), simplified.data(), simplified_count,
+                          mesh.vertex_count());
+
+    // Every level is simplified from the previous one, so the errors add up.
+    accumulated_error += level_error;
+
+    MemSize offset = result.indices.size();
+    result.indices.resize(offset + simplified_count);
+    std::memcpy(result.indices.data() + offset, current.data(), simplified_count * sizeof(U32));
+    result.levels.pushBack(
+        {static_cast<U32>(offset), static_cast<U32>(simplified_count), accumulated_error});
+  }
+
+  return result;
+}
+
+Geometry create_geometry(Renderer* renderer, const VertexDefinition& definition,
+                         const IndexedMesh& mesh, const MeshLods& lods) {
+  DCHECK(definition.getStride() == mesh.vertex_size) << "Vertex definition does not match mesh.";
+
+  if (lods.levels.empty()) {
+    return create_geometry(renderer, definition, mesh);
+  }
+
+  Geometry result;
+
+  result.vertex_buffer_id =
+      renderer->create_vertex_buffer(definition, mesh.vertices.data(), mesh.vertices.size());
+  if (!result.vertex_buffer_id.is_valid()) {
+    LOG(Error) << "Could not create vertex buffer.";
+    return {};
+  }
+
+  result.index_buffer_id =
+      upload_indices(renderer, lods.indices.data(), lods.indices.size(), mesh.vertex_count());
+  if (!result.index_buffer_id.is_valid()) {
+    LOG(Error) << "Could not create index buffer.";
+    renderer->delete_vertex_buffer(result.vertex_buffer_id);
+    return {};
+  }
+
+  result.lod_count = static_cast<U32>(std::min<MemSize>(lods.levels.size(), kMaxGeometryLods));
+  for (U32 i = 0; i < result.lod_count; ++i) {
+    result.lods[i] = lods.levels[i];
+  }
+  result.index_count = result.lods[0].index_count;
+
+  compute_bounding_sphere(mesh.vertices.data(), mesh.vertex_count(), mesh.vertex_size,
+                          &result.bounds_center, &result.bounds_radius);
+
+  return result;
+}
+
+U32 select_lod(const Geometry& geometry, const fl::Mat4& model_view, const fl::Mat4& projection,
+               const fl::Size& viewport, F32 pixel_error) {
+  if (geometry.lod_count <= 1 || geometry.bounds_radius <= 0.0f) {
+    return 0;
+  }
+
+  const fl::Vec4* c = model_view.col;
+  const fl::Vec3& center = geometry.bounds_center;
+
+  // The largest axis scale of the model view transform converts model space errors to view space.
+  F32 scale = 0.0f;
+  for (U32 i = 0; i < 3; ++i) {
+    scale = std::max(scale, std::sqrt(c[i].x * c[i].x + c[i].y * c[i].y + c[i].z * c[i].z));
+  }
+
+  F32 pixels_per_unit =
+      std::abs(projection.col[1].y) * static_cast<F32>(viewport.height) * 0.5f;
+
+  // A perspective projection copies -z into w; an orthographic one leaves w at 1.
+  if (projection.col[2].w != 0.0f) {
+    F32 x = c[0].x * center.x + c[1].x * center.y + c[2].x * center.z + c[3].x;
+    F32 y = c[0].y * center.x + c[1].y * center.y + c[2].y * center.z + c[3].y;
+    F32 z = c[0].z * center.x + c[1].z * center.y + c[2].z * center.z + c[3].z;
+
+    F32 distance = std::sqrt(x * x + y * y + z * z) - geometry.bounds_radius * scale;
+    if (distance <= 0.0f) {
+      // The camera is inside the bounds.
+      return 0;
+    }
+    pixels_per_unit /= distance;
+  }
+
+  for (U32 lod = geometry.lod_count - 1; lod > 0; --lod) {
+    if (geometry.lods[lod].error * scale * pixels_per_unit <= pixel_error) {
+      return lod;
+    }
+  }
+
+  return 0;
+}
+
+}  // namespace ca
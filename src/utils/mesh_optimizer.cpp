@@ -0,0 +1,624 @@
+#include "canvas/utils/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "canvas/renderer/renderer.h"
+#include "canvas/utils/hash.h"
+#include "mesh_upload.h"
+#include "nucleus/logging.h"
+
+namespace ca {
+
+namespace {
+
+constexpr U32 kInvalidIndex = ~0u;
+
+struct Position {
+  F32 x;
+  F32 y;
+  F32 z;
+};
+
+Position read_position(const U8* vertices, U32 vertex_size, U32 index) {
+  Position result;
+  std::memcpy(&result, vertices + static_cast<MemSize>(index) * vertex_size, sizeof(result));
+  return result;
+}
+
+MemSize next_power_of_two(MemSize value) {
+  MemSize result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+// Returns true when the vertex is not in the simulated FIFO cache and marks it as added.
+bool cache_miss(U32* cache_time, U32* timestamp, U32 vertex, U32 cache_size) {
+  if (*timestamp - cache_time[vertex] > cache_size) {
+    cache_time[vertex] = (*timestamp)++;
+    return true;
+  }
+  return false;
+}
+
+U32 skip_dead_end(const U32* live_triangles, const U32* dead_end, U32* dead_end_top,
+                  U32* input_cursor, MemSize vertex_count) {
+  // Prefer recently used vertices that still have triangles left.
+  while (*dead_end_top > 0) {
+    U32 vertex = dead_end[--(*dead_end_top)];
+    if (live_triangles[vertex] > 0) {
+      return vertex;
+    }
+  }
+
+  // Otherwise pick the next vertex in input order.
+  while (*input_cursor < vertex_count) {
+    if (live_triangles[*input_cursor] > 0) {
+      return *input_cursor;
+    }
+    ++(*input_cursor);
+  }
+
+  return kInvalidIndex;
+}
+
+}  // namespace
+
+MemSize generate_vertex_remap(U32* remap, const U32* indices, MemSize index_count,
+                              const void* vertices, MemSize vertex_count, U32 vertex_size) {
+  auto* bytes = static_cast<const U8*>(vertices);
+
+  for (MemSize i = 0; i < vertex_count; ++i) {
+    remap[i] = kInvalidIndex;
+  }
+
+  // Open addressing table of original vertex indices, keyed by the vertex bytes.
+  MemSize table_size = next_power_of_two(std::max<MemSize>(vertex_count * 2, 16));
+  MemSize mask = table_size - 1;
+  nu::DynamicArray<U32> table;
+  table.resize(table_size);
+  std::fill(table.begin(), table.end(), kInvalidIndex);
+
+  if (!indices) {
+    index_count = vertex_count;
+  }
+
+  U32 unique_count = 0;
+  for (MemSize i = 0; i < index_count; ++i) {
+    U32 vertex = indices ? indices[i] : static_cast<U32>(i);
+    DCHECK(vertex < vertex_count) << "Index out of range.";
+
+    if (remap[vertex] != kInvalidIndex) {
+      continue;
+    }
+
+    const U8* vertex_data = bytes + static_cast<MemSize>(vertex) * vertex_size;
+    MemSize bucket = hash_mix(hash_bytes(vertex_data, vertex_size)) & mask;
+
+    for (;;) {
+      U32 existing = table[bucket];
+      if (existing == kInvalidIndex) {
+        table[bucket] = vertex;
+        remap[vertex] = unique_count++;
+        break;
+      }
+
+      if (std::memcmp(bytes + static_cast<MemSize>(existing) * vertex_size, vertex_data,
+                      vertex_size) == 0) {
+        remap[vertex] = remap[existing];
+        break;
+      }
+
+      bucket = (bucket + 1) & mask;
+    }
+  }
+
+  return unique_count;
+}
+
+IndexedMesh deduplicate_vertices(const void* vertices, MemSize vertex_count, U32 vertex_size,
+                                 const U32* indices, MemSize index_count) {
+  auto* bytes = static_cast<const U8*>(vertices);
+
+  if (!indices) {
+    index_count = vertex_count;
+  }
+
+  nu::DynamicArray<U32> remap;
+  remap.resize(vertex_count);
+  MemSize unique_count = generate_vertex_remap(remap.data(), indices, index_count, vertices,
+                                               vertex_count, vertex_size);
+
+  IndexedMesh result;
+  result.vertex_size = vertex_size;
+
+  result.vertices.resize(unique_count * vertex_size);
+  for (MemSize i = 0; i < vertex_count; ++i) {
+    if (remap[i] != kInvalidIndex) {
+      std::memcpy(result.vertices.data() + static_cast<MemSize>(remap[i]) * vertex_size,
+                  bytes + i * vertex_size, vertex_size);
+    }
+  }
+
+  result.indices.resize(index_count);
+  for (MemSize i = 0; i < index_count; ++i) {
+    result.indices[i] = remap[indices ? indices[i] : i];
+  }
+
+  return result;
+}
+
+void optimize_vertex_cache(U32* destination, const U32* indices, MemSize index_count,
+                           MemSize vertex_count, U32 cache_size) {
+  DCHECK(destination != indices) << "Vertex cache optimization can not be done in place.";
+
+  MemSize triangle_count = index_count / 3;
+  if (triangle_count == 0 || vertex_count == 0) {
+    return;
+  }
+
+  // Build the vertex to triangle adjacency with a counting sort.
+  nu::DynamicArray<U32> live_triangles;
+  live_triangles.resize(vertex_count);
+  std::fill(live_triangles.begin(), live_triangles.end(), 0u);
+  for (MemSize i = 0; i < triangle_count * 3; ++i) {
+    ++live_triangles[indices[i]];
+  }
+
+  nu::DynamicArray<U32> offsets;
+  offsets.resize(vertex_count + 1);
+  offsets[0] = 0;
+  for (MemSize i = 0; i < vertex_count; ++i) {
+    offsets[i + 1] = offsets[i] + live_triangles[i];
+  }
+
+  nu::DynamicArray<U32> adjacency;
+  adjacency.resize(triangle_count * 3);
+  {
+    nu::DynamicArray<U32> cursor;
+    cursor.resize(vertex_count);
+    std::copy(offsets.begin(), offsets.begin() + vertex_count, cursor.begin());
+    for (MemSize i = 0; i < triangle_count * 3; ++i) {
+      adjacency[cursor[indices[i]]++] = static_cast<U32>(i / 3);
+    }
+  }
+
+  nu::DynamicArray<U32> cache_time;
+  cache_time.resize(vertex_count);
+  std::fill(cache_time.begin(), cache_time.end(), 0u);
+
+  nu::DynamicArray<U8> emitted;
+  emitted.resize(triangle_count);
+  std::fill(emitted.begin(), emitted.end(), U8{0});
+
+  // Every emitted vertex is pushed once, so the stack never exceeds the index count.
+  nu::DynamicArray<U32> dead_end;
+  dead_end.resize(triangle_count * 3);
+  U32 dead_end_top = 0;
+
+  U32 timestamp = cache_size + 1;
+  U32 input_cursor = 0;
+  MemSize output_count = 0;
+
+  U32 fanning_vertex = 0;
+  while (fanning_vertex != kInvalidIndex) {
+    U32 candidates_begin = dead_end_top;
+
+    // Emit all the remaining triangles around the fanning vertex.
+    for (U32 i = offsets[fanning_vertex]; i < offsets[fanning_vertex + 1]; ++i) {
+      U32 triangle = adjacency[i];
+      if (emitted[triangle]) {
+        continue;
+      }
+
+      for (U32 corner = 0; corner < 3; ++corner) {
+        U32 vertex = indices[triangle * 3 + corner];
+        destination[output_count++] = vertex;
+        dead_end[dead_end_top++] = vertex;
+        --live_triangles[vertex];
+        cache_miss(cache_time.data(), &timestamp, vertex, cache_size);
+      }
+
+      emitted[triangle] = 1;
+    }
+
+    // Pick the candidate that will still be in the cache after its remaining triangles are
+    // emitted, preferring the oldest one.  Fall back to dead-end recovery.
+    U32 best_vertex = kInvalidIndex;
+    I64 best_priority = -1;
+    for (U32 i = candidates_begin; i < dead_end_top; ++i) {
+      U32 vertex = dead_end[i];
+      if (live_triangles[vertex] == 0) {
+        continue;
+      }
+
+      I64 priority = 0;
+      I64 age = static_cast<I64>(timestamp) - cache_time[vertex];
+      if (age + 2 * static_cast<I64>(live_triangles[vertex]) <= cache_size) {
+        priority = age;
+      }
+
+      if (priority > best_priority) {
+        best_priority = priority;
+        best_vertex = vertex;
+      }
+    }
+
+    if (best_vertex == kInvalidIndex) {
+      best_vertex = skip_dead_end(live_triangles.data(), dead_end.data(), &dead_end_top,
+                                  &input_cursor, vertex_count);
+    }
+
+    fanning_vertex = best_vertex;
+  }
+
+  DCHECK(output_count == triangle_count * 3);
+}
+
+void optimize_overdraw(U32* destination, const U32* indices, MemSize index_count,
+                       const void* vertices, MemSize vertex_count, U32 vertex_size,
+                       F32 threshold, U32 cache_size) {
+  DCHECK(destination != indices) << "Overdraw optimization can not be done in place.";
+
+  auto* bytes = static_cast<const U8*>(vertices);
+  MemSize triangle_count = index_count / 3;
+  if (triangle_count == 0) {
+    return;
+  }
+
+  nu::DynamicArray<U32> cache_time;
+  cache_time.resize(vertex_count);
+  std::fill(cache_time.begin(), cache_time.end(), 0u);
+  U32 timestamp = cache_size + 1;
+
+  auto triangle_misses = [&](MemSize triangle) {
+    U32 misses = 0;
+    for (U32 corner = 0; corner < 3; ++corner) {
+      misses += cache_miss(cache_time.data(), &timestamp, indices[triangle * 3 + corner],
+                           cache_size);
+    }
+    return misses;
+  };
+
+  // Hard boundaries are where the cache optimizer restarted: every vertex of the triangle missed.
+  nu::DynamicArray<U32> hard_clusters;
+  for (MemSize triangle = 0; triangle < triangle_count; ++triangle) {
+    if (triangle_misses(triangle) == 3) {
+      hard_clusters.pushBack(static_cast<U32>(triangle));
+    }
+  }
+  if (hard_clusters.empty() || hard_clusters[0] != 0) {
+    hard_clusters.pushBack(0);
+    std::sort(hard_clusters.begin(), hard_clusters.end());
+  }
+  hard_clusters.pushBack(static_cast<U32>(triangle_count));
+
+  // Split hard clusters further wherever the cluster so far, starting with a cold cache, is
+  // already within the threshold of the hard cluster's ACMR.
+  nu::DynamicArray<U32> clusters;
+  for (MemSize c = 0; c + 1 < hard_clusters.size(); ++c) {
+    U32 begin = hard_clusters[c];
+    U32 end = hard_clusters[c + 1];
+
+    timestamp += cache_size + 1;
+    U32 cluster_misses = 0;
+    for (U32 triangle = begin; triangle < end; ++triangle) {
+      cluster_misses += triangle_misses(triangle);
+    }
+    F32 target_acmr = static_cast<F32>(cluster_misses) / static_cast<F32>(end - begin) * threshold;
+
+    clusters.pushBack(begin);
+    timestamp += cache_size + 1;
+    U32 running_misses = 0;
+    U32 running_triangles = 0;
+    for (U32 triangle = begin; triangle < end; ++triangle) {
+      running_misses += triangle_misses(triangle);
+      ++running_triangles;
+
+      if (triangle + 1 < end &&
+          static_cast<F32>(running_misses) <= target_acmr * static_cast<F32>(running_triangles)) {
+        clusters.pushBack(triangle + 1);
+        timestamp += cache_size + 1;
+        running_misses = 0;
+        running_triangles = 0;
+      }
+    }
+  }
+  clusters.pushBack(static_cast<U32>(triangle_count));
+
+  MemSize cluster_count = clusters.size() - 1;
+
+  // Area weighted centroid and normal of every cluster.
+  struct ClusterInfo {
+    Position centroid;
+    Position normal;
+    F32 area;
+    F32 sort_key;
+  };
+
+  nu::DynamicArray<ClusterInfo> infos;
+  infos.resize(cluster_count);
+
+  Position mesh_centroid{0.0f, 0.0f, 0.0f};
+  F32 mesh_area = 0.0f;
+
+  for (MemSize c = 0; c < cluster_count; ++c) {
+    ClusterInfo& info = infos[c];
+    info = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, 0.0f, 0.0f};
+
+    for (U32 triangle = clusters[c]; triangle < clusters[c + 1]; ++triangle) {
+      Position p0 = read_position(bytes, vertex_size, indices[triangle * 3 + 0]);
+      Position p1 = read_position(bytes, vertex_size, indices[triangle * 3 + 1]);
+      Position p2 = read_position(bytes, vertex_size, indices[triangle * 3 + 2]);
+
+      Position e1{p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+      Position e2{p2.x - p0.x, p2.y - p0.y, p2.z - p0.z};
+      Position n{e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z,
+                 e1.x * e2.y - e1.y * e2.x};
+      F32 area = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+
+      info.centroid.x += (p0.x + p1.x + p2.x) * (area / 3.0f);
+      info.centroid.y += (p0.y + p1.y + p2.y) * (area / 3.0f);
+      info.centroid.z += (p0.z + p1.z + p2.z) * (area / 3.0f);
+      info.normal.x += n.x;
+      info.normal.y += n.y;
+      info.normal.z += n.z;
+      info.area += area;
+    }
+
+    mesh_centroid.x += info.centroid.x;
+    mesh_centroid.y += info.centroid.y;
+    mesh_centroid.z += info.centroid.z;
+    mesh_area += info.area;
+
+    if (info.area > 0.0f) {
+      info.centroid.x /= info.area;
+      info.centroid.y /= info.area;
+      info.centroid.z /= info.area;
+    }
+  }
+
+  if (mesh_area > 0.0f) {
+    mesh_centroid.x /= mesh_area;
+    mesh_centroid.y /= mesh_area;
+    mesh_centroid.z /= mesh_area;
+  }
+
+  // Clusters that face away from the center are more likely to occlude the rest of the mesh.
+  for (auto& info : infos) {
+    F32 length = std::sqrt(info.normal.x * info.normal.x + info.normal.y * info.normal.y +
+                           info.normal.z * info.normal.z);
+    if (length > 0.0f) {
+      info.sort_key = ((info.centroid.x - mesh_centroid.x) * info.normal.x +
+                       (info.centroid.y - mesh_centroid.y) * info.normal.y +
+                       (info.centroid.z - mesh_centroid.z) * info.normal.z) /
+                      length;
+    }
+  }
+
+  nu::DynamicArray<U32> order;
+  order.resize(cluster_count);
+  for (MemSize c = 0; c < cluster_count; ++c) {
+    order[c] = static_cast<U32>(c);
+  }
+  std::stable_sort(order.begin(), order.end(), [&](U32 left, U32 right) {
+    return infos[left].sort_key > infos[right].sort_key;
+  });
+
+  MemSize output_count = 0;
+  for (U32 c : order) {
+    MemSize begin = static_cast<MemSize>(clusters[c]) * 3;
+    MemSize end = static_cast<MemSize>(clusters[c + 1]) * 3;
+    std::memcpy(destination + output_count, indices + begin, (end - begin) * sizeof(U32));
+    output_count += end - begin;
+  }
+}
+
+MemSize optimize_vertex_fetch(void* destination, U32* indices, MemSize index_count,
+                              const void* vertices, MemSize vertex_count, U32 vertex_size) {
+  DCHECK(destination != vertices) << "Vertex fetch optimization can not be done in place.";
+
+  auto* source = static_cast<const U8*>(vertices);
+  auto* target = static_cast<U8*>(destination);
+
+  nu::DynamicArray<U32> remap;
+  remap.resize(vertex_count);
+  std::fill(remap.begin(), remap.end(), kInvalidIndex);
+
+  U32 next_vertex = 0;
+  for (MemSize i = 0; i < index_count; ++i) {
+    U32 vertex = indices[i];
+    if (remap[vertex] == kInvalidIndex) {
+      std::memcpy(target + static_cast<MemSize>(next_vertex) * vertex_size,
+                  source + static_cast<MemSize>(vertex) * vertex_size, vertex_size);
+      remap[vertex] = next_vertex++;
+    }
+    indices[i] = remap[vertex];
+  }
+
+  return next_vertex;
+}
+
+VertexCacheStatistics analyze_vertex_cache(const U32* indices, MemSize index_count,
+                                           MemSize vertex_count, U32 cache_size) {
+  VertexCacheStatistics result;
+
+  MemSize triangle_count = index_count / 3;
+  if (triangle_count == 0 || vertex_count == 0) {
+    return result;
+  }
+
+  nu::DynamicArray<U32> cache_time;
+  cache_time.resize(vertex_count);
+  std::fill(cache_time.begin(), cache_time.end(), 0u);
+
+  nu::DynamicArray<U8> referenced;
+  referenced.resize(vertex_count);
+  std::fill(referenced.begin(), referenced.end(), U8{0});
+
+  U32 timestamp = cache_size + 1;
+  U32 unique_count = 0;
+
+  for (MemSize i = 0; i < triangle_count * 3; ++i) {
+    U32 vertex = indices[i];
+
+    if (cache_miss(cache_time.data(), &timestamp, vertex, cache_size)) {
+      ++result.vertices_transformed;
+    }
+
+    if (!referenced[vertex]) {
+      referenced[vertex] = 1;
+      ++unique_count;
+    }
+  }
+
+  result.acmr =
+      static_cast<F32>(result.vertices_transformed) / static_cast<F32>(triangle_count);
+  result.atvr = static_cast<F32>(result.vertices_transformed) / static_cast<F32>(unique_count);
+
+  return result;
+}
+
+ComponentType select_index_type(MemSize vertex_count) {
+  // Keep 0xffff free, some drivers treat it as the primitive restart index.
+  return vertex_count < 0xffff ? ComponentType::Unsigned16 : ComponentType::Unsigned32;
+}
+
+IndexedMesh optimize_mesh(const void* vertices, MemSize vertex_count, U32 vertex_size,
+                          const U32* indices, MemSize index_count,
+                          MeshOptimizationReport* report) {
+  IndexedMesh mesh =
+      deduplicate_vertices(vertices, vertex_count, vertex_size, indices, index_count);
+
+  if (report) {
+    report->vertex_count_before = vertex_count;
+
+    if (indices) {
+      report->before = analyze_vertex_cache(indices, index_count, vertex_count);
+    } else {
+      nu::DynamicArray<U32> sequential;
+      sequential.resize(vertex_count);
+      for (MemSize i = 0; i < vertex_count; ++i) {
+        sequential[i] = static_cast<U32>(i);
+      }
+      report->before = analyze_vertex_cache(sequential.data(), vertex_count, vertex_count);
+    }
+
+    // Measure against the unique vertices so that the before and after ratios are comparable.
+    if (mesh.vertex_count() > 0) {
+      report->before.atvr = static_cast<F32>(report->before.vertices_transformed) /
+                            static_cast<F32>(mesh.vertex_count());
+    }
+  }
+
+  MemSize mesh_index_count = mesh.indices.size() - mesh.indices.size() % 3;
+
+  nu::DynamicArray<U32> cache_optimized;
+  cache_optimized.resize(mesh_index_count);
+  optimize_vertex_cache(cache_optimized.data(), mesh.indices.data(), mesh_index_count,
+                        mesh.vertex_count());
+
+  mesh.indices.resize(mesh_index_count);
+  optimize_overdraw(mesh.indices.data(), cache_optimized.data(), mesh_index_count,
+                    mesh.vertices.data(), mesh.vertex_count(), vertex_size);
+
+  nu::DynamicArray<U8> fetch_optimized;
+  fetch_optimized.resize(mesh.vertices.size());
+  MemSize used_vertex_count =
+      optimize_vertex_fetch(fetch_optimized.data(), mesh.indices.data(), mesh_index_count,
+                            mesh.vertices.data(), mesh.vertex_count(), vertex_size);
+  fetch_optimized.resize(used_vertex_count * vertex_size);
+  mesh.vertices = std::move(fetch_optimized);
+
+  if (report) {
+    report->vertex_count_after = mesh.vertex_count();
+    report->after =
+        analyze_vertex_cache(mesh.indices.data(), mesh_index_count, mesh.vertex_count());
+    report->index_type = select_index_type(mesh.vertex_count());
+  }
+
+  return mesh;
+}
+
+void compute_bounding_sphere(const void* vertices, MemSize vertex_count, U32 vertex_size,
+                             fl::Vec3* center, F32* radius) {
+  auto* bytes = static_cast<const U8*>(vertices);
+
+  if (vertex_count == 0) {
+    *center = fl::Vec3::zero;
+    *radius = 0.0f;
+    return;
+  }
+
+  Position min = read_position(bytes, vertex_size, 0);
+  Position max = min;
+  for (MemSize i = 1; i < vertex_count; ++i) {
+    Position p = read_position(bytes, vertex_size, static_cast<U32>(i));
+    min = {std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z)};
+    max = {std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z)};
+  }
+
+  Position middle{(min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f};
+
+  F32 max_distance_squared = 0.0f;
+  for (MemSize i = 0; i < vertex_count; ++i) {
+    Position p = read_position(bytes, vertex_size, static_cast<U32>(i));
+    F32 dx = p.x - middle.x;
+    F32 dy = p.y - middle.y;
+    F32 dz = p.z - middle.z;
+    max_distance_squared = std::max(max_distance_squared, dx * dx + dy * dy + dz * dz);
+  }
+
+  *center = fl::Vec3{middle.x, middle.y, middle.z};
+  *radius = std::sqrt(max_distance_squared);
+}
+
+IndexBufferId upload_indices(Renderer* renderer, const U32* indices, MemSize index_count,
+                             MemSize vertex_count) {
+  if (select_index_type(vertex_count) == ComponentType::Unsigned32) {
+    return renderer->create_index_buffer(ComponentType::Unsigned32, indices,
+                                         index_count * sizeof(U32));
+  }
+
+  nu::DynamicArray<U16> narrow;
+  narrow.resize(index_count);
+  for (MemSize i = 0; i < index_count; ++i) {
+    narrow[i] = static_cast<U16>(indices[i]);
+  }
+  return renderer->create_index_buffer(ComponentType::Unsigned16, narrow.data(),
+                                       narrow.size() * sizeof(U16));
+}
+
+Geometry create_geometry(Renderer* renderer, const VertexDefinition& definition,
+                         const IndexedMesh& mesh) {
+  DCHECK(definition.getStride() == mesh.vertex_size) << "Vertex definition does not match mesh.";
+
+  Geometry result;
+
+  result.vertex_buffer_id =
+      renderer->create_vertex_buffer(definition, mesh.vertices.data(), mesh.vertices.size());
+  if (!result.vertex_buffer_id.is_valid()) {
+    LOG(Error) << "Could not create vertex buffer.";
+    return {};
+  }
+
+  result.index_buffer_id =
+      upload_indices(renderer, mesh.indices.data(), mesh.indices.size(), mesh.vertex_count());
+  if (!result.index_buffer_id.is_valid()) {
+    LOG(Error) << "Could not create index buffer.";
+    renderer->delete_vertex_buffer(result.vertex_buffer_id);
+    return {};
+  }
+
+  result.index_count = static_cast<U32>(mesh.indices.size());
+  compute_bounding_sphere(mesh.vertices.data(), mesh.vertex_count(), mesh.vertex_size,
+                          &result.bounds_center, &result.bounds_radius);
+
+  return result;
+}
+
+}  // namespace ca
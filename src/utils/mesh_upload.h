@@ -0,0 +1,20 @@
+#pragma once
+
+#include "canvas/renderer/types.h"
+#include "floats/vec3.h"
+
+// Helpers shared by `create_geometry` in mesh_optimizer.cpp and mesh_lod.cpp.
+
+namespace ca {
+
+class Renderer;
+
+// Bounding sphere around the positions of all vertices, centered on their bounding box.
+void compute_bounding_sphere(const void* vertices, MemSize vertex_count, U32 vertex_size,
+                             fl::Vec3* center, F32* radius);
+
+// Upload indices as 16-bit when `vertex_count` allows it, otherwise as 32-bit.
+IndexBufferId upload_indices(Renderer* renderer, const U32* indices, MemSize index_count,
+                             MemSize vertex_count);
+
+}  // namespace ca
@@ -0,0 +1,184 @@
+#include "canvas/utils/simd_math.h"
+
+#include "canvas/utils/simd.h"
+
+namespace ca {
+
+namespace {
+
+#if CANVAS_SSE
+
+struct Columns {
+  __m128 c[4];
+};
+
+Columns load(const fl::Mat4& m) {
+  const F32* data = &m.col[0].x;
+  return Columns{{_mm_loadu_ps(data), _mm_loadu_ps(data + 4), _mm_loadu_ps(data + 8),
+                  _mm_loadu_ps(data + 12)}};
+}
+
+// Each column of the result is a combination of the columns of `a` weighted by the
+// corresponding column of `b`.
+void multiply(const Columns& a, const fl::Mat4& b, fl::Mat4* result) {
+  const F32* source = &b.col[0].x;
+  __m128 columns[4];
+  for (MemSize i = 0; i < 4; ++i) {
+    const F32* column = source + i * 4;
+    __m128 value = _mm_mul_ps(a.c[0], _mm_set1_ps(column[0]));
+    value = _mm_add_ps(value, _mm_mul_ps(a.c[1], _mm_set1_ps(column[1])));
+    value = _mm_add_ps(value, _mm_mul_ps(a.c[2], _mm_set1_ps(column[2])));
+    value = _mm_add_ps(value, _mm_mul_ps(a.c[3], _mm_set1_ps(column[3])));
+    columns[i] = value;
+  }
+
+  F32* destination = &result->col[0].x;
+  for (MemSize i = 0; i < 4; ++i) {
+    _mm_storeu_ps(destination + i * 4, columns[i]);
+  }
+}
+
+#else
+
+void multiply(const fl::Mat4& a, const fl::Mat4& b, fl::Mat4* result) {
+  const F32* lhs = &a.col[0].x;
+  const F32* rhs = &b.col[0].x;
+  F32 values[16];
+  for (MemSize column = 0; column < 4; ++column) {
+    for (MemSize row = 0; row < 4; ++row) {
+      values[column * 4 + row] =
+          lhs[0 * 4 + row] * rhs[column * 4 + 0] + lhs[1 * 4 + row] * rhs[column * 4 + 1] +
+          lhs[2 * 4 + row] * rhs[column * 4 + 2] + lhs[3 * 4 + row] * rhs[column * 4 + 3];
+    }
+  }
+
+  F32* destination = &result->col[0].x;
+  for (MemSize i = 0; i < 16; ++i) {
+    destination[i] = values[i];
+  }
+}
+
+#endif
+
+}  // namespace
+
+void multiply_mat4(const fl::Mat4& a, const fl::Mat4& b, fl::Mat4* result) {
+#if CANVAS_SSE
+  multiply(load(a), b, result);
+#else
+  multiply(a, b, result);
+#endif
+}
+
+void multiply_mat4_batch(const fl::Mat4& parent, const fl::Mat4* local, MemSize count,
+                         fl::Mat4* result) {
+#if CANVAS_SSE
+  // Keep the shared matrix in registers for the whole batch.
+  Columns columns = load(parent);
+  for (MemSize i = 0; i < count; ++i) {
+    multiply(columns, local[i], &result[i]);
+  }
+#else
+  for (MemSize i = 0; i < count; ++i) {
+    multiply(parent, local[i], &result[i]);
+  }
+#endif
+}
+
+void transform_points(const fl::Mat4& matrix, const void* source, MemSize source_stride,
+                      void* destination, MemSize destination_stride, MemSize count) {
+  const F32* m = &matrix.col[0].x;
+  auto* in = static_cast<const U8*>(source);
+  auto* out = static_cast<U8*>(destination);
+
+  auto point = [&](MemSize i) { return reinterpret_cast<const F32*>(in + i * source_stride); };
+  auto result = [&](MemSize i) { return reinterpret_cast<F32*>(out + i * destination_stride); };
+
+  MemSize i = 0;
+
+#if CANVAS_AVX
+  {
+    __m256 m00 = _mm256_set1_ps(m[0]), m01 = _mm256_set1_ps(m[1]), m02 = _mm256_set1_ps(m[2]),
+           m03 = _mm256_set1_ps(m[3]);
+    __m256 m10 = _mm256_set1_ps(m[4]), m11 = _mm256_set1_ps(m[5]), m12 = _mm256_set1_ps(m[6]),
+           m13 = _mm256_set1_ps(m[7]);
+    __m256 m20 = _mm256_set1_ps(m[8]), m21 = _mm256_set1_ps(m[9]), m22 = _mm256_set1_ps(m[10]),
+           m23 = _mm256_set1_ps(m[11]);
+    __m256 m30 = _mm256_set1_ps(m[12]), m31 = _mm256_set1_ps(m[13]),
+           m32 = _mm256_set1_ps(m[14]), m33 = _mm256_set1_ps(m[15]);
+
+    for (; i + 8 <= count; i += 8) {
+      const F32* p[8];
+      for (MemSize j = 0; j < 8; ++j) {
+        p[j] = point(i + j);
+      }
+      __m256 x = _mm256_set_ps(p[7][0], p[6][0], p[5][0], p[4][0], p[3][0], p[2][0], p[1][0],
+                               p[0][0]);
+      __m256 y = _mm256_set_ps(p[7][1], p[6][1], p[5][1], p[4][1], p[3][1], p[2][1], p[1][1],
+                               p[0][1]);
+      __m256 z = _mm256_set_ps(p[7][2], p[6][2], p[5][2], p[4][2], p[3][2], p[2][2], p[1][2],
+                               p[0][2]);
+
+      // Result component k is `m[k] * x + m[4 + k] * y + m[8 + k] * z + m[12 + k]`.
+      __m256 rx = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m10, y)),
+          _mm256_add_ps(_mm256_mul_ps(m20, z), m30));
+      __m256 ry = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(m01, x), _mm256_mul_ps(m11, y)),
+          _mm256_add_ps(_mm256_mul_ps(m21, z), m31));
+      __m256 rz = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(m02, x), _mm256_mul_ps(m12, y)),
+          _mm256_add_ps(_mm256_mul_ps(m22, z), m32));
+      __m256 rw = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(m03, x), _mm256_mul_ps(m13, y)),
+          _mm256_add_ps(_mm256_mul_ps(m23, z), m33));
+
+      // Transpose each half back into one vector per point.
+      for (MemSize half = 0; half < 2; ++half) {
+        __m128 hx = half ? _mm256_extractf128_ps(rx, 1) : _mm256_castps256_ps128(rx);
+        __m128 hy = half ? _mm256_extractf128_ps(ry, 1) : _mm256_castps256_ps128(ry);
+        __m128 hz = half ? _mm256_extractf128_ps(rz, 1) : _mm256_castps256_ps128(rz);
+        __m128 hw = half ? _mm256_extractf128_ps(rw, 1) : _mm256_castps256_ps128(rw);
+        _MM_TRANSPOSE4_PS(hx, hy, hz, hw);
+        _mm_storeu_ps(result(i + half * 4 + 0), hx);
+        _mm_storeu_ps(result(i + half * 4 + 1), hy);
+        _mm_storeu_ps(result(i + half * 4 + 2), hz);
+        _mm_storeu_ps(result(i + half * 4 + 3), hw);
+      }
+    }
+  }
+#endif
+
+#if CANVAS_SSE
+  {
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+
+    // Four points per iteration; each result is a combination of the matrix columns, so it comes
+    // out as a full vector without a transpose.
+    for (; i + 4 <= count; i += 4) {
+      for (MemSize j = 0; j < 4; ++j) {
+        const F32* p = point(i + j);
+        __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])),
+                                             _mm_mul_ps(c1, _mm_set1_ps(p[1]))),
+                                  _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p[2])), c3));
+        _mm_storeu_ps(result(i + j), value);
+      }
+    }
+  }
+#endif
+
+  for (; i < count; ++i) {
+    const F32* p = point(i);
+    F32* r = result(i);
+    F32 x = p[0], y = p[1], z = p[2];
+    r[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+    r[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+    r[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+    r[3] = m[3] * x + m[7] * y + m[11] * z + m[15];
+  }
+}
+
+}  // namespace ca
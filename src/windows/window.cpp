@@ -1,6 +1,7 @@
 
 #include "canvas/windows/window.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "canvas/opengl.h"
@@ -279,6 +280,7 @@ bool Window::initialize(WindowDelegate* delegate) {
   DCHECK(delegate) << "Can't create a window with no delegate.";
 
   m_delegate = delegate;
+  m_delegate->window_ = this;
 
   // Initialize GLFW.
   if (!glfwInit()) {
@@ -325,6 +327,7 @@ bool Window::initialize(WindowDelegate* delegate) {
   glfwSetMouseButtonCallback(m_window, mouseButtonCallback);
   glfwSetScrollCallback(m_window, scrollCallback);
   glfwSetKeyCallback(m_window, keyCallback);
+  glfwSetWindowRefreshCallback(m_window, refreshCallback);
 
   // Make the new window the current context.
   glfwMakeContextCurrent(m_window);
@@ -363,6 +366,21 @@ bool Window::initialize(WindowDelegate* delegate) {
 }
 
 Window::~Window() {
+  if (m_frameStats.frameCount()) {
+    auto summary = m_frameStats.summary();
+    LOG(Info) << "Frame times over the last " << summary.frameCount
+              << " frames: p50 " << summary.presentInterval.p50 << " ms, p99 "
+              << summary.presentInterval.p99 << " ms, max " << summary.presentInterval.max
+              << " ms, " << summary.hitchCount << " hitches.";
+  }
+
+  if (m_renderThread.is_running()) {
+    stopRenderThread();
+  }
+
+  // The renderer's own GL objects have to go while the context is still current.
+  m_renderer.release_resources();
+
   glfwDestroyWindow(m_window);
 
   glfwTerminate();
@@ -376,6 +394,61 @@ bool Window::processEvents() {
   return !glfwWindowShouldClose(m_window);
 }
 
+bool Window::waitEvents(F64 timeoutSeconds) {
+  if (timeoutSeconds > 0.0) {
+    glfwWaitEventsTimeout(timeoutSeconds);
+  } else {
+    glfwWaitEvents();
+  }
+
+  return !glfwWindowShouldClose(m_window);
+}
+
+void Window::wakeUp() {
+  glfwPostEmptyEvent();
+}
+
+bool Window::isFocused() const {
+  return glfwGetWindowAttrib(m_window, GLFW_FOCUSED) != 0;
+}
+
+bool Window::isIconified() const {
+  return glfwGetWindowAttrib(m_window, GLFW_ICONIFIED) != 0;
+}
+
+void Window::invalidate() {
+  {
+    std::lock_guard<std::mutex> lock{m_dirtyLock};
+    m_dirtyAll = true;
+    m_needsPaint.store(true, std::memory_order_release);
+  }
+
+  wakeUp();
+}
+
+void Window::invalidate(const WindowRect& rect) {
+  if (rect.size.width <= 0 || rect.size.height <= 0) {
+    return;
+  }
+
+  fl::Pos rectMax{rect.position.x + rect.size.width, rect.position.y + rect.size.height};
+
+  {
+    std::lock_guard<std::mutex> lock{m_dirtyLock};
+    if (m_needsPaint.load(std::memory_order_relaxed)) {
+      m_dirtyMin = {std::min(m_dirtyMin.x, rect.position.x),
+                    std::min(m_dirtyMin.y, rect.position.y)};
+      m_dirtyMax = {std::max(m_dirtyMax.x, rectMax.x), std::max(m_dirtyMax.y, rectMax.y)};
+    } else {
+      m_dirtyMin = rect.position;
+      m_dirtyMax = rectMax;
+    }
+    m_needsPaint.store(true, std::memory_order_release);
+  }
+
+  wakeUp();
+}
+
 void Window::activateContext() {
   glfwMakeContextCurrent(m_window);
 }
@@ -385,30 +458,145 @@ void Window::tick(F32 delta) {
 }
 
 void Window::paint() {
-  nu::Timer timer;
+  // With a render thread, this waits while it is as many frames behind as it may be.
+  FramePacket* packet = m_renderThread.is_running() ? m_renderThread.acquire_packet() : nullptr;
 
-  m_renderer.begin_frame();
-
-  PROFILE("frame")
+  auto frameStart = nu::getTimeInMicroseconds();
 
+  // Take what was invalidated, so anything invalidated from here on needs another paint.
   {
-    PROFILE("delegate paint")
-    m_delegate->on_render(&m_renderer);
+    std::lock_guard<std::mutex> lock{m_dirtyLock};
+
+    if (m_dirtyAll || !m_needsPaint.load(std::memory_order_relaxed)) {
+      m_paintRect = {{0, 0}, m_clientSize};
+    } else {
+      fl::Pos min{std::max(m_dirtyMin.x, 0), std::max(m_dirtyMin.y, 0)};
+      fl::Pos max{std::min(m_dirtyMax.x, m_clientSize.width),
+                  std::min(m_dirtyMax.y, m_clientSize.height)};
+      m_paintRect = {min, {std::max(max.x - min.x, 0), std::max(max.y - min.y, 0)}};
+    }
+
+    m_dirtyAll = false;
+    m_needsPaint.store(false, std::memory_order_release);
   }
 
-  {
-    PROFILE("debug interface render")
-    m_debugInterface.render(m_lastFPS);
+  // The profiler overlay changes every frame, wherever the damage is.
+  if (isProfilerVisible()) {
+    m_paintRect = {{0, 0}, m_clientSize};
   }
 
-  nu::detail::getCurrentProfileMetrics()->reset();
+  if (packet) {
+    packet->set_gpu_profiling(isProfilerVisible());
+    m_renderer.begin_recording(packet);
+  }
+
+  m_renderer.begin_frame(m_paintRect.position, m_paintRect.size);
+
+  {
+    PROFILE("frame")
+    GpuProfileScope gpuFrame{&m_renderer, "frame"};
+
+    {
+      PROFILE("delegate paint")
+      GpuProfileScope gpuScope{&m_renderer, "delegate paint"};
+      m_delegate->on_render(&m_renderer);
+    }
+
+    {
+      PROFILE("debug interface render")
+      GpuProfileScope gpuScope{&m_renderer, "debug interface render"};
+      m_debugInterface.render(m_frameStats);
+    }
+  }
 
   m_renderer.end_frame();
 
-  // Swap buffers.
+  auto frameEnd = nu::getTimeInMicroseconds();
+
+  // GPU times are only measured while the profiler is enabled and arrive a few frames late.  A
+  // render thread hands them back with the packets it executed.
+  const auto& gpuTimings = packet ? packet->gpu_timings() : m_renderer.gpu_profiler()->timings();
+  F64 gpuMilliseconds = -1.0;
+  const U64 gpuFrameKey = profile_scope_key(kHashSeed, "frame");
+  for (const auto& timing : gpuTimings) {
+    if (timing.key == gpuFrameKey) {
+      gpuMilliseconds = timing.milliseconds;
+      break;
+    }
+  }
+
+  // The frame's blocks are all closed now, so they can be added to the histories.
+  auto* profileMetrics = nu::detail::getCurrentProfileMetrics();
+  m_debugInterface.recordProfile(profileMetrics->root(), gpuTimings);
+
+  if (packet) {
+    // The render thread swaps buffers once it executed the frame.
+    m_renderer.end_recording();
+    m_renderThread.submit(packet);
+  } else {
+    glfwSwapBuffers(m_window);
+  }
+
+  auto presentTime = nu::getTimeInMicroseconds();
+
+  FrameTiming frameTiming{(frameEnd - frameStart) / 1000.0, gpuMilliseconds,
+                          m_lastPresentTime > 0.0 ? (presentTime - m_lastPresentTime) / 1000.0
+                                                  : (presentTime - frameStart) / 1000.0,
+                          m_idleTime / 1000.0};
+  m_lastPresentTime = presentTime;
+  m_idleTime = 0.0;
+
+  m_frameStats.addFrame(frameTiming, profileMetrics->root());
+  profileMetrics->reset();
+}
+
+void Window::setProfilerVisible(bool visible) {
+  m_debugInterface.setProfilerVisible(visible);
+
+  // A render thread switches profiling with every packet.
+  if (!m_renderThread.is_running()) {
+    m_renderer.gpu_profiler()->set_enabled(visible);
+  }
+}
+
+void Window::setThreadedRendering(bool enabled, U32 latency) {
+  if (m_renderThread.is_running()) {
+    if (enabled && latency == m_renderThread.latency()) {
+      return;
+    }
+    stopRenderThread();
+  }
+
+  if (!enabled) {
+    return;
+  }
+
+  // The context belongs to the render thread for as long as it runs.
+  releaseContext();
+
+  m_renderThread.set_latency(latency);
+  m_renderThread.start();
+  m_renderer.set_render_thread(&m_renderThread);
+}
+
+void Window::stopRenderThread() {
+  m_renderThread.stop();
+  m_renderer.set_render_thread(nullptr);
+
+  activateContext();
+  m_renderer.gpu_profiler()->set_enabled(isProfilerVisible());
+}
+
+void Window::renderPacket(FramePacket* packet) {
+  m_renderer.execute(*packet);
+
   glfwSwapBuffers(m_window);
 
-  m_lastFPS = 1000000.0 / timer.elapsed();
+  packet->set_gpu_timings(m_renderer.gpu_profiler()->timings());
+}
+
+void Window::releaseContext() {
+  glfwMakeContextCurrent(nullptr);
 }
 
 // static
@@ -416,6 +604,7 @@ void Window::frameBufferSizeCallback(GLFWwindow* window, int width, int height)
   Window* windowPtr = getUserPointer(window);
 
   windowPtr->m_clientSize = {width, height};
+  windowPtr->invalidate();
 
   // Resize our renderer.
   windowPtr->m_renderer.resize(windowPtr->m_clientSize);
@@ -497,6 +686,11 @@ void Window::keyCallback(GLFWwindow* window, int key, int NU_UNUSED(scancode), i
 
   Window* windowPtr = getUserPointer(window);
 
+  if (action == GLFW_PRESS && key == GLFW_KEY_F3) {
+    windowPtr->setProfilerVisible(!windowPtr->isProfilerVisible());
+    windowPtr->invalidate();
+  }
+
   if (action == GLFW_PRESS) {
     KeyEvent evt{Event::KeyPressed, getKeyFromGLFWKey(key)};
     windowPtr->m_delegate->on_key_pressed(evt);
@@ -506,4 +700,10 @@ void Window::keyCallback(GLFWwindow* window, int key, int NU_UNUSED(scancode), i
   }
 }
 
+// static
+void Window::refreshCallback(GLFWwindow* window) {
+  // The contents were damaged, by being uncovered for example.
+  getUserPointer(window)->invalidate();
+}
+
 }  // namespace ca
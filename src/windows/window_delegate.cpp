@@ -1,9 +1,9 @@
 
 #include "canvas/windows/window_delegate.h"
 
-namespace ca {
+#include "canvas/windows/window.h"
 
-class Window;
+namespace ca {
 
 bool WindowDelegate::on_window_created(Window* window) {
   return true;
@@ -13,6 +13,18 @@ void WindowDelegate::on_tick(F32 delta) {}
 
 void WindowDelegate::on_window_resized(const fl::Size& size) {}
 
+void WindowDelegate::invalidate() {
+  if (window_) {
+    window_->invalidate();
+  }
+}
+
+void WindowDelegate::invalidate(const WindowRect& rect) {
+  if (window_) {
+    window_->invalidate(rect);
+  }
+}
+
 void WindowDelegate::on_mouse_moved(const MouseEvent& evt) {
   for (auto handler : mouse_input_handlers_) {
     handler->on_mouse_moved(evt);
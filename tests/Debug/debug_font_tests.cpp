@@ -0,0 +1,98 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/debug/debug_font.h"
+#include "canvas/renderer/frame_packet.h"
+#include "canvas/static_data/all.h"
+#include "stub_renderer.h"
+
+namespace ca {
+
+namespace {
+
+struct Vertex {
+  F32 x;
+  F32 y;
+  F32 u;
+  F32 v;
+};
+
+const Vertex* streamed_vertices(const FramePacket& packet, MemSize* count) {
+  for (const Command& command : packet.commands()) {
+    if (command.type == CommandType::StreamVertexBufferData) {
+      const UploadCommand& upload = packet.upload(command.index);
+      *count = upload.data.size / sizeof(Vertex);
+      return reinterpret_cast<const Vertex*>(packet.data(upload.data));
+    }
+  }
+  *count = 0;
+  return nullptr;
+}
+
+}  // namespace
+
+TEST_CASE("debug font emits a quad for every visible glyph") {
+  StubRenderer stub;
+  DebugFont font{stub.renderer()};
+  REQUIRE(font.initialize());
+
+  FramePacket packet;
+  stub.renderer()->begin_recording(&packet);
+  // The space takes up a cell but has no quad.
+  font.drawText(fl::Mat4::identity, {10, 20}, "A B");
+  font.render();
+  stub.renderer()->end_recording();
+
+  MemSize count = 0;
+  const Vertex* vertices = streamed_vertices(packet, &count);
+  REQUIRE(count == 12);
+
+  // Two triangles covering an 8 x 16 cell from the position.
+  CHECK(vertices[0].x == 10.0f);
+  CHECK(vertices[0].y == 20.0f);
+  CHECK(vertices[2].x == 18.0f);
+  CHECK(vertices[2].y == 36.0f);
+  CHECK(vertices[5].x == 10.0f);
+  CHECK(vertices[5].y == 36.0f);
+
+  // 'A' is the second glyph of the second row of the sheet.
+  CHECK(vertices[0].u == Approx(8.0f / kMonoFontWidth));
+  CHECK(vertices[0].v == Approx(16.0f / kMonoFontHeight));
+  CHECK(vertices[2].u == Approx(16.0f / kMonoFontWidth));
+  CHECK(vertices[2].v == Approx(32.0f / kMonoFontHeight));
+
+  // 'B' is two cells further along.
+  CHECK(vertices[6].x == 26.0f);
+  CHECK(vertices[6].u == Approx(16.0f / kMonoFontWidth));
+}
+
+TEST_CASE("debug font draws text with the same transform at once") {
+  StubRenderer stub;
+  DebugFont font{stub.renderer()};
+  REQUIRE(font.initialize());
+
+  fl::Mat4 moved = fl::Mat4::identity;
+  moved.col[3].x = 5.0f;
+
+  FramePacket packet;
+  stub.renderer()->begin_recording(&packet);
+  font.drawText(fl::Mat4::identity, {0, 0}, "AB");
+  font.drawText(fl::Mat4::identity, {0, 16}, "C");
+  font.drawText(moved, {0, 0}, "DE");
+  font.render();
+  stub.renderer()->end_recording();
+
+  nu::DynamicArray<const DrawCommand*> draws;
+  for (const Command& command : packet.commands()) {
+    if (command.type == CommandType::Draw) {
+      draws.pushBack(&packet.draw(command.index));
+    }
+  }
+
+  REQUIRE(draws.size() == 2);
+  CHECK(draws[0]->first == 0);
+  CHECK(draws[0]->count == 18);
+  CHECK(draws[1]->first == 18);
+  CHECK(draws[1]->count == 12);
+}
+
+}  // namespace ca
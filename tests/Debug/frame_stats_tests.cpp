@@ -0,0 +1,57 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/debug/frame_stats.h"
+
+namespace ca {
+
+TEST_CASE("frame time percentiles") {
+  FrameStats stats{50.0};
+
+  // 1..100 ms, with no GPU time.
+  for (U32 i = 1; i <= 100; ++i) {
+    stats.addFrame({static_cast<F64>(i) / 10.0, -1.0, static_cast<F64>(i) / 10.0}, nullptr);
+  }
+
+  auto summary = stats.summary();
+  CHECK(summary.frameCount == 100);
+  CHECK(summary.cpu.p50 == Approx(5.0));
+  CHECK(summary.cpu.p95 == Approx(9.5));
+  CHECK(summary.cpu.p99 == Approx(9.9));
+  CHECK(summary.cpu.max == Approx(10.0));
+  CHECK(summary.gpu.max == 0.0);
+  CHECK(summary.hitchCount == 0);
+}
+
+TEST_CASE("frame history keeps the most recent frames") {
+  FrameStats stats;
+
+  for (U32 i = 0; i < FrameStats::kHistorySize + 10; ++i) {
+    stats.addFrame({static_cast<F64>(i), 1.0, 16.0}, nullptr);
+  }
+
+  CHECK(stats.frameCount() == FrameStats::kHistorySize);
+  CHECK(stats.frame(0).cpuMilliseconds == 10.0);
+  CHECK(stats.frame(FrameStats::kHistorySize - 1).cpuMilliseconds ==
+        static_cast<F64>(FrameStats::kHistorySize + 9));
+}
+
+TEST_CASE("slow frames are hitches") {
+  FrameStats stats{20.0};
+
+  CHECK_FALSE(stats.addFrame({5.0, -1.0, 16.7}, nullptr));
+  CHECK(stats.addFrame({5.0, -1.0, 40.0}, nullptr));
+  CHECK(stats.addFrame({25.0, -1.0, 16.7}, nullptr));
+
+  REQUIRE(stats.hitches().size() == 2);
+  CHECK(stats.hitches()[0].frame == 2);
+  CHECK(stats.hitches()[1].timing.cpuMilliseconds == 25.0);
+  CHECK(stats.summary().hitchCount == 2);
+
+  for (U32 i = 0; i < FrameStats::kMaxHitches + 5; ++i) {
+    stats.addFrame({100.0, -1.0, 100.0}, nullptr);
+  }
+  CHECK(stats.hitches().size() == FrameStats::kMaxHitches);
+  CHECK(stats.summary().hitchCount == FrameStats::kMaxHitches + 7);
+}
+
+}  // namespace ca
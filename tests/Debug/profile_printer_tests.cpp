@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include <string>
+
+#include "canvas/debug/profile_printer.h"
+
+namespace ca {
+
+namespace {
+
+using Block = nu::detail::ProfileMetrics::Block;
+
+Block block(const char* name, F64 milliseconds, Block* children = nullptr) {
+  Block result{};
+  result.name.append(name);
+  // Blocks are timed in microseconds.
+  result.startTime = 0.0;
+  result.stopTime = milliseconds * 1000.0;
+  result.next = nullptr;
+  result.children = children;
+  return result;
+}
+
+std::string line(const ProfilePrinter& printer, MemSize index) {
+  auto view = printer.lines()[index].view();
+  return std::string{view.data(), view.length()};
+}
+
+}  // namespace
+
+TEST_CASE("profile printer keeps the last frames of every block") {
+  ProfilePrinter printer{nullptr};
+  nu::DynamicArray<GpuScopeTiming> noGpuTimings;
+
+  // The table is refreshed every 30 frames.
+  for (U32 frame = 1; frame <= 30; ++frame) {
+    Block root = block("frame", static_cast<F64>(frame));
+    printer.record(&root, noGpuTimings);
+  }
+
+  REQUIRE(printer.lines().size() == 2);
+  CHECK(line(printer, 1).find("frame") == 0);
+  CHECK(line(printer, 1).find("   15.50    1.00   30.00") != std::string::npos);
+
+  // Once more frames than the history holds were added, the first ones are gone.
+  for (U32 frame = 31; frame <= 90; ++frame) {
+    Block root = block("frame", 100.0);
+    printer.record(&root, noGpuTimings);
+  }
+
+  REQUIRE(printer.lines().size() == 2);
+  CHECK(line(printer, 1).find("  100.00  100.00  100.00") != std::string::npos);
+}
+
+TEST_CASE("profile printer indents children and adds gpu times") {
+  ProfilePrinter printer{nullptr};
+
+  Block child = block("draw", 2.0);
+  Block root = block("frame", 4.0, &child);
+
+  nu::DynamicArray<GpuScopeTiming> gpuTimings;
+  U64 frameKey = profile_scope_key(kHashSeed, "frame");
+  gpuTimings.pushBack(GpuScopeTiming{profile_scope_key(frameKey, "draw"), 1, 2.5});
+
+  // The first frame is printed right away.
+  printer.record(&root, gpuTimings);
+
+  REQUIRE(printer.lines().size() == 3);
+  CHECK(line(printer, 0).find("block (ms)") == 0);
+  CHECK(line(printer, 1).find("frame") == 0);
+  CHECK(line(printer, 1).find("    4.00    4.00    4.00") != std::string::npos);
+  CHECK(line(printer, 1).find("2.50") == std::string::npos);
+  CHECK(line(printer, 2).find("  draw") == 0);
+  CHECK(line(printer, 2).find("    2.00    2.00    2.00    2.50") != std::string::npos);
+}
+
+TEST_CASE("profile printer forgets blocks that stopped running") {
+  ProfilePrinter printer{nullptr};
+  nu::DynamicArray<GpuScopeTiming> noGpuTimings;
+
+  {
+    Block child = block("loading", 50.0);
+    Block root = block("frame", 1.0, &child);
+    printer.record(&root, noGpuTimings);
+  }
+
+  // More frames than the history holds without the block.
+  for (U32 frame = 2; frame <= ProfilePrinter::kHistoryFrames + 2; ++frame) {
+    Block root = block("frame", 1.0);
+    printer.record(&root, noGpuTimings);
+  }
+
+  // When it runs again, its history starts over.
+  for (U32 frame = ProfilePrinter::kHistoryFrames + 3; frame <= 90; ++frame) {
+    Block child = block("loading", 1.0);
+    Block root = block("frame", 1.0, &child);
+    printer.record(&root, noGpuTimings);
+  }
+
+  REQUIRE(printer.lines().size() == 3);
+  CHECK(line(printer, 2).find("  loading") == 0);
+  CHECK(line(printer, 2).find("    1.00    1.00    1.00") != std::string::npos);
+}
+
+}  // namespace ca
@@ -0,0 +1,83 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/renderer/frame_allocator.h"
+
+namespace ca {
+
+TEST_CASE("frame allocator hands out aligned memory and tracks usage") {
+  FrameAllocator allocator{1024};
+
+  auto* a = allocator.allocate(3, 1);
+  auto* b = allocator.allocate(16, 16);
+  CHECK(a != nullptr);
+  CHECK(reinterpret_cast<MemSize>(b) % 16 == 0);
+  CHECK(allocator.used() >= 19);
+
+  allocator.reset();
+  CHECK(allocator.used() == 0);
+  CHECK(allocator.high_water_mark() >= 19);
+  CHECK(allocator.overflow_frames() == 0);
+}
+
+TEST_CASE("frame allocator falls back to the heap and grows") {
+  FrameAllocator allocator{256};
+
+  for (U32 i = 0; i < 8; ++i) {
+    auto* data = static_cast<U8*>(allocator.allocate(100));
+    REQUIRE(data != nullptr);
+    data[99] = 1;
+  }
+  CHECK(allocator.overflow_frames() == 1);
+  CHECK(allocator.high_water_mark() >= 800);
+
+  // The arena that overflowed grows the next time it is used.
+  allocator.reset();
+  allocator.reset();
+  CHECK(allocator.capacity() >= 800);
+}
+
+TEST_CASE("frame array grows within the allocator") {
+  FrameAllocator allocator{64 * 1024};
+  FrameArray<U32> values{&allocator};
+
+  for (U32 i = 0; i < 1000; ++i) {
+    values.pushBack(i);
+  }
+
+  REQUIRE(values.size() == 1000);
+  CHECK(values[0] == 0);
+  CHECK(values[999] == 999);
+
+  FrameArray<U32> moved = std::move(values);
+  CHECK(values.empty());
+  CHECK(moved.size() == 1000);
+}
+
+TEST_CASE("frame array storage does not outlive the next frame") {
+  FrameAllocator allocator{64 * 1024};
+  FrameArray<U32> values{&allocator};
+  values.pushBack(1);
+  values.pushBack(2);
+
+  // Still valid during the next frame.
+  allocator.reset();
+  REQUIRE(values.size() == 2);
+  CHECK(values[1] == 2);
+
+  // After that the arena is handed out again, so the elements are gone.
+  allocator.reset();
+  CHECK(values.empty());
+  CHECK(values.begin() == values.end());
+
+  // Adding to it starts over with new storage.
+  values.pushBack(3);
+  REQUIRE(values.size() == 1);
+  CHECK(values[0] == 3);
+
+  values.clear();
+  allocator.reset();
+  allocator.reset();
+  CHECK(values.empty());
+}
+
+}  // namespace ca
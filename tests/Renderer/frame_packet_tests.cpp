@@ -0,0 +1,69 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/renderer/frame_packet.h"
+
+namespace ca {
+
+TEST_CASE("frame packet copies draws and their uniforms") {
+  FramePacket packet;
+
+  UniformBuffer uniforms;
+  uniforms.set(UniformId{3}, 2.5f);
+  uniforms.set(UniformId{7}, 4u);
+
+  DrawCommand draw{DrawType::Triangles, 6, 12, 0, ProgramId{1}, VertexBufferId{2}, {}, {}, {},
+                   0, 0};
+
+  packet.record_begin_frame({0, 0}, {100, 50});
+  packet.record_draw(CommandType::Draw, draw, uniforms);
+  packet.record_draw(CommandType::Draw, draw, UniformBuffer{});
+  packet.record_end_frame();
+
+  // Changing the buffer afterwards doesn't change what was recorded.
+  uniforms.set(UniformId{3}, 9.0f);
+
+  REQUIRE(packet.commands().size() == 4);
+  CHECK(packet.commands()[0].type == CommandType::BeginFrame);
+  CHECK(packet.begin_frame(packet.commands()[0].index).damage_size.width == 100);
+
+  const DrawCommand& first = packet.draw(packet.commands()[1].index);
+  CHECK(first.first == 6);
+  CHECK(first.count == 12);
+  REQUIRE(first.uniform_count == 2);
+  const RecordedUniform& uniform = packet.uniform(first.first_uniform);
+  CHECK(uniform.uniform_id.id == 3);
+  CHECK(uniform.count == 1);
+  CHECK(*reinterpret_cast<const F32*>(uniform.data) == 2.5f);
+
+  CHECK(packet.draw(packet.commands()[2].index).uniform_count == 0);
+  CHECK(packet.commands()[3].type == CommandType::EndFrame);
+}
+
+TEST_CASE("frame packet copies uploads and scope names") {
+  FramePacket packet;
+
+  U8 bytes[] = {1, 2, 3, 4, 5};
+  packet.record_upload(CommandType::StreamVertexBufferData, 4, {}, {}, bytes, sizeof(bytes));
+  bytes[0] = 99;
+
+  char name[] = "frame";
+  packet.record_begin_gpu_scope(name);
+  name[0] = 'x';
+  packet.record_end_gpu_scope();
+
+  REQUIRE(packet.commands().size() == 3);
+  const UploadCommand& upload = packet.upload(packet.commands()[0].index);
+  CHECK(upload.resource_id == 4);
+  REQUIRE(upload.data.size == sizeof(bytes));
+  CHECK(packet.data(upload.data)[0] == 1);
+  CHECK(packet.data(upload.data)[4] == 5);
+
+  CHECK(packet.gpu_scope_name(packet.commands()[1].index) == nu::StringView{"frame"});
+  CHECK(packet.commands()[2].type == CommandType::EndGpuScope);
+
+  packet.reset();
+  CHECK(packet.empty());
+  CHECK(packet.data_size() == 0);
+}
+
+}  // namespace ca
@@ -0,0 +1,32 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/renderer/gpu_profiler.h"
+#include "stub_renderer.h"
+
+namespace ca {
+
+TEST_CASE("gpu profiler queries are deleted with the renderer's resources") {
+  StubRenderer stub;
+  GpuProfiler* profiler = stub.renderer()->gpu_profiler();
+  profiler->set_enabled(true);
+
+  profiler->begin_frame();
+  profiler->begin_scope("frame");
+  profiler->begin_scope("draw");
+  profiler->end_scope();
+  profiler->end_scope();
+  profiler->end_frame();
+  CHECK(stub.counters().live_queries == 4);
+
+  stub.renderer()->release_resources();
+  CHECK(stub.counters().live_queries == 0);
+
+  // The profiler creates new queries when it is used again.
+  profiler->begin_frame();
+  profiler->begin_scope("frame");
+  profiler->end_scope();
+  profiler->end_frame();
+  CHECK(stub.counters().live_queries == 2);
+}
+
+}  // namespace ca
@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/renderer/immediate_mesh_cache.h"
+#include "stub_renderer.h"
+
+namespace ca {
+
+namespace {
+
+VertexDefinition position_definition() {
+  VertexDefinition def;
+  def.addAttribute(ComponentType::Float32, ComponentCount::Three);
+  return def;
+}
+
+// Look the mesh up in two frames in a row, so it is admitted.
+VertexBufferId admit(ImmediateMeshCache* cache, U64 key, const void* data, MemSize size) {
+  cache->begin_frame();
+  cache->find_or_upload(key, data, size);
+  cache->begin_frame();
+  return cache->find_or_upload(key, data, size);
+}
+
+}  // namespace
+
+TEST_CASE("meshes are cached from the second frame in a row") {
+  StubRenderer stub;
+  ImmediateMeshCache cache{stub.renderer(), position_definition(), 1024};
+
+  F32 vertices[9] = {};
+
+  cache.begin_frame();
+  CHECK_FALSE(cache.find_or_upload(1, vertices, sizeof(vertices)).is_valid());
+
+  // A frame without the mesh starts over.
+  cache.begin_frame();
+  cache.begin_frame();
+  CHECK_FALSE(cache.find_or_upload(1, vertices, sizeof(vertices)).is_valid());
+  CHECK(stub.counters().live_buffers == 0);
+
+  cache.begin_frame();
+  VertexBufferId id = cache.find_or_upload(1, vertices, sizeof(vertices));
+  CHECK(id.is_valid());
+  CHECK(stub.counters().buffer_uploads == 1);
+
+  cache.begin_frame();
+  CHECK(cache.find_or_upload(1, vertices, sizeof(vertices)).id == id.id);
+  CHECK(stub.counters().buffer_uploads == 1);
+
+  CHECK(cache.statistics().hits == 1);
+  CHECK(cache.statistics().misses == 3);
+  CHECK(cache.statistics().entry_count == 1);
+  CHECK(cache.statistics().bytes == sizeof(vertices));
+}
+
+TEST_CASE("meshes with the same key and different content are not mixed up") {
+  StubRenderer stub;
+  ImmediateMeshCache cache{stub.renderer(), position_definition(), 1024};
+
+  F32 first[9] = {};
+  F32 second[9] = {1.0f};
+  F32 shorter[6] = {};
+
+  VertexBufferId first_id = admit(&cache, 1, first, sizeof(first));
+  REQUIRE(first_id.is_valid());
+
+  VertexBufferId second_id = admit(&cache, 1, second, sizeof(second));
+  REQUIRE(second_id.is_valid());
+  CHECK(second_id.id != first_id.id);
+
+  VertexBufferId shorter_id = admit(&cache, 1, shorter, sizeof(shorter));
+  REQUIRE(shorter_id.is_valid());
+  CHECK(shorter_id.id != first_id.id);
+
+  cache.begin_frame();
+  CHECK(cache.find_or_upload(1, first, sizeof(first)).id == first_id.id);
+  CHECK(cache.find_or_upload(1, second, sizeof(second)).id == second_id.id);
+  CHECK(cache.statistics().entry_count == 3);
+}
+
+TEST_CASE("least recently used meshes are evicted to stay within the budget") {
+  StubRenderer stub;
+  F32 vertices[3][9] = {{1.0f}, {2.0f}, {3.0f}};
+  ImmediateMeshCache cache{stub.renderer(), position_definition(), 2 * sizeof(vertices[0])};
+
+  VertexBufferId first = admit(&cache, 1, vertices[0], sizeof(vertices[0]));
+  admit(&cache, 2, vertices[1], sizeof(vertices[1]));
+
+  // Use the first mesh again, so the second is the least recently used.
+  cache.begin_frame();
+  CHECK(cache.find_or_upload(1, vertices[0], sizeof(vertices[0])).id == first.id);
+
+  admit(&cache, 3, vertices[2], sizeof(vertices[2]));
+  CHECK(cache.statistics().evictions == 1);
+  CHECK(cache.statistics().entry_count == 2);
+  CHECK(cache.statistics().bytes == 2 * sizeof(vertices[0]));
+
+  cache.begin_frame();
+  CHECK(cache.find_or_upload(1, vertices[0], sizeof(vertices[0])).id == first.id);
+  CHECK_FALSE(cache.find_or_upload(2, vertices[1], sizeof(vertices[1])).is_valid());
+}
+
+TEST_CASE("meshes used in the current frame are not evicted") {
+  StubRenderer stub;
+  F32 vertices[3][9] = {{1.0f}, {2.0f}, {3.0f}};
+  ImmediateMeshCache cache{stub.renderer(), position_definition(), sizeof(vertices[0])};
+
+  for (U32 frame = 0; frame < 2; ++frame) {
+    cache.begin_frame();
+    for (U32 i = 0; i < 3; ++i) {
+      cache.find_or_upload(i + 1, vertices[i], sizeof(vertices[i]));
+    }
+  }
+
+  // Over budget for this frame.
+  CHECK(cache.statistics().entry_count == 3);
+  CHECK(cache.statistics().evictions == 0);
+
+  // The next frame only uses one of them, so the others go and their buffers are reused.
+  cache.begin_frame();
+  cache.find_or_upload(3, vertices[2], sizeof(vertices[2]));
+  cache.set_budget(sizeof(vertices[0]));
+  CHECK(cache.statistics().entry_count == 1);
+  CHECK(cache.statistics().evictions == 2);
+
+  I32 live_buffers = stub.counters().live_buffers;
+  admit(&cache, 4, vertices[0], sizeof(vertices[0]));
+  CHECK(stub.counters().live_buffers == live_buffers);
+}
+
+TEST_CASE("destroying the cache deletes its vertex buffers") {
+  StubRenderer stub;
+  F32 vertices[2][9] = {{1.0f}, {2.0f}};
+
+  {
+    ImmediateMeshCache cache{stub.renderer(), position_definition(), sizeof(vertices[0])};
+    admit(&cache, 1, vertices[0], sizeof(vertices[0]));
+    admit(&cache, 2, vertices[1], sizeof(vertices[1]));
+    CHECK(cache.statistics().evictions == 1);
+    CHECK(stub.counters().live_buffers == 2);
+  }
+
+  CHECK(stub.counters().live_buffers == 0);
+  CHECK(stub.counters().live_vertex_arrays == 0);
+}
+
+}  // namespace ca
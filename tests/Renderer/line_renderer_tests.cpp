@@ -0,0 +1,250 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/renderer/frame_packet.h"
+#include "canvas/renderer/line_renderer.h"
+#include "stub_renderer.h"
+
+namespace ca {
+
+namespace {
+
+// Mirrors `kLinesPerChunk` in `LineRenderer`.
+constexpr U32 kLinesPerChunk = 64 * 1024;
+
+// Mirrors the grid instance layout in `LineRenderer`.
+struct GridInstance {
+  fl::Vec3 center;
+  fl::Vec3 right;
+  fl::Vec3 forward;
+  U32 color;
+  F32 extent;
+  F32 block_size;
+};
+
+const GridInstance* streamed_grids(const FramePacket& packet, MemSize* count) {
+  for (const Command& command : packet.commands()) {
+    if (command.type == CommandType::StreamVertexBufferData) {
+      const UploadCommand& upload = packet.upload(command.index);
+      *count = upload.data.size / sizeof(GridInstance);
+      return reinterpret_cast<const GridInstance*>(packet.data(upload.data));
+    }
+  }
+  *count = 0;
+  return nullptr;
+}
+
+nu::DynamicArray<const DrawCommand*> recorded_draws(const FramePacket& packet, CommandType type) {
+  nu::DynamicArray<const DrawCommand*> draws;
+  for (const Command& command : packet.commands()) {
+    if (command.type == type) {
+      draws.pushBack(&packet.draw(command.index));
+    }
+  }
+  return draws;
+}
+
+MemSize stream_upload_count(const FramePacket& packet) {
+  MemSize count = 0;
+  for (const Command& command : packet.commands()) {
+    if (command.type == CommandType::StreamVertexBufferData) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST_CASE("lines are uploaded and drawn in chunks") {
+  StubRenderer stub;
+  LineRenderer lines;
+  REQUIRE(lines.initialize(stub.renderer()));
+
+  constexpr U32 kRemainder = 10;
+
+  FramePacket packet;
+  stub.renderer()->begin_recording(&packet);
+  lines.beginFrame();
+  for (U32 i = 0; i < kLinesPerChunk + kRemainder; ++i) {
+    F32 x = static_cast<F32>(i);
+    lines.renderLine({x, 0.0f, 0.0f}, {x, 1.0f, 0.0f}, Color::white);
+  }
+  lines.render(fl::Mat4::identity);
+  stub.renderer()->end_recording();
+
+  CHECK(stream_upload_count(packet) == 2);
+
+  auto draws = recorded_draws(packet, CommandType::Draw);
+  REQUIRE(draws.size() == 2);
+  // Every chunk starts at the beginning of the buffer it was just streamed into.
+  CHECK(draws[0]->first == 0);
+  CHECK(draws[0]->count == kLinesPerChunk * 2);
+  CHECK(draws[1]->first == 0);
+  CHECK(draws[1]->count == kRemainder * 2);
+}
+
+TEST_CASE("wide lines are uploaded and drawn in chunks") {
+  StubRenderer stub;
+  LineRenderer lines;
+  REQUIRE(lines.initialize(stub.renderer()));
+
+  constexpr U32 kRemainder = 3;
+
+  FramePacket packet;
+  stub.renderer()->begin_recording(&packet);
+  lines.beginFrame();
+  for (U32 i = 0; i < kLinesPerChunk + kRemainder; ++i) {
+    F32 x = static_cast<F32>(i);
+    lines.renderWideLine({x, 0.0f, 0.0f}, {x, 1.0f, 0.0f}, Color::white, 2.0f);
+  }
+  lines.render(fl::Mat4::identity);
+  stub.renderer()->end_recording();
+
+  CHECK(stream_upload_count(packet) == 2);
+
+  auto draws = recorded_draws(packet, CommandType::DrawInstanced);
+  REQUIRE(draws.size() == 2);
+  CHECK(draws[0]->instance_count == kLinesPerChunk);
+  CHECK(draws[1]->instance_count == kRemainder);
+}
+
+TEST_CASE("grid lines fade out towards the edges of the grid") {
+  constexpr F32 kBlocks = 10.0f;
+
+  CHECK(LineRenderer::gridEdgeFade({0.0f, 0.0f}, kBlocks) == 1.0f);
+  CHECK(LineRenderer::gridEdgeFade({5.0f, 0.0f}, kBlocks) == 1.0f);
+
+  // Only the larger axis counts, so the diagonal fades no sooner than the sides.
+  CHECK(LineRenderer::gridEdgeFade({5.5f, 5.5f}, kBlocks) == 1.0f);
+  CHECK(LineRenderer::gridEdgeFade({9.0f, 5.5f}, kBlocks) ==
+        Approx(LineRenderer::gridEdgeFade({9.0f, 0.0f}, kBlocks)));
+
+  F32 inner = LineRenderer::gridEdgeFade({8.0f, 0.0f}, kBlocks);
+  F32 outer = LineRenderer::gridEdgeFade({9.0f, 0.0f}, kBlocks);
+  CHECK(inner > outer);
+  CHECK(outer > 0.0f);
+
+  CHECK(LineRenderer::gridEdgeFade({10.0f, 0.0f}, kBlocks) == 0.0f);
+  CHECK(LineRenderer::gridEdgeFade({0.0f, -10.0f}, kBlocks) == 0.0f);
+  CHECK(LineRenderer::gridEdgeFade({10.0f, 10.0f}, kBlocks) == 0.0f);
+
+  CHECK(LineRenderer::gridEdgeFade({-8.0f, 3.0f}, kBlocks) ==
+        LineRenderer::gridEdgeFade({8.0f, -3.0f}, kBlocks));
+}
+
+TEST_CASE("a grid is drawn as a single instance on its plane") {
+  StubRenderer stub;
+  LineRenderer lines;
+  REQUIRE(lines.initialize(stub.renderer()));
+
+  FramePacket packet;
+  stub.renderer()->begin_recording(&packet);
+  lines.beginFrame();
+  lines.renderGrid({{0.0f, 1.0f, 0.0f}, 2.0f}, {0.0f, 0.0f, 1.0f}, Color::red, 8, 0.5f);
+  // Empty grids are dropped.
+  lines.renderGrid({{0.0f, 1.0f, 0.0f}, 0.0f}, {0.0f, 0.0f, 1.0f}, Color::red, 0, 0.5f);
+  lines.renderGrid({{0.0f, 1.0f, 0.0f}, 0.0f}, {0.0f, 0.0f, 1.0f}, Color::red, 8, 0.0f);
+  lines.render(fl::Mat4::identity);
+  stub.renderer()->end_recording();
+
+  MemSize count = 0;
+  const GridInstance* grids = streamed_grids(packet, &count);
+  REQUIRE(count == 1);
+
+  CHECK(grids[0].center.y == 2.0f);
+  CHECK(grids[0].right.x == 1.0f);
+  CHECK(grids[0].forward.z == -1.0f);
+  CHECK(grids[0].extent == 4.0f);
+  CHECK(grids[0].block_size == 0.5f);
+
+  auto draws = recorded_draws(packet, CommandType::DrawInstanced);
+  REQUIRE(draws.size() == 1);
+  CHECK(draws[0]->count == 4);
+  CHECK(draws[0]->instance_count == 1);
+}
+
+TEST_CASE("line layer slots are reused with new ids") {
+  StubRenderer stub;
+  LineRenderer lines;
+  REQUIRE(lines.initialize(stub.renderer()));
+
+  LineLayerId first = lines.createLayer();
+  LineLayerId second = lines.createLayer();
+  REQUIRE(first.is_valid());
+  REQUIRE(second.is_valid());
+  CHECK(first != second);
+
+  lines.addLine(second, {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, Color::white);
+  lines.deleteLayer(second);
+
+  // The slot is taken again, but the old id doesn't refer to the new layer.
+  LineLayerId third = lines.createLayer();
+  CHECK(third != second);
+
+  FramePacket packet;
+  stub.renderer()->begin_recording(&packet);
+  lines.addLine(second, {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, Color::white);
+  lines.deleteLayer(second);
+  lines.render(fl::Mat4::identity);
+  stub.renderer()->end_recording();
+
+  CHECK(stream_upload_count(packet) == 0);
+  CHECK(recorded_draws(packet, CommandType::Draw).empty());
+
+  lines.deleteLayer(first);
+  CHECK(lines.createLayer() != first);
+}
+
+TEST_CASE("line layers are deleted with the line renderer") {
+  StubRenderer stub;
+  I32 buffers = stub.counters().live_buffers;
+
+  {
+    LineRenderer lines;
+    REQUIRE(lines.initialize(stub.renderer()));
+    lines.createLayer();
+    LineLayerId deleted = lines.createLayer();
+    lines.createLayer();
+    lines.deleteLayer(deleted);
+    CHECK(stub.counters().live_buffers > buffers);
+  }
+
+  CHECK(stub.counters().live_buffers == buffers);
+}
+
+TEST_CASE("a line layer deleted while recording outlives the frame") {
+  StubRenderer stub;
+  LineRenderer lines;
+  REQUIRE(lines.initialize(stub.renderer()));
+
+  LineLayerId id = lines.createLayer();
+  lines.addLine(id, {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, Color::white);
+  I32 buffers = stub.counters().live_buffers;
+
+  FramePacket packet;
+  stub.renderer()->begin_recording(&packet);
+  stub.renderer()->begin_frame();
+  lines.beginFrame();
+  lines.render(fl::Mat4::identity);
+  lines.deleteLayer(id);
+  stub.renderer()->end_frame();
+  stub.renderer()->end_recording();
+
+  // The packet still draws the layer.
+  CHECK(recorded_draws(packet, CommandType::Draw).size() == 1);
+  CHECK(stub.counters().live_buffers == buffers);
+
+  // Nothing is deleted before the renderer moves on to the next frame.
+  lines.beginFrame();
+  CHECK(stub.counters().live_buffers == buffers);
+
+  packet.reset();
+  stub.renderer()->begin_recording(&packet);
+  stub.renderer()->begin_frame();
+  lines.beginFrame();
+  CHECK(stub.counters().live_buffers == buffers - 2);
+  stub.renderer()->end_frame();
+  stub.renderer()->end_recording();
+}
+
+}  // namespace ca
@@ -0,0 +1,103 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "canvas/renderer/render_thread.h"
+
+namespace ca {
+
+TEST_CASE("render thread executes packets in order on its own thread") {
+  std::mutex lock;
+  nu::DynamicArray<U32> executed;
+  std::thread::id execute_thread;
+  bool started = false;
+  bool stopped = false;
+
+  RenderThread render_thread{
+      [&](FramePacket* packet) {
+        std::lock_guard<std::mutex> guard{lock};
+        executed.pushBack(static_cast<U32>(packet->begin_frame(0).damage_size.width));
+        execute_thread = std::this_thread::get_id();
+      },
+      [&]() { started = true; }, [&]() { stopped = true; }};
+
+  render_thread.set_latency(2);
+  render_thread.start();
+
+  for (I32 frame = 0; frame < 10; ++frame) {
+    FramePacket* packet = render_thread.acquire_packet();
+    CHECK(packet->empty());
+    packet->record_begin_frame({0, 0}, {frame, 1});
+    render_thread.submit(packet);
+  }
+
+  render_thread.stop();
+
+  CHECK(started);
+  CHECK(stopped);
+  REQUIRE(executed.size() == 10);
+  for (U32 i = 0; i < 10; ++i) {
+    CHECK(executed[i] == i);
+  }
+  CHECK(execute_thread != std::this_thread::get_id());
+}
+
+TEST_CASE("render thread limits how many frames are in flight") {
+  std::atomic<bool> blocked{true};
+  std::atomic<U32> executed{0};
+
+  RenderThread render_thread{[&](FramePacket*) {
+                               while (blocked.load()) {
+                                 std::this_thread::yield();
+                               }
+                               ++executed;
+                             },
+                             []() {}, []() {}};
+
+  render_thread.set_latency(1);
+  render_thread.start();
+
+  // One frame waits to be executed and one is recorded, so the next one has to wait.
+  render_thread.submit(render_thread.acquire_packet());
+  FramePacket* recording = render_thread.acquire_packet();
+
+  std::atomic<bool> acquired{false};
+  std::thread waiter{[&]() {
+    render_thread.acquire_packet();
+    acquired = true;
+  }};
+
+  std::this_thread::sleep_for(std::chrono::milliseconds{20});
+  CHECK_FALSE(acquired.load());
+
+  blocked = false;
+  waiter.join();
+  CHECK(acquired.load());
+
+  render_thread.submit(recording);
+  render_thread.stop();
+  CHECK(executed.load() == 2);
+}
+
+TEST_CASE("render thread runs tasks and waits for them") {
+  std::thread::id task_thread;
+
+  RenderThread render_thread{[](FramePacket*) {}, []() {}, []() {}};
+
+  // Without a thread, tasks run right away.
+  render_thread.run([&]() { task_thread = std::this_thread::get_id(); });
+  CHECK(task_thread == std::this_thread::get_id());
+
+  render_thread.start();
+  render_thread.run([&]() {
+    task_thread = std::this_thread::get_id();
+    CHECK(render_thread.is_current());
+  });
+  CHECK(task_thread != std::this_thread::get_id());
+  CHECK_FALSE(render_thread.is_current());
+  render_thread.stop();
+}
+
+}  // namespace ca
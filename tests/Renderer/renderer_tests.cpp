@@ -0,0 +1,55 @@
+#include <catch2/catch.hpp>
+
+#include <string>
+
+#include "canvas/renderer/renderer.h"
+#include "stub_renderer.h"
+
+namespace ca {
+
+TEST_CASE("uniform names are interned") {
+  Renderer renderer;
+
+  UniformId transform = renderer.create_uniform("uTransform");
+  UniformId viewport_size = renderer.create_uniform("uViewportSize");
+  CHECK(transform.id != viewport_size.id);
+  CHECK(renderer.create_uniform("uTransform").id == transform.id);
+  CHECK(renderer.create_uniform("uViewportSize").id == viewport_size.id);
+
+  // Enough names to grow the table.
+  for (U32 i = 0; i < 100; ++i) {
+    std::string name = "uName" + std::to_string(i);
+    UniformId id = renderer.create_uniform(nu::StringView{name.data(), name.length()});
+    CHECK(renderer.create_uniform(nu::StringView{name.data(), name.length()}).id == id.id);
+  }
+  CHECK(renderer.create_uniform("uTransform").id == transform.id);
+}
+
+TEST_CASE("long uniform names are interned") {
+  Renderer renderer;
+
+  std::string name(Renderer::kMaxUniformNameLength + 10, 'u');
+  nu::StringView view{name.data(), name.length()};
+  UniformId id = renderer.create_uniform(view);
+  CHECK(renderer.create_uniform(view).id == id.id);
+
+  // Names are only told apart by their first characters.
+  std::string truncated = name.substr(0, Renderer::kMaxUniformNameLength);
+  CHECK(renderer.create_uniform(nu::StringView{truncated.data(), truncated.length()}).id == id.id);
+
+  std::string shorter = name.substr(0, Renderer::kMaxUniformNameLength - 1);
+  CHECK(renderer.create_uniform(nu::StringView{shorter.data(), shorter.length()}).id != id.id);
+}
+
+TEST_CASE("texture rows are uploaded tightly packed") {
+  StubRenderer stub;
+
+  // Three single byte texels per row, which is not a multiple of the default alignment.
+  U8 pixels[3 * 3] = {};
+  TextureId id = stub.renderer()->create_texture(TextureFormat::Alpha, fl::Size{3, 3}, pixels,
+                                                 sizeof(pixels));
+  CHECK(id.is_valid());
+  CHECK(stub.counters().tex_image_unpack_alignment == 1);
+}
+
+}  // namespace ca
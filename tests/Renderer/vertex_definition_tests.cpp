@@ -1,6 +1,7 @@
 #include <catch2/catch.hpp>
 
 #include "canvas/renderer/vertex_definition.h"
+#include "canvas/utils/color.h"
 
 namespace ca {
 
@@ -20,4 +21,40 @@ TEST_CASE("add single vertex attribute") {
   CHECK(attribute->getCount() == ComponentCount::Two);
 }
 
+TEST_CASE("normalized colors take four bytes") {
+  VertexDefinition vd;
+  vd.addAttribute(ComponentType::Float32, ComponentCount::Two);
+  vd.addAttribute(ComponentType::Unsigned8, ComponentCount::Four, true);
+
+  CHECK(vd.getStride() == 12);
+
+  auto attribute = vd.begin();
+  CHECK_FALSE(attribute->isNormalized());
+
+  ++attribute;
+  CHECK(attribute->getSizeInBytes() == 4);
+  CHECK(attribute->isNormalized());
+}
+
+TEST_CASE("vertex definitions advance per vertex unless given a divisor") {
+  VertexDefinition vd;
+  vd.addAttribute(ComponentType::Float32, ComponentCount::Four);
+  CHECK(vd.getDivisor() == 0);
+
+  vd.setDivisor(1);
+  CHECK(vd.getDivisor() == 1);
+  CHECK(vd.getStride() == 16);
+}
+
+TEST_CASE("pack colors with red in the lowest byte") {
+  CHECK(pack_rgba8(Color{1.0f, 0.0f, 0.0f, 0.0f}) == 0x000000ffu);
+  CHECK(pack_rgba8(Color{0.0f, 1.0f, 0.0f, 0.0f}) == 0x0000ff00u);
+  CHECK(pack_rgba8(Color{0.0f, 0.0f, 1.0f, 0.0f}) == 0x00ff0000u);
+  CHECK(pack_rgba8(Color{0.0f, 0.0f, 0.0f, 1.0f}) == 0xff000000u);
+  CHECK(pack_rgba8(Color{0.5f, 0.25f, 0.0f, 1.0f}) == 0xff004080u);
+
+  // Out of range channels are clamped.
+  CHECK(pack_rgba8(Color{2.0f, -1.0f, 0.0f, 1.5f}) == 0xff0000ffu);
+}
+
 }  // namespace ca
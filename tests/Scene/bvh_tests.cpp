@@ -0,0 +1,112 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/scene/bvh.h"
+
+namespace ca {
+
+namespace {
+
+Aabb unit_box_at(F32 x, F32 y, F32 z) {
+  return Aabb{fl::Vec3{x - 0.5f, y - 0.5f, z - 0.5f}, fl::Vec3{x + 0.5f, y + 0.5f, z + 0.5f}};
+}
+
+// A 10 x 10 x 10 lattice of unit boxes spaced 2 units apart, user data is the lattice index.
+void fill_lattice(Bvh* bvh, nu::DynamicArray<BvhHandle>* handles) {
+  for (U32 i = 0; i < 1000; ++i) {
+    F32 x = static_cast<F32>(i % 10) * 2.0f;
+    F32 y = static_cast<F32>((i / 10) % 10) * 2.0f;
+    F32 z = static_cast<F32>(i / 100) * 2.0f;
+    handles->pushBack(bvh->insert(unit_box_at(x, y, z), i));
+  }
+  bvh->refit();
+}
+
+bool contains(const nu::DynamicArray<U32>& values, U32 value) {
+  for (U32 v : values) {
+    if (v == value) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST_CASE("bvh box and frustum queries") {
+  Bvh bvh;
+  nu::DynamicArray<BvhHandle> handles;
+  fill_lattice(&bvh, &handles);
+  CHECK(bvh.size() == 1000);
+
+  nu::DynamicArray<U32> result;
+  bvh.query_box(Aabb{fl::Vec3{-1.0f, -1.0f, -1.0f}, fl::Vec3{2.6f, 0.5f, 0.5f}}, &result);
+  REQUIRE(result.size() == 2);
+  CHECK(contains(result, 0));
+  CHECK(contains(result, 1));
+
+  // The identity frustum is the [-1, 1] cube, which only touches the box at the origin.
+  result.clear();
+  bvh.query_frustum(extract_frustum(fl::Mat4::identity), &result);
+  REQUIRE(result.size() == 1);
+  CHECK(result[0] == 0);
+}
+
+TEST_CASE("bvh ray cast finds the closest object") {
+  Bvh bvh;
+  nu::DynamicArray<BvhHandle> handles;
+  fill_lattice(&bvh, &handles);
+
+  Ray ray{fl::Vec3{4.0f, 6.0f, -10.0f}, fl::Vec3{0.0f, 0.0f, 1.0f}};
+  BvhRayHit hit;
+  REQUIRE(bvh.ray_cast(ray, 100.0f, &hit));
+  CHECK(hit.user_data == 2 + 3 * 10);
+  CHECK(hit.distance == Approx(9.5f));
+
+  // Reject the first object the ray hits, the next one behind it should be found instead.
+  REQUIRE(bvh.ray_cast(ray, 100.0f, &hit,
+                       [](U32 user_data, const Ray&, F32*) { return user_data != 32; }));
+  CHECK(hit.user_data == 2 + 3 * 10 + 100);
+
+  CHECK_FALSE(bvh.ray_cast(ray, 5.0f, &hit));
+}
+
+TEST_CASE("bvh refits moved and removed objects") {
+  Bvh bvh;
+  nu::DynamicArray<BvhHandle> handles;
+  fill_lattice(&bvh, &handles);
+
+  bvh.update(handles[999], unit_box_at(-10.0f, -10.0f, -10.0f));
+  bvh.remove(handles[0]);
+  bvh.refit();
+  CHECK(bvh.size() == 999);
+
+  nu::DynamicArray<U32> result;
+  bvh.query_box(unit_box_at(-10.0f, -10.0f, -10.0f), &result);
+  REQUIRE(result.size() == 1);
+  CHECK(result[0] == 999);
+
+  result.clear();
+  bvh.query_box(unit_box_at(0.0f, 0.0f, 0.0f), &result);
+  CHECK(result.empty());
+
+  // Removed handles are reused once the tree is rebuilt.
+  bvh.rebuild();
+  BvhHandle handle = bvh.insert(unit_box_at(50.0f, 0.0f, 0.0f), 1234);
+  CHECK(handle == handles[0]);
+  bvh.refit();
+  result.clear();
+  bvh.query_box(unit_box_at(50.0f, 0.0f, 0.0f), &result);
+  REQUIRE(result.size() == 1);
+  CHECK(result[0] == 1234);
+  CHECK(bvh.user_data(handle) == 1234);
+}
+
+TEST_CASE("screen ray through the center of the viewport") {
+  Ray ray = screen_ray(fl::Pos{49, 49}, fl::Size{99, 99}, fl::Mat4::identity);
+  CHECK(ray.origin.x == Approx(0.0f).margin(0.0001f));
+  CHECK(ray.origin.y == Approx(0.0f).margin(0.0001f));
+  CHECK(ray.origin.z == Approx(-1.0f));
+  CHECK(ray.direction.z == Approx(1.0f));
+}
+
+}  // namespace ca
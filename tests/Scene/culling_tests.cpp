@@ -0,0 +1,73 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/scene/culling.h"
+#include "nucleus/containers/dynamic_array.h"
+
+namespace ca {
+
+TEST_CASE("frustum from identity is the clip cube") {
+  Frustum frustum = extract_frustum(fl::Mat4::identity);
+
+  CHECK(is_visible(frustum, BoundingSphere{fl::Vec3{0.0f, 0.0f, 0.0f}, 0.1f}));
+  CHECK(is_visible(frustum, BoundingSphere{fl::Vec3{1.5f, 0.0f, 0.0f}, 0.6f}));
+  CHECK_FALSE(is_visible(frustum, BoundingSphere{fl::Vec3{1.5f, 0.0f, 0.0f}, 0.4f}));
+  CHECK_FALSE(is_visible(frustum, BoundingSphere{fl::Vec3{0.0f, 0.0f, -3.0f}, 1.0f}));
+
+  CHECK(is_visible(frustum, Aabb{fl::Vec3{0.5f, 0.5f, 0.5f}, fl::Vec3{2.0f, 2.0f, 2.0f}}));
+  CHECK_FALSE(is_visible(frustum, Aabb{fl::Vec3{1.1f, 0.0f, 0.0f}, fl::Vec3{2.0f, 1.0f, 1.0f}}));
+}
+
+TEST_CASE("batch culling matches single tests") {
+  Frustum frustum = extract_frustum(fl::Mat4::identity);
+
+  // An odd count so that the vector loops and the scalar tail are both exercised.
+  constexpr U32 kCount = 37;
+  nu::DynamicArray<F32> x, y, z, radius, min_x, min_y, min_z, max_x, max_y, max_z;
+  for (U32 i = 0; i < kCount; ++i) {
+    F32 position = -4.0f + static_cast<F32>(i) * 0.25f;
+    x.pushBack(position);
+    y.pushBack(position * 0.5f);
+    z.pushBack(0.0f);
+    radius.pushBack(0.5f);
+
+    min_x.pushBack(position - 0.5f);
+    min_y.pushBack(position * 0.5f - 0.5f);
+    min_z.pushBack(-0.5f);
+    max_x.pushBack(position + 0.5f);
+    max_y.pushBack(position * 0.5f + 0.5f);
+    max_z.pushBack(0.5f);
+  }
+
+  nu::DynamicArray<U32> visible;
+  visible.resize(kCount);
+
+  SphereBoundsArrays spheres{x.data(), y.data(), z.data(), radius.data()};
+  U32 sphere_count = cull_spheres(frustum, spheres, 0, kCount, visible.data());
+
+  U32 expected = 0;
+  for (U32 i = 0; i < kCount; ++i) {
+    if (is_visible(frustum, BoundingSphere{fl::Vec3{x[i], y[i], z[i]}, radius[i]})) {
+      REQUIRE(expected < sphere_count);
+      CHECK(visible[expected++] == i);
+    }
+  }
+  CHECK(sphere_count == expected);
+  CHECK(sphere_count > 0);
+  CHECK(sphere_count < kCount);
+
+  AabbBoundsArrays boxes{min_x.data(), min_y.data(), min_z.data(),
+                         max_x.data(), max_y.data(), max_z.data()};
+  U32 box_count = cull_aabbs(frustum, boxes, 5, kCount - 5, visible.data());
+
+  expected = 0;
+  for (U32 i = 5; i < kCount; ++i) {
+    Aabb aabb{fl::Vec3{min_x[i], min_y[i], min_z[i]}, fl::Vec3{max_x[i], max_y[i], max_z[i]}};
+    if (is_visible(frustum, aabb)) {
+      REQUIRE(expected < box_count);
+      CHECK(visible[expected++] == i);
+    }
+  }
+  CHECK(box_count == expected);
+}
+
+}  // namespace ca
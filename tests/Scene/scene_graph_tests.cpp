@@ -0,0 +1,74 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/scene/scene_graph.h"
+#include "floats/transform.h"
+
+namespace ca {
+
+namespace {
+
+fl::Vec3 translation_of(const fl::Mat4& m) {
+  return fl::Vec3{m.col[3].x, m.col[3].y, m.col[3].z};
+}
+
+}  // namespace
+
+TEST_CASE("world transforms follow the hierarchy") {
+  SceneGraph graph;
+
+  SceneNodeId root =
+      graph.create_node(kInvalidSceneNode, fl::translation_matrix({1.0f, 0.0f, 0.0f}));
+  SceneNodeId child = graph.create_node(root, fl::translation_matrix({0.0f, 2.0f, 0.0f}));
+  SceneNodeId grandchild = graph.create_node(child, fl::translation_matrix({0.0f, 0.0f, 3.0f}));
+  SceneNodeId sibling = graph.create_node(root, fl::translation_matrix({0.0f, 0.0f, 5.0f}));
+  graph.update();
+
+  fl::Vec3 position = translation_of(graph.world_transform(grandchild));
+  CHECK(position.x == Approx(1.0f));
+  CHECK(position.y == Approx(2.0f));
+  CHECK(position.z == Approx(3.0f));
+
+  // Parents always come before their children.
+  CHECK(graph.position(root) < graph.position(child));
+  CHECK(graph.position(child) < graph.position(grandchild));
+
+  // Moving the root moves everything below it.
+  graph.set_local_transform(root, fl::translation_matrix({10.0f, 0.0f, 0.0f}));
+  graph.update();
+  CHECK(translation_of(graph.world_transform(grandchild)).x == Approx(10.0f));
+  CHECK(translation_of(graph.world_transform(sibling)).x == Approx(10.0f));
+  CHECK(translation_of(graph.world_transform(sibling)).z == Approx(5.0f));
+
+  // Reparenting the grandchild to the sibling.
+  graph.set_parent(grandchild, sibling);
+  graph.update();
+  position = translation_of(graph.world_transform(grandchild));
+  CHECK(position.y == Approx(0.0f));
+  CHECK(position.z == Approx(8.0f));
+  CHECK(graph.position(sibling) < graph.position(grandchild));
+}
+
+TEST_CASE("destroying a node destroys its subtree") {
+  SceneGraph graph;
+
+  SceneNodeId root = graph.create_node();
+  SceneNodeId child = graph.create_node(root);
+  graph.create_node(child);
+  SceneNodeId other =
+      graph.create_node(kInvalidSceneNode, fl::translation_matrix({4.0f, 0.0f, 0.0f}));
+  graph.update();
+  CHECK(graph.size() == 4);
+
+  graph.destroy_node(child);
+  graph.update();
+  CHECK(graph.size() == 2);
+  CHECK(translation_of(graph.world_transform(other)).x == Approx(4.0f));
+
+  // Ids of destroyed nodes are reused.
+  SceneNodeId reused = graph.create_node(root);
+  graph.update();
+  CHECK(reused < 4);
+  CHECK(graph.size() == 3);
+}
+
+}  // namespace ca
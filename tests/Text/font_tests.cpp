@@ -0,0 +1,183 @@
+#include <catch2/catch.hpp>
+
+#include <cstring>
+
+#include "canvas/text/font.h"
+
+namespace ca {
+
+namespace {
+
+// A copy of a font file that tests can take apart and patch.
+class FontFile {
+public:
+  FontFile() {
+    Font font;
+    REQUIRE(font.load_from_file(CANVAS_ASSETS_DIR "/coders-crux.ttf"));
+    bytes_.resize(font.data().size());
+    std::memcpy(bytes_.data(), font.data().data(), bytes_.size());
+  }
+
+  MemSize table(const char* tag) const {
+    U16 table_count = read_u16(4);
+    for (U16 i = 0; i < table_count; ++i) {
+      MemSize record = 12 + static_cast<MemSize>(i) * 16;
+      if (std::memcmp(bytes_.data() + record, tag, 4) == 0) {
+        return read_u32(record + 8);
+      }
+    }
+    FAIL("Font has no " << tag << " table.");
+    return 0;
+  }
+
+  U16 read_u16(MemSize offset) const {
+    return static_cast<U16>((bytes_[offset] << 8) | bytes_[offset + 1]);
+  }
+
+  U32 read_u32(MemSize offset) const {
+    return (static_cast<U32>(read_u16(offset)) << 16) | read_u16(offset + 2);
+  }
+
+  void write_u16(MemSize offset, U16 value) {
+    bytes_[offset] = static_cast<U8>(value >> 8);
+    bytes_[offset + 1] = static_cast<U8>(value);
+  }
+
+  void write_u32(MemSize offset, U32 value) {
+    write_u16(offset, static_cast<U16>(value >> 16));
+    write_u16(offset + 2, static_cast<U16>(value));
+  }
+
+  MemSize append(MemSize size) {
+    MemSize offset = bytes_.size();
+    bytes_.resize(offset + size);
+    std::memset(bytes_.data() + offset, 0, size);
+    return offset;
+  }
+
+  bool long_loca() const {
+    return read_u16(table("head") + 50) != 0;
+  }
+
+  MemSize glyph_offset(U32 glyph) const {
+    MemSize loca = table("loca");
+    return long_loca() ? read_u32(loca + glyph * 4) : read_u16(loca + glyph * 2) * 2u;
+  }
+
+  // Moves the end of `glyph`, which is where the next glyph starts.
+  void set_glyph_size(U32 glyph, MemSize size) {
+    MemSize loca = table("loca");
+    MemSize end = glyph_offset(glyph) + size;
+    if (long_loca()) {
+      write_u32(loca + (glyph + 1) * 4, static_cast<U32>(end));
+    } else {
+      write_u16(loca + (glyph + 1) * 2, static_cast<U16>(end / 2));
+    }
+  }
+
+  bool load(Font* font) const {
+    return font->load(bytes_.data(), bytes_.size());
+  }
+
+private:
+  nu::DynamicArray<U8> bytes_;
+};
+
+}  // namespace
+
+TEST_CASE("format 12 character maps are searched within their bounds") {
+  FontFile file;
+  Font original;
+  REQUIRE(file.load(&original));
+  U32 a = original.glyph_index('A');
+  U32 c = original.glyph_index('C');
+  REQUIRE(a != 0);
+  REQUIRE(c != 0);
+
+  // Point the first cmap record at a new format 12 subtable at the end of the file.
+  struct Group {
+    U32 first;
+    U32 last;
+    U32 glyph;
+  };
+  const Group groups[] = {{'A', 'A', a}, {'C', 'C', c}, {0x1f600, 0x1f601, a}};
+  constexpr U32 kGroupCount = 3;
+
+  MemSize cmap = file.table("cmap");
+  MemSize subtable = file.append(16 + kGroupCount * 12);
+  file.write_u32(cmap + 8, static_cast<U32>(subtable - cmap));
+  file.write_u16(subtable, 12);
+  file.write_u32(subtable + 4, 16 + kGroupCount * 12);
+  file.write_u32(subtable + 12, kGroupCount);
+  for (U32 i = 0; i < kGroupCount; ++i) {
+    file.write_u32(subtable + 16 + i * 12, groups[i].first);
+    file.write_u32(subtable + 20 + i * 12, groups[i].last);
+    file.write_u32(subtable + 24 + i * 12, groups[i].glyph);
+  }
+
+  auto check_lookups = [&](const Font& font) {
+    CHECK(font.glyph_index('A') == a);
+    CHECK(font.glyph_index('B') == 0);
+    CHECK(font.glyph_index('C') == c);
+    CHECK(font.glyph_index('D') == 0);
+    CHECK(font.glyph_index(0x1f601) == a + 1);
+    CHECK(font.glyph_index(0x1f602) == 0);
+    CHECK(font.glyph_index(' ') == 0);
+  };
+
+  Font font;
+  REQUIRE(file.load(&font));
+  check_lookups(font);
+
+  // A group count and a length that run past the end of the file.
+  file.write_u32(subtable + 12, 0xffffffffu);
+  REQUIRE(file.load(&font));
+  check_lookups(font);
+
+  file.write_u32(subtable + 4, 0xfffffff0u);
+  REQUIRE(file.load(&font));
+  check_lookups(font);
+}
+
+TEST_CASE("composite glyphs that are cut short are rejected") {
+  FontFile file;
+  Font original;
+  REQUIRE(file.load(&original));
+  U32 a = original.glyph_index('A');
+  // Not the glyph after 'A', which moves when 'A' is resized.
+  U32 o = original.glyph_index('O');
+  REQUIRE(o != a + 1);
+
+  nu::DynamicArray<OutlineSegment> o_segments;
+  REQUIRE(original.glyph_outline(o, &o_segments));
+
+  // Turn 'A' into a single component: 'O' with word arguments and a 2 x 2 transform.
+  MemSize glyph = file.table("glyf") + file.glyph_offset(a);
+  file.write_u16(glyph, 0xffff);
+  file.write_u16(glyph + 10, 0x0001 | 0x0002 | 0x0080);
+  file.write_u16(glyph + 12, static_cast<U16>(o));
+  file.write_u16(glyph + 14, 0);
+  file.write_u16(glyph + 16, 0);
+  file.write_u16(glyph + 18, 0x4000);
+  file.write_u16(glyph + 20, 0);
+  file.write_u16(glyph + 22, 0);
+  file.write_u16(glyph + 24, 0x4000);
+
+  Font font;
+  nu::DynamicArray<OutlineSegment> segments;
+
+  file.set_glyph_size(a, 26);
+  REQUIRE(file.load(&font));
+  CHECK(font.glyph_outline(a, &segments));
+  CHECK(segments.size() == o_segments.size());
+
+  // Without the transform, or without the arguments.
+  for (MemSize size : {18, 14}) {
+    file.set_glyph_size(a, size);
+    REQUIRE(file.load(&font));
+    segments.clear();
+    CHECK_FALSE(font.glyph_outline(a, &segments));
+  }
+}
+
+}  // namespace ca
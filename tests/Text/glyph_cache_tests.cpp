@@ -0,0 +1,183 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/text/glyph_cache.h"
+#include "canvas/text/text_renderer.h"
+#include "stub_renderer.h"
+
+namespace ca {
+
+namespace {
+
+// Cells for this font at these settings are 13 x 15 pixels, so a page has 4 cells and the budget
+// allows one page.
+GlyphCacheSettings four_glyph_settings() {
+  GlyphCacheSettings settings;
+  settings.glyph_size = 16.0f;
+  settings.spread = 2.0f;
+  settings.page_size = 32;
+  settings.texture_budget = 32 * 32;
+  return settings;
+}
+
+Font load_font() {
+  Font font;
+  REQUIRE(font.load_from_file(CANVAS_ASSETS_DIR "/coders-crux.ttf"));
+  return font;
+}
+
+}  // namespace
+
+TEST_CASE("glyphs are rasterized once") {
+  StubRenderer stub;
+  Font font = load_font();
+  GlyphCache cache{stub.renderer(), &font, four_glyph_settings()};
+
+  const CachedGlyph* glyph = cache.glyph('A');
+  REQUIRE(glyph);
+  CHECK(glyph->glyph.codepoint == 'A');
+  CHECK(glyph->glyph.width > 0);
+  CHECK(glyph->texture.is_valid());
+
+  // The page and the glyph's cell.
+  CHECK(stub.counters().texture_uploads == 2);
+
+  cache.begin_frame();
+  REQUIRE(cache.glyph('A'));
+  CHECK(stub.counters().texture_uploads == 2);
+
+  CHECK(cache.statistics().hits == 1);
+  CHECK(cache.statistics().misses == 1);
+  CHECK(cache.statistics().page_count == 1);
+  CHECK(cache.statistics().glyph_count == 1);
+}
+
+TEST_CASE("the least recently used glyph gives up its cell") {
+  StubRenderer stub;
+  Font font = load_font();
+  GlyphCache cache{stub.renderer(), &font, four_glyph_settings()};
+
+  for (U32 codepoint : {'A', 'B', 'C', 'D'}) {
+    REQUIRE(cache.glyph(codepoint));
+  }
+
+  cache.begin_frame();
+  REQUIRE(cache.glyph('A'));
+  U16 b_x = 0;
+  U16 b_y = 0;
+  {
+    const CachedGlyph* b = cache.glyph('B');
+    b_x = b->glyph.x;
+    b_y = b->glyph.y;
+  }
+  REQUIRE(cache.glyph('C'));
+  REQUIRE(cache.glyph('D'));
+
+  // 'A' was used longest ago.
+  cache.begin_frame();
+  const CachedGlyph* e = cache.glyph('E');
+  REQUIRE(e);
+  CHECK(cache.statistics().evictions == 1);
+  CHECK(cache.statistics().glyph_count == 4);
+  CHECK(cache.statistics().page_count == 1);
+
+  U64 misses = cache.statistics().misses;
+  const CachedGlyph* b = cache.glyph('B');
+  REQUIRE(b);
+  CHECK(b->glyph.x == b_x);
+  CHECK(b->glyph.y == b_y);
+  CHECK(cache.statistics().misses == misses);
+
+  REQUIRE(cache.glyph('A'));
+  CHECK(cache.statistics().misses == misses + 1);
+}
+
+TEST_CASE("glyphs stay findable while others are replaced") {
+  StubRenderer stub;
+  Font font = load_font();
+  GlyphCache cache{stub.renderer(), &font, four_glyph_settings()};
+
+  // Replace every glyph each frame, so removals from the table shift the probe sequences of the
+  // glyphs that are left.
+  for (U32 first = 33; first + 4 <= 127; first += 2) {
+    cache.begin_frame();
+    for (U32 codepoint = first; codepoint < first + 4; ++codepoint) {
+      REQUIRE(cache.glyph(codepoint));
+    }
+
+    U64 hits = cache.statistics().hits;
+    for (U32 codepoint = first; codepoint < first + 4; ++codepoint) {
+      const CachedGlyph* glyph = cache.glyph(codepoint);
+      REQUIRE(glyph);
+      CHECK(glyph->glyph.codepoint == codepoint);
+    }
+    CHECK(cache.statistics().hits == hits + 4);
+  }
+
+  CHECK(cache.statistics().glyph_count == 4);
+  CHECK(cache.statistics().overflows == 0);
+}
+
+TEST_CASE("glyphs used in the current frame are not replaced") {
+  StubRenderer stub;
+  Font font = load_font();
+  GlyphCache cache{stub.renderer(), &font, four_glyph_settings()};
+
+  for (U32 codepoint : {'A', 'B', 'C', 'D'}) {
+    REQUIRE(cache.glyph(codepoint));
+  }
+
+  CHECK_FALSE(cache.glyph('E'));
+  CHECK(cache.statistics().overflows == 1);
+  CHECK(cache.statistics().evictions == 0);
+
+  // The glyph can still be measured, without a cell.
+  SdfGlyph measured;
+  CHECK(cache.measure('E', &measured));
+  CHECK(measured.width > 0);
+  CHECK(measured.advance > 0.0f);
+
+  cache.begin_frame();
+  const CachedGlyph* e = cache.glyph('E');
+  REQUIRE(e);
+  CHECK(e->glyph.width == measured.width);
+  CHECK(e->glyph.advance == measured.advance);
+}
+
+TEST_CASE("text is laid out while the glyph cache is full") {
+  StubRenderer stub;
+  Font font = load_font();
+  GlyphCache cache{stub.renderer(), &font, four_glyph_settings()};
+
+  TextRenderer text_renderer{stub.renderer()};
+  REQUIRE(text_renderer.initialize(&cache));
+
+  // Only four of the glyphs get a cell, but all of them advance the pen.
+  const TextLayout& layout = text_renderer.layout("ABCDEF", 1.0f);
+  CHECK(cache.statistics().overflows == 2);
+  REQUIRE(layout.glyphs.size() == 6);
+  CHECK(layout.glyphs[5].left > layout.glyphs[4].left);
+  CHECK(layout.glyphs[4].left > layout.glyphs[3].left);
+
+  F32 width = 0.0f;
+  for (U32 codepoint : {'A', 'B', 'C', 'D', 'E', 'F'}) {
+    SdfGlyph measured;
+    cache.measure(codepoint, &measured);
+    width += measured.advance;
+  }
+  CHECK(layout.width == Approx(width));
+}
+
+TEST_CASE("destroying the glyph cache deletes its pages") {
+  StubRenderer stub;
+  Font font = load_font();
+
+  {
+    GlyphCache cache{stub.renderer(), &font, four_glyph_settings()};
+    REQUIRE(cache.glyph('A'));
+    CHECK(stub.counters().live_textures == 1);
+  }
+
+  CHECK(stub.counters().live_textures == 0);
+}
+
+}  // namespace ca
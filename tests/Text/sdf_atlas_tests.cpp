@@ -0,0 +1,108 @@
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+#include "canvas/text/sdf_atlas.h"
+
+namespace ca {
+
+TEST_CASE("signed distance field of a square") {
+  // A 4 x 4 unit square, counter clockwise.
+  OutlineSegment square[] = {
+      {0.0f, 0.0f, 4.0f, 0.0f},
+      {4.0f, 0.0f, 4.0f, 4.0f},
+      {4.0f, 4.0f, 0.0f, 4.0f},
+      {0.0f, 4.0f, 0.0f, 0.0f},
+  };
+
+  // 8 x 8 pixels covering -2..6 at 1 pixel per unit, so the square is in the middle.
+  U8 pixels[8 * 8];
+  generate_sdf(square, 4, -2.0f, 6.0f, 1.0f, 1.0f, pixels, 8, 8, 8);
+
+  // More than the spread away from every edge: fully inside.
+  CHECK(pixels[4 * 8 + 4] == 255);
+  CHECK(pixels[3 * 8 + 3] == 255);
+
+  // Corners of the bitmap are well outside.
+  CHECK(pixels[0] == 0);
+  CHECK(pixels[7 * 8 + 7] == 0);
+
+  // Half a pixel inside and outside of the left edge.
+  CHECK(pixels[4 * 8 + 2] > 128);
+  CHECK(pixels[4 * 8 + 1] < 128);
+}
+
+TEST_CASE("winding order does not change the sign") {
+  OutlineSegment square[] = {
+      {0.0f, 0.0f, 0.0f, 4.0f},
+      {0.0f, 4.0f, 4.0f, 4.0f},
+      {4.0f, 4.0f, 4.0f, 0.0f},
+      {4.0f, 0.0f, 0.0f, 0.0f},
+  };
+
+  U8 pixels[8 * 8];
+  generate_sdf(square, 4, -2.0f, 6.0f, 1.0f, 1.0f, pixels, 8, 8, 8);
+
+  CHECK(pixels[4 * 8 + 4] == 255);
+  CHECK(pixels[0] == 0);
+}
+
+TEST_CASE("sdf atlas caches that do not match their header are rejected") {
+  Font font;
+  REQUIRE(font.load_from_file(CANVAS_ASSETS_DIR "/coders-crux.ttf"));
+
+  SdfAtlasSettings settings;
+  settings.glyph_size = 16.0f;
+  settings.spread = 2.0f;
+
+  SdfAtlas atlas;
+  REQUIRE(atlas.build(font, settings));
+
+  const char* path = "sdf_atlas_tests.cache";
+  REQUIRE(atlas.save(path));
+
+  nu::DynamicArray<char> contents;
+  {
+    std::FILE* file = std::fopen(path, "rb");
+    REQUIRE(file);
+    for (int c = std::fgetc(file); c != EOF; c = std::fgetc(file)) {
+      contents.pushBack(static_cast<char>(c));
+    }
+    std::fclose(file);
+  }
+
+  auto write = [&](MemSize size) {
+    std::FILE* file = std::fopen(path, "wb");
+    REQUIRE(file);
+    std::fwrite(contents.data(), 1, size, file);
+    std::fclose(file);
+  };
+
+  SdfAtlas loaded;
+  CHECK(loaded.load(path));
+  CHECK(loaded.size().width == atlas.size().width);
+  CHECK(loaded.size().height == atlas.size().height);
+
+  // Truncated pixels.
+  write(contents.size() - 1);
+  CHECK_FALSE(loaded.load(path));
+
+  // A glyph count that runs past the end of the file, in the last field of the 48 byte header.
+  U32 original_glyph_count = 0;
+  U32 glyph_count = 0xffffffu;
+  MemSize glyph_count_offset = 44;
+  std::memcpy(&original_glyph_count, contents.data() + glyph_count_offset, sizeof(U32));
+  REQUIRE(original_glyph_count == settings.last_codepoint - settings.first_codepoint + 1);
+  std::memcpy(contents.data() + glyph_count_offset, &glyph_count, sizeof(U32));
+  write(contents.size());
+  CHECK_FALSE(loaded.load(path));
+
+  std::memcpy(contents.data() + glyph_count_offset, &original_glyph_count, sizeof(U32));
+  write(contents.size());
+  CHECK(loaded.load(path));
+
+  std::remove(path);
+}
+
+}  // namespace ca
@@ -0,0 +1,101 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/text/text_layout.h"
+
+namespace ca {
+
+namespace {
+
+// Every glyph is half an em wide; spaces are not drawn.
+LayoutFont monospaced_font() {
+  LayoutFont font;
+  font.key = 1;
+  font.ascender = 0.75f;
+  font.line_height = 1.0f;
+  font.placement = [](U32 codepoint, GlyphPlacement* placement) {
+    placement->advance = 0.5f;
+    placement->left = 0.0f;
+    placement->top = 0.75f;
+    placement->width = 0.5f;
+    placement->height = 1.0f;
+    placement->visible = codepoint != ' ';
+    return true;
+  };
+  return font;
+}
+
+}  // namespace
+
+TEST_CASE("lay out lines of text") {
+  TextLayout layout;
+  layout_text(monospaced_font(), "ab c\nde", 10.0f, 0.0f, &layout);
+
+  REQUIRE(layout.glyphs.size() == 5);
+  CHECK(layout.width == 20.0f);
+  CHECK(layout.height == 20.0f);
+
+  CHECK(layout.glyphs[0].left == 0.0f);
+  CHECK(layout.glyphs[0].top == 0.0f);
+  CHECK(layout.glyphs[0].right == 5.0f);
+  CHECK(layout.glyphs[0].bottom == 10.0f);
+
+  CHECK(layout.glyphs[2].codepoint == 'c');
+  CHECK(layout.glyphs[2].left == 15.0f);
+
+  CHECK(layout.glyphs[3].codepoint == 'd');
+  CHECK(layout.glyphs[3].left == 0.0f);
+  CHECK(layout.glyphs[3].top == 10.0f);
+}
+
+TEST_CASE("wrap text at spaces") {
+  TextLayout layout;
+  layout_text(monospaced_font(), "ab cd ef", 10.0f, 18.0f, &layout);
+
+  REQUIRE(layout.glyphs.size() == 6);
+  CHECK(layout.height == 30.0f);
+  CHECK(layout.width == 10.0f);
+
+  CHECK(layout.glyphs[2].codepoint == 'c');
+  CHECK(layout.glyphs[2].left == 0.0f);
+  CHECK(layout.glyphs[2].top == 10.0f);
+
+  CHECK(layout.glyphs[4].codepoint == 'e');
+  CHECK(layout.glyphs[4].left == 0.0f);
+  CHECK(layout.glyphs[4].top == 20.0f);
+}
+
+TEST_CASE("layout cache only lays out new text") {
+  LayoutFont font = monospaced_font();
+  TextLayoutCache cache;
+
+  cache.begin_frame();
+  CHECK(cache.layout(font, "label", 10.0f).glyphs.size() == 5);
+  CHECK(cache.layout(font, "label", 10.0f).width == 25.0f);
+  CHECK(cache.layout(font, "label", 20.0f).width == 50.0f);
+
+  CHECK(cache.statistics().hits == 1);
+  CHECK(cache.statistics().misses == 2);
+  CHECK(cache.statistics().entry_count == 2);
+}
+
+TEST_CASE("layout cache stays within its budget") {
+  LayoutFont font = monospaced_font();
+  TextLayoutCache cache{1};
+
+  // Layouts used in the current frame are kept even over budget.
+  cache.begin_frame();
+  cache.layout(font, "one", 10.0f);
+  cache.layout(font, "two", 10.0f);
+  CHECK(cache.statistics().entry_count == 2);
+  CHECK(cache.statistics().evictions == 0);
+
+  cache.begin_frame();
+  cache.layout(font, "three", 10.0f);
+  CHECK(cache.statistics().entry_count == 1);
+  CHECK(cache.statistics().evictions == 2);
+
+  cache.layout(font, "three", 10.0f);
+  CHECK(cache.statistics().hits == 1);
+}
+
+}  // namespace ca
@@ -0,0 +1,27 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/text/utf8.h"
+
+namespace ca {
+
+TEST_CASE("decode utf-8 code points") {
+  nu::StringView text{"a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\xff"};
+
+  MemSize index = 0;
+  CHECK(next_codepoint(text, &index) == 'a');
+  CHECK(next_codepoint(text, &index) == 0xe9);
+  CHECK(next_codepoint(text, &index) == 0x20ac);
+  CHECK(next_codepoint(text, &index) == 0x1f600);
+  CHECK(next_codepoint(text, &index) == 0xfffd);
+  CHECK(index == text.length());
+}
+
+TEST_CASE("truncated utf-8 sequence") {
+  nu::StringView text{"\xe2\x82"};
+
+  MemSize index = 0;
+  CHECK(next_codepoint(text, &index) == 0xfffd);
+  CHECK(index == 1);
+}
+
+}  // namespace ca
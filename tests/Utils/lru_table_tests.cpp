@@ -0,0 +1,80 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/utils/lru_table.h"
+
+namespace ca {
+
+TEST_CASE("lru table finds entries by key and value") {
+  LruTable table;
+  U32 values[] = {10, 20, 30};
+
+  for (U32 i = 0; i < 3; ++i) {
+    REQUIRE(table.add_entry() == i);
+  }
+
+  // The first two share a key.
+  table.insert(0, 1, 0);
+  table.insert(1, 1, 0);
+  table.insert(2, 2, 0);
+  CHECK(table.size() == 3);
+
+  auto find = [&](U64 key, U32 value) {
+    return table.find(key, [&](U32 index) { return values[index] == value; });
+  };
+
+  CHECK(find(1, 10) == 0);
+  CHECK(find(1, 20) == 1);
+  CHECK(find(2, 30) == 2);
+  CHECK(find(1, 30) == LruTable::kInvalidEntry);
+  CHECK(find(3, 10) == LruTable::kInvalidEntry);
+
+  table.remove(0);
+  CHECK(find(1, 10) == LruTable::kInvalidEntry);
+  CHECK(find(1, 20) == 1);
+  CHECK(table.size() == 2);
+  CHECK(table.capacity() == 3);
+
+  CHECK(table.take_free_entry() == 0);
+  CHECK(table.take_free_entry() == LruTable::kInvalidEntry);
+}
+
+TEST_CASE("lru table evicts the least recently used entry of an earlier frame") {
+  LruTable table;
+  for (U32 i = 0; i < 3; ++i) {
+    table.insert(table.add_entry(), i, 0);
+  }
+
+  CHECK(table.evictable(0) == LruTable::kInvalidEntry);
+  CHECK(table.evictable(1) == 0);
+
+  table.touch(0, 1);
+  CHECK(table.evictable(1) == 1);
+
+  table.remove(1);
+  CHECK(table.evictable(1) == 2);
+
+  table.remove(2);
+  CHECK(table.evictable(1) == LruTable::kInvalidEntry);
+  CHECK(table.evictable(2) == 0);
+}
+
+TEST_CASE("lru table keeps finding entries as it grows and shrinks") {
+  LruTable table;
+  auto any = [](U32) { return true; };
+
+  for (U32 i = 0; i < 1000; ++i) {
+    table.insert(table.add_entry(), i, 0);
+  }
+
+  // Removing every other entry shifts the probe sequences of the others back.
+  for (U32 i = 0; i < 1000; i += 2) {
+    table.remove(table.find(i, any));
+  }
+
+  for (U32 i = 0; i < 1000; ++i) {
+    CHECK((table.find(i, any) == LruTable::kInvalidEntry) == (i % 2 == 0));
+  }
+  CHECK(table.size() == 500);
+}
+
+}  // namespace ca
@@ -0,0 +1,167 @@
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <cstring>
+
+#include "canvas/utils/mesh_lod.h"
+#include "floats/transform.h"
+
+namespace ca {
+
+namespace {
+
+struct Vertex {
+  F32 x;
+  F32 y;
+  F32 z;
+};
+
+// A closed torus, so that no vertex is locked to an open border and every collapse has a cost.
+IndexedMesh create_torus(U32 segments) {
+  IndexedMesh mesh;
+  mesh.vertex_size = sizeof(Vertex);
+
+  constexpr F32 kTau = 6.2831853f;
+  nu::DynamicArray<Vertex> vertices;
+  for (U32 i = 0; i < segments; ++i) {
+    for (U32 j = 0; j < segments; ++j) {
+      F32 a = static_cast<F32>(i) * kTau / static_cast<F32>(segments);
+      F32 b = static_cast<F32>(j) * kTau / static_cast<F32>(segments);
+      F32 ring = 2.0f + std::cos(b);
+      vertices.pushBack({ring * std::cos(a), ring * std::sin(a), std::sin(b)});
+    }
+  }
+
+  mesh.vertices.resize(vertices.size() * sizeof(Vertex));
+  std::memcpy(mesh.vertices.data(), vertices.data(), mesh.vertices.size());
+
+  for (U32 i = 0; i < segments; ++i) {
+    for (U32 j = 0; j < segments; ++j) {
+      U32 next_i = (i + 1) % segments;
+      U32 next_j = (j + 1) % segments;
+      U32 a = i * segments + j;
+      U32 b = next_i * segments + j;
+      U32 c = next_i * segments + next_j;
+      U32 d = i * segments + next_j;
+      for (U32 index : {a, b, c, a, c, d}) {
+        mesh.indices.pushBack(index);
+      }
+    }
+  }
+
+  return mesh;
+}
+
+Geometry geometry_from_lods(const MeshLods& lods) {
+  Geometry geometry;
+  geometry.bounds_radius = 3.0f;
+  geometry.lod_count = static_cast<U32>(lods.levels.size());
+  for (U32 i = 0; i < geometry.lod_count; ++i) {
+    geometry.lods[i] = lods.levels[i];
+  }
+  geometry.index_count = geometry.lods[0].index_count;
+  return geometry;
+}
+
+// A projection that copies -z into w, with a 45 degree vertical field of view.
+fl::Mat4 perspective() {
+  fl::Mat4 projection = fl::Mat4::identity;
+  projection.col[1].y = 2.4f;
+  projection.col[2].w = -1.0f;
+  projection.col[3].w = 0.0f;
+  return projection;
+}
+
+}  // namespace
+
+TEST_CASE("every level of detail has fewer triangles than the one before") {
+  IndexedMesh mesh = create_torus(32);
+  MeshLods lods = generate_lods(mesh, 4);
+
+  REQUIRE(lods.levels.size() == 4);
+  CHECK(lods.levels[0].index_offset == 0);
+  CHECK(lods.levels[0].index_count == mesh.indices.size());
+  CHECK(lods.levels[0].error == 0.0f);
+
+  for (MemSize lod = 1; lod < lods.levels.size(); ++lod) {
+    const GeometryLod& previous = lods.levels[lod - 1];
+    const GeometryLod& level = lods.levels[lod];
+    CHECK(level.index_count % 3 == 0);
+    CHECK(level.index_count < previous.index_count);
+    CHECK(level.index_offset == previous.index_offset + previous.index_count);
+    CHECK(level.error >= previous.error);
+  }
+
+  const GeometryLod& last = lods.levels[lods.levels.size() - 1];
+  CHECK(lods.indices.size() == last.index_offset + last.index_count);
+  for (U32 index : lods.indices) {
+    CHECK(index < mesh.vertex_count());
+  }
+}
+
+TEST_CASE("simplification stops at the error bound") {
+  IndexedMesh mesh = create_torus(32);
+  nu::DynamicArray<U32> simplified;
+  simplified.resize(mesh.indices.size());
+
+  constexpr F32 kTargetError = 0.01f;
+  F32 error = 0.0f;
+  MemSize count = simplify_mesh(simplified.data(), mesh.indices.data(), mesh.indices.size(),
+                                mesh.vertices.data(), mesh.vertex_count(), mesh.vertex_size, 0,
+                                kTargetError, &error);
+
+  CHECK(count > 0);
+  CHECK(count < mesh.indices.size());
+  CHECK(error <= kTargetError);
+
+  // Without a bound the same mesh goes further.
+  F32 unbounded_error = 0.0f;
+  MemSize unbounded_count = simplify_mesh(simplified.data(), mesh.indices.data(),
+                                          mesh.indices.size(), mesh.vertices.data(),
+                                          mesh.vertex_count(), mesh.vertex_size, 0, 1e30f,
+                                          &unbounded_error);
+  CHECK(unbounded_count < count);
+  CHECK(unbounded_error > kTargetError);
+}
+
+TEST_CASE("levels of detail respect the error bound") {
+  IndexedMesh mesh = create_torus(32);
+
+  constexpr F32 kTargetError = 0.05f;
+  MeshLods lods = generate_lods(mesh, 8, 0.5f, kTargetError);
+
+  REQUIRE(lods.levels.size() > 1);
+  for (const GeometryLod& level : lods.levels) {
+    // Errors add up across levels, so each one is bounded by the levels it was built from.
+    CHECK(level.error <= kTargetError * static_cast<F32>(lods.levels.size()));
+  }
+  CHECK(lods.levels[1].error <= kTargetError);
+}
+
+TEST_CASE("coarser levels are selected further away") {
+  MeshLods lods = generate_lods(create_torus(32), 6);
+  Geometry geometry = geometry_from_lods(lods);
+  REQUIRE(geometry.lod_count > 2);
+
+  fl::Mat4 projection = perspective();
+  fl::Size viewport{1600, 900};
+
+  U32 previous = 0;
+  for (F32 distance : {5.0f, 20.0f, 100.0f, 500.0f, 5000.0f}) {
+    fl::Mat4 model_view = fl::translation_matrix(fl::Vec3{0.0f, 0.0f, -distance});
+    U32 lod = select_lod(geometry, model_view, projection, viewport);
+    CHECK(lod >= previous);
+    previous = lod;
+  }
+  CHECK(previous == geometry.lod_count - 1);
+
+  // Inside the bounds the full detail mesh is drawn.
+  CHECK(select_lod(geometry, fl::Mat4::identity, projection, viewport) == 0);
+
+  // So is geometry without bounds.
+  geometry.bounds_radius = 0.0f;
+  fl::Mat4 far_away = fl::translation_matrix(fl::Vec3{0.0f, 0.0f, -5000.0f});
+  CHECK(select_lod(geometry, far_away, projection, viewport) == 0);
+}
+
+}  // namespace ca
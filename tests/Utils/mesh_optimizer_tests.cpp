@@ -0,0 +1,92 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/utils/mesh_optimizer.h"
+
+namespace ca {
+
+namespace {
+
+struct Vertex {
+  F32 x;
+  F32 y;
+  F32 z;
+};
+
+// Unindexed grid of `size` x `size` quads with the rows emitted in a cache hostile order.
+nu::DynamicArray<Vertex> create_grid(U32 size) {
+  nu::DynamicArray<Vertex> vertices;
+  for (U32 y = 0; y < size; ++y) {
+    for (U32 x = 0; x < size; ++x) {
+      // Alternate the column direction to make sure the input is not already optimal.
+      U32 column = (y % 2 == 0) ? x : (x * 7) % size;
+      F32 left = static_cast<F32>(column);
+      F32 top = static_cast<F32>(y);
+
+      vertices.pushBack({left, top, 0.0f});
+      vertices.pushBack({left + 1.0f, top, 0.0f});
+      vertices.pushBack({left + 1.0f, top + 1.0f, 0.0f});
+
+      vertices.pushBack({left + 1.0f, top + 1.0f, 0.0f});
+      vertices.pushBack({left, top + 1.0f, 0.0f});
+      vertices.pushBack({left, top, 0.0f});
+    }
+  }
+  return vertices;
+}
+
+}  // namespace
+
+TEST_CASE("deduplicate unindexed vertices") {
+  Vertex vertices[] = {
+      {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f},
+      {1.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 0.0f},
+  };
+
+  auto mesh = deduplicate_vertices(vertices, 6, sizeof(Vertex));
+
+  CHECK(mesh.vertex_count() == 4);
+  REQUIRE(mesh.indices.size() == 6);
+  CHECK(mesh.indices[0] == mesh.indices[5]);
+  CHECK(mesh.indices[2] == mesh.indices[3]);
+}
+
+TEST_CASE("vertex fetch optimization orders vertices by first use") {
+  Vertex vertices[] = {{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {2.0f, 0.0f, 0.0f},
+                       {3.0f, 0.0f, 0.0f}};
+  U32 indices[] = {3, 1, 2};
+
+  Vertex destination[4];
+  auto count = optimize_vertex_fetch(destination, indices, 3, vertices, 4, sizeof(Vertex));
+
+  CHECK(count == 3);
+  CHECK(indices[0] == 0);
+  CHECK(indices[1] == 1);
+  CHECK(indices[2] == 2);
+  CHECK(destination[0].x == 3.0f);
+  CHECK(destination[1].x == 1.0f);
+  CHECK(destination[2].x == 2.0f);
+}
+
+TEST_CASE("optimizing a grid improves the cache miss ratio") {
+  auto vertices = create_grid(32);
+
+  MeshOptimizationReport report;
+  auto mesh = optimize_mesh(vertices.data(), vertices.size(), sizeof(Vertex), nullptr, 0, &report);
+
+  CHECK(report.vertex_count_before == vertices.size());
+  CHECK(report.vertex_count_after == 33 * 33);
+  CHECK(mesh.indices.size() == vertices.size());
+  CHECK(report.before.acmr == Approx(3.0f));
+  CHECK(report.after.acmr < 1.0f);
+  CHECK(report.after.atvr < report.before.atvr);
+  CHECK(report.index_type == ComponentType::Unsigned16);
+}
+
+TEST_CASE("select index type") {
+  CHECK(select_index_type(100) == ComponentType::Unsigned16);
+  CHECK(select_index_type(0xfffe) == ComponentType::Unsigned16);
+  CHECK(select_index_type(0xffff) == ComponentType::Unsigned32);
+  CHECK(select_index_type(1000000) == ComponentType::Unsigned32);
+}
+
+}  // namespace ca
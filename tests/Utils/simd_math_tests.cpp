@@ -0,0 +1,73 @@
+#include <catch2/catch.hpp>
+
+#include "canvas/utils/simd_math.h"
+
+namespace ca {
+
+namespace {
+
+fl::Mat4 test_matrix() {
+  fl::Mat4 result;
+  F32* values = &result.col[0].x;
+  for (U32 i = 0; i < 16; ++i) {
+    values[i] = static_cast<F32>(i) * 0.25f - 1.0f;
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("matrix multiply matches the scalar definition") {
+  fl::Mat4 a = test_matrix();
+  fl::Mat4 b = fl::Mat4::identity;
+  b.col[3] = fl::Vec4{1.0f, 2.0f, 3.0f, 1.0f};
+
+  fl::Mat4 result;
+  multiply_mat4(a, b, &result);
+
+  const F32* lhs = &a.col[0].x;
+  const F32* rhs = &b.col[0].x;
+  const F32* values = &result.col[0].x;
+  for (U32 column = 0; column < 4; ++column) {
+    for (U32 row = 0; row < 4; ++row) {
+      F32 expected = 0.0f;
+      for (U32 k = 0; k < 4; ++k) {
+        expected += lhs[k * 4 + row] * rhs[column * 4 + k];
+      }
+      CHECK(values[column * 4 + row] == Approx(expected));
+    }
+  }
+}
+
+TEST_CASE("transform points with strides") {
+  struct Input {
+    F32 position[3];
+    U32 padding;
+  };
+  struct Output {
+    F32 position[4];
+    U32 padding;
+  };
+
+  // Not a multiple of 4 or 8, so the scalar tail runs too.
+  constexpr U32 kCount = 13;
+  Input input[kCount];
+  Output output[kCount];
+  for (U32 i = 0; i < kCount; ++i) {
+    input[i] = Input{{static_cast<F32>(i), 1.0f - static_cast<F32>(i), 2.0f}, 0};
+  }
+
+  fl::Mat4 matrix = test_matrix();
+  transform_points(matrix, input, sizeof(Input), output, sizeof(Output), kCount);
+
+  const F32* m = &matrix.col[0].x;
+  for (U32 i = 0; i < kCount; ++i) {
+    const F32* p = input[i].position;
+    for (U32 row = 0; row < 4; ++row) {
+      F32 expected = m[row] * p[0] + m[4 + row] * p[1] + m[8 + row] * p[2] + m[12 + row];
+      CHECK(output[i].position[row] == Approx(expected));
+    }
+  }
+}
+
+}  // namespace ca
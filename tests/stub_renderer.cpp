@@ -0,0 +1,162 @@
+#include "stub_renderer.h"
+
+#include "canvas/opengl.h"
+
+namespace ca {
+
+namespace {
+
+StubGlCounters g_counters;
+GLuint g_next_name = 1;
+GLint g_unpack_alignment = 4;
+
+void gen_names(GLsizei n, GLuint* names, I32* live) {
+  for (GLsizei i = 0; i < n; ++i) {
+    names[i] = g_next_name++;
+  }
+  *live += n;
+}
+
+void delete_names(GLsizei n, const GLuint* names, I32* live) {
+  // Like GL, deleting name 0 does nothing.
+  for (GLsizei i = 0; i < n; ++i) {
+    if (names[i]) {
+      --*live;
+    }
+  }
+}
+
+void APIENTRY stub_gen_buffers(GLsizei n, GLuint* names) {
+  gen_names(n, names, &g_counters.live_buffers);
+}
+
+void APIENTRY stub_delete_buffers(GLsizei n, const GLuint* names) {
+  delete_names(n, names, &g_counters.live_buffers);
+}
+
+void APIENTRY stub_gen_vertex_arrays(GLsizei n, GLuint* names) {
+  gen_names(n, names, &g_counters.live_vertex_arrays);
+}
+
+void APIENTRY stub_delete_vertex_arrays(GLsizei n, const GLuint* names) {
+  delete_names(n, names, &g_counters.live_vertex_arrays);
+}
+
+void APIENTRY stub_gen_textures(GLsizei n, GLuint* names) {
+  gen_names(n, names, &g_counters.live_textures);
+}
+
+void APIENTRY stub_delete_textures(GLsizei n, const GLuint* names) {
+  delete_names(n, names, &g_counters.live_textures);
+}
+
+void APIENTRY stub_gen_queries(GLsizei n, GLuint* names) {
+  gen_names(n, names, &g_counters.live_queries);
+}
+
+void APIENTRY stub_delete_queries(GLsizei n, const GLuint* names) {
+  delete_names(n, names, &g_counters.live_queries);
+}
+
+void APIENTRY stub_buffer_data(GLenum, GLsizeiptr, const void* data, GLenum) {
+  if (data) {
+    ++g_counters.buffer_uploads;
+  }
+}
+
+void APIENTRY stub_tex_image_2d(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum,
+                                const void*) {
+  ++g_counters.texture_uploads;
+  g_counters.tex_image_unpack_alignment = g_unpack_alignment;
+}
+
+void APIENTRY stub_tex_sub_image_2d(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum,
+                                    const void*) {
+  ++g_counters.texture_uploads;
+}
+
+void APIENTRY stub_pixel_store_i(GLenum name, GLint value) {
+  if (name == GL_UNPACK_ALIGNMENT) {
+    g_unpack_alignment = value;
+  }
+}
+
+GLenum APIENTRY stub_get_error() {
+  return GL_NO_ERROR;
+}
+
+GLuint APIENTRY stub_create_shader(GLenum) {
+  return g_next_name++;
+}
+
+GLuint APIENTRY stub_create_program() {
+  return g_next_name++;
+}
+
+// Every shader compiles and every program links.
+void APIENTRY stub_get_iv(GLuint, GLenum, GLint* value) {
+  *value = GL_TRUE;
+}
+
+void APIENTRY stub_bind(GLenum, GLuint) {}
+void APIENTRY stub_bind_vertex_array(GLuint) {}
+void APIENTRY stub_buffer_sub_data(GLenum, GLintptr, GLsizeiptr, const void*) {}
+void APIENTRY stub_vertex_attrib_pointer(GLuint, GLint, GLenum, GLboolean, GLsizei,
+                                         const void*) {}
+void APIENTRY stub_enable_vertex_attrib_array(GLuint) {}
+void APIENTRY stub_vertex_attrib_divisor(GLuint, GLuint) {}
+void APIENTRY stub_tex_parameter_i(GLenum, GLenum, GLint) {}
+void APIENTRY stub_query_counter(GLuint, GLenum) {}
+void APIENTRY stub_viewport(GLint, GLint, GLsizei, GLsizei) {}
+void APIENTRY stub_shader_source(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+void APIENTRY stub_object(GLuint) {}
+void APIENTRY stub_attach_shader(GLuint, GLuint) {}
+
+}  // namespace
+
+StubRenderer::StubRenderer() {
+  g_counters = {};
+  g_unpack_alignment = 4;
+
+  glad_glGenBuffers = stub_gen_buffers;
+  glad_glDeleteBuffers = stub_delete_buffers;
+  glad_glGenVertexArrays = stub_gen_vertex_arrays;
+  glad_glDeleteVertexArrays = stub_delete_vertex_arrays;
+  glad_glGenTextures = stub_gen_textures;
+  glad_glDeleteTextures = stub_delete_textures;
+  glad_glGenQueries = stub_gen_queries;
+  glad_glDeleteQueries = stub_delete_queries;
+  glad_glBufferData = stub_buffer_data;
+  glad_glTexImage2D = stub_tex_image_2d;
+  glad_glTexSubImage2D = stub_tex_sub_image_2d;
+  glad_glPixelStorei = stub_pixel_store_i;
+  glad_glGetError = stub_get_error;
+
+  glad_glBindBuffer = stub_bind;
+  glad_glBindTexture = stub_bind;
+  glad_glBindVertexArray = stub_bind_vertex_array;
+  glad_glBufferSubData = stub_buffer_sub_data;
+  glad_glVertexAttribPointer = stub_vertex_attrib_pointer;
+  glad_glEnableVertexAttribArray = stub_enable_vertex_attrib_array;
+  glad_glVertexAttribDivisor = stub_vertex_attrib_divisor;
+  glad_glTexParameteri = stub_tex_parameter_i;
+  glad_glQueryCounter = stub_query_counter;
+  glad_glViewport = stub_viewport;
+
+  glad_glCreateShader = stub_create_shader;
+  glad_glShaderSource = stub_shader_source;
+  glad_glCompileShader = stub_object;
+  glad_glGetShaderiv = stub_get_iv;
+  glad_glDeleteShader = stub_object;
+  glad_glCreateProgram = stub_create_program;
+  glad_glAttachShader = stub_attach_shader;
+  glad_glLinkProgram = stub_object;
+  glad_glGetProgramiv = stub_get_iv;
+  glad_glDeleteProgram = stub_object;
+}
+
+const StubGlCounters& StubRenderer::counters() const {
+  return g_counters;
+}
+
+}  // namespace ca
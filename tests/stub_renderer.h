@@ -0,0 +1,40 @@
+#pragma once
+
+#include "canvas/renderer/renderer.h"
+#include "nucleus/macros.h"
+
+namespace ca {
+
+// What the stubbed GL functions were asked to do.
+struct StubGlCounters {
+  I32 live_buffers = 0;
+  I32 live_vertex_arrays = 0;
+  I32 live_textures = 0;
+  I32 live_queries = 0;
+  // `glBufferData` calls with data and `glTexImage2D`/`glTexSubImage2D` calls.
+  U32 buffer_uploads = 0;
+  U32 texture_uploads = 0;
+  // The unpack alignment when `glTexImage2D` was last called.
+  I32 tex_image_unpack_alignment = 0;
+};
+
+// A renderer whose GL functions are replaced by stubs that only hand out object names and count
+// what is alive, so code that manages GPU resources can be tested without a context.  Only one
+// may exist at a time.
+class StubRenderer {
+public:
+  NU_DELETE_COPY_AND_MOVE(StubRenderer);
+
+  StubRenderer();
+
+  NU_NO_DISCARD Renderer* renderer() {
+    return &renderer_;
+  }
+
+  NU_NO_DISCARD const StubGlCounters& counters() const;
+
+private:
+  Renderer renderer_;
+};
+
+}  // namespace ca